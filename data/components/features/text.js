@@ -282,8 +282,9 @@ export const renderAndUpload = async () => {
     const fdBg = new FormData(); fdBg.append('image', new Blob([bufBg], {type:'application/octet-stream'}), 'bg.rgb565');
     await fetch(apiBase + '/upload_bg', { method:'POST', body: fdBg });
   }
-  // Text layer pack A8+RGB565
+  // Text layer pack: A8 coverage for solid-color text (tinted on the device), A8+RGB565 for gradients
   let outCanvas = document.createElement('canvas');
+  let solidColor = true;
   if ($('text').value.trim().length > 0) {
     const fam = getTextFontFamily(); const size = parseInt($('fontSize').value, 10);
     const xGap = parseInt($('xGap').value, 10) || 0; const font = `normal ${size}px ${fam}`; const text = $('text').value;
@@ -293,6 +294,7 @@ export const renderAndUpload = async () => {
     // Gradient or solid color
     const gradientSpec = $('textGradient').value;
     if (gradientSpec && gradientSpec !== 'none') {
+      solidColor = false;
       const gradientWidth = Math.max(20, Math.ceil(textWidth));
       let gradient;
       switch (gradientSpec) {
@@ -315,12 +317,21 @@ export const renderAndUpload = async () => {
     outCanvas.width = outW; outCanvas.height = outH; outCanvas.getContext('2d').putImageData(new ImageData(img.data, t.width, t.height), -bb.x, -bb.y);
   } else { outCanvas.width = 1; outCanvas.height = 1; }
   const out = outCanvas.getContext('2d').getImageData(0,0,outCanvas.width,outCanvas.height);
-  const outW = outCanvas.width, outH = outCanvas.height; const buf = new Uint8Array(4 + outW*outH*3);
-  buf[0]=outW&255; buf[1]=(outW>>8)&255; buf[2]=outH&255; buf[3]=(outH>>8)&255; let p=4, d=out.data;
-  for(let y=0;y<outH;y++) { for(let x=0;x<outW;x++){ const i=(y*outW+x)*4; const r=d[i], g=d[i+1], b=d[i+2], a=d[i+3]; const v=rgb565(r,g,b); buf[p++]=a; buf[p++]=v&255; buf[p++]=(v>>8)&255; }}
+  const outW = outCanvas.width, outH = outCanvas.height; let buf, p, d=out.data;
+  if (solidColor) {
+    // Versioned header: 'T','X', version 1, format 2 (A8), encoding 0, reserved, width, height
+    buf = new Uint8Array(10 + outW*outH);
+    buf.set([0x54, 0x58, 1, 2, 0, 0, outW&255, (outW>>8)&255, outH&255, (outH>>8)&255]); p=10;
+    for(let i=3;i<d.length;i+=4) buf[p++]=d[i];
+  } else {
+    buf = new Uint8Array(4 + outW*outH*3);
+    buf[0]=outW&255; buf[1]=(outW>>8)&255; buf[2]=outH&255; buf[3]=(outH>>8)&255; p=4;
+    for(let y=0;y<outH;y++) { for(let x=0;x<outW;x++){ const i=(y*outW+x)*4; const r=d[i], g=d[i+1], b=d[i+2], a=d[i+3]; const v=rgb565(r,g,b); buf[p++]=a; buf[p++]=v&255; buf[p++]=(v>>8)&255; }}
+  }
   const fd = new FormData();
   fd.append('image', new Blob([buf], {type:'application/octet-stream'}), 'img.rgb565');
   fd.append('bg', $('bg').value); fd.append('bgMode', $('bgMode').value); fd.append('offx', 0); fd.append('offy', 0);
+  fd.append('color', $('color').value);
   fd.append('animate', ( $('text').value.trim().length>0 && animate)?1:0);
   fd.append('brightness', parseInt($('brightness').value, 10)); fd.append('dir', dir); fd.append('speed', speed); fd.append('interval', interval);
   const res = await fetch(apiBase + '/upload', { method:'POST', body: fd });
@@ -99,6 +99,78 @@
 
   const rgb565 = (r, g, b) => ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | ((b) >> 3);
 
+  // Upload body with the versioned 'TX' header; PackBits-compressed per pixel when that is smaller.
+  // format: 0 = RGB565, 1 = A8+RGB565, 2 = A8 (matches include/image_upload.h on the device)
+  const UPLOAD_UNIT = [2, 3, 1, 1, 1];
+  const packBitsUnits = (raw, unit) => {
+    const n = raw.length / unit; const out = new Uint8Array(raw.length + Math.ceil(n / 128) + 1);
+    const same = (a, b) => { for (let k = 0; k < unit; k++) if (raw[a*unit+k] !== raw[b*unit+k]) return false; return true; };
+    let o = 0, i = 0;
+    while (i < n) {
+      let run = 1; while (i + run < n && run < 128 && same(i, i + run)) run++;
+      if (run >= 2) { out[o++] = 257 - run; out.set(raw.subarray(i*unit, (i+1)*unit), o); o += unit; i += run; continue; }
+      let lit = 1; while (i + lit < n && lit < 128 && !(i + lit + 1 < n && same(i + lit, i + lit + 1))) lit++;
+      out[o++] = lit - 1; out.set(raw.subarray(i*unit, (i+lit)*unit), o); o += lit * unit; i += lit;
+    }
+    return out.subarray(0, o);
+  };
+  const buildUploadBody = (format, w, h, payload) => {
+    const packed = packBitsUnits(payload, UPLOAD_UNIT[format]);
+    const useRle = packed.length < payload.length; const body = useRle ? packed : payload;
+    const buf = new Uint8Array(10 + body.length);
+    buf.set([0x54, 0x58, 1, format, useRle ? 1 : 0, 0, w & 255, (w >> 8) & 255, h & 255, (h >> 8) & 255]);
+    buf.set(body, 10);
+    return buf;
+  };
+
+  // Frame streaming for clock/timer/video/YouTube: POST /frame_delta with only the 8x8 tiles that
+  // changed since the last frame the device acknowledged; a keyframe when out of sync (409).
+  const frameStream = { seq: 0, w: 0, h: 0, last: null };
+  const FRAME_TILE = 8;
+  const streamFrame = async (canvas, resynced = false) => {
+    const w = canvas.width, h = canvas.height;
+    let out; try { out = canvas.getContext('2d').getImageData(0, 0, w, h); } catch { return; }
+    const d = out.data, px = new Uint16Array(w * h);
+    for (let i = 0, j = 0; i < px.length; i++, j += 4) px[i] = rgb565(d[j], d[j + 1], d[j + 2]);
+    const cols = Math.ceil(w / FRAME_TILE), rows = Math.ceil(h / FRAME_TILE);
+    let key = !frameStream.seq || !frameStream.last || frameStream.w !== w || frameStream.h !== h;
+    const tiles = [];
+    if (!key) {
+      for (let t = 0; t < cols * rows; t++) {
+        const x0 = (t % cols) * FRAME_TILE, y0 = Math.floor(t / cols) * FRAME_TILE;
+        const x1 = Math.min(w, x0 + FRAME_TILE), y1 = Math.min(h, y0 + FRAME_TILE);
+        let changed = false;
+        for (let y = y0; y < y1 && !changed; y++) for (let x = x0; x < x1; x++) if (px[y * w + x] !== frameStream.last[y * w + x]) { changed = true; break; }
+        if (changed) tiles.push(t);
+      }
+      if (!tiles.length) return;
+      if (tiles.length * 2 > cols * rows) key = true;  // most of the frame changed
+    }
+    const seq = (frameStream.seq % 0xFFFFFFFF) + 1;
+    const payload = key ? w * h * 2 : 2 + tiles.length * (2 + FRAME_TILE * FRAME_TILE * 2);
+    const buf = new Uint8Array(18 + payload); const dv = new DataView(buf.buffer);
+    buf.set([0x46, 0x44, 1, FRAME_TILE, key ? 1 : 0, 0]);
+    dv.setUint16(6, w, true); dv.setUint16(8, h, true); dv.setUint32(10, frameStream.seq, true); dv.setUint32(14, seq, true);
+    let p = 18;
+    if (key) { for (let i = 0; i < px.length; i++, p += 2) dv.setUint16(p, px[i], true); }
+    else {
+      dv.setUint16(p, tiles.length, true); p += 2;
+      for (const t of tiles) {
+        dv.setUint16(p, t, true); p += 2;
+        const x0 = (t % cols) * FRAME_TILE, y0 = Math.floor(t / cols) * FRAME_TILE;
+        const x1 = Math.min(w, x0 + FRAME_TILE), y1 = Math.min(h, y0 + FRAME_TILE);
+        for (let y = y0; y < y1; y++) for (let x = x0; x < x1; x++, p += 2) dv.setUint16(p, px[y * w + x], true);
+      }
+    }
+    const fd = new FormData();
+    fd.append('frame', new Blob([buf.subarray(0, p)], { type: 'application/octet-stream' }), 'frame.fd');
+    let res;
+    try { res = await fetch(apiBase + '/frame_delta', { method: 'POST', body: fd }); } catch { frameStream.seq = 0; return; }
+    if (res.ok) { frameStream.seq = seq; frameStream.w = w; frameStream.h = h; frameStream.last = px; return; }
+    frameStream.seq = 0;
+    if (res.status === 409 && !resynced) await streamFrame(canvas, true);
+  };
+
   // Preview state for clock templates
   let clockTemplatePreview = null; // { text, color, bg }
 
@@ -240,7 +312,7 @@
       const v = rgb565(r, g, b); buf[p++] = v & 255; buf[p++] = (v >> 8) & 255;
     }
     const fd = new FormData();
-    fd.append('image', new Blob([buf], { type: 'application/octet-stream' }), 'template.rgb565');
+    fd.append('image', new Blob([buildUploadBody(0, pw, ph, buf.subarray(4))], { type: 'application/octet-stream' }), 'template.rgb565');
     fd.append('bg', bg);
     fd.append('bgMode', 'color');
     fd.append('offx', 0); fd.append('offy', 0);
@@ -282,7 +354,7 @@
       const v = rgb565(r, g, b); buf[p++] = v & 255; buf[p++] = (v >> 8) & 255;
     }
     const fd = new FormData();
-    fd.append('image', new Blob([buf], { type: 'application/octet-stream' }), 'template.rgb565');
+    fd.append('image', new Blob([buildUploadBody(0, pw, ph, buf.subarray(4))], { type: 'application/octet-stream' }), 'template.rgb565');
     fd.append('bg', bg);
     fd.append('bgMode', 'color');
     fd.append('offx', 0);
@@ -597,6 +669,7 @@
     stopClockPreview();
     if (clockTimer) { cancelAnimationFrame(clockTimer); clockTimer = 0; }
     if (clockUploadTimerId) { clearTimeout(clockUploadTimerId); clockUploadTimerId = 0; }
+    clockNative = false;
     stopVideoPreview(); videoUploadActive = false; videoUploadInFlight = false;
     stopThemeTimers();
     stopClockTemplate();
@@ -1056,32 +1129,70 @@
     const cx = Math.floor((pw - totalW) / 2);
     drawTextWithGapFlat(tctx, txt, cx, yOffset, gap);
 
-    const out = tctx.getImageData(0, 0, pw, ph);
-    const buf = new Uint8Array(4 + pw * ph * 2);
-    buf[0] = pw & 255; buf[1] = (pw >> 8) & 255; buf[2] = ph & 255; buf[3] = (ph >> 8) & 255;
-    let p = 4, d = out.data;
-    for (let y = 0; y < ph; y++) for (let x = 0; x < pw; x++) {
-      const i = (y * pw + x) * 4; const r = d[i], g = d[i + 1], b = d[i + 2];
-      const v = rgb565(r, g, b);
-      buf[p++] = v & 255; buf[p++] = (v >> 8) & 255;
+    try {
+      await streamFrame(t);
+    } catch (error) {
+      console.log('Clock upload error:', error && error.message ? error.message : String(error));
     }
+  };
+
+  // Native clock: the device composes the time itself from a glyph atlas uploaded once
+  // (POST /widget, see include/clock_widget.h). Per-second frame uploads are the fallback.
+  let clockNative = false;
+  const CLOCK_GLYPHS = '0123456789:';
+  const uploadClockWidget = async () => {
+    if (activeMode !== 'clock') return false;
+    await ensureFontsLoaded();
+    const pw = 128, ph = 64;
+    const size = parseInt($('clockSize').value, 10);
+    const font = `normal ${size}px ${getTextFontFamily()}`;
+    const col = $('clockColor').value;
+    const clockBg = $('clockBgColor').value;
+    const gap = parseInt(($('clockXGap') && $('clockXGap').value) || '0', 10) || 0;
+
+    // Glyphs side by side, white on transparent; the alpha channel becomes an A8 atlas
+    const m = document.createElement('canvas').getContext('2d');
+    m.font = font;
+    const widths = [...CLOCK_GLYPHS].map(ch => Math.max(1, Math.ceil(m.measureText(ch).width) + gap));
+    const aw = widths.reduce((a, b) => a + b, 0);
+    const ah = Math.min(ph, Math.ceil(size * 1.3));
+    const t = document.createElement('canvas'); t.width = aw; t.height = ah;
+    const tctx = t.getContext('2d');
+    tctx.font = font; tctx.textBaseline = 'middle'; tctx.textAlign = 'center'; tctx.fillStyle = '#FFFFFF';
+    let x = 0;
+    [...CLOCK_GLYPHS].forEach((ch, i) => { tctx.fillText(ch, x + widths[i] / 2, Math.floor(ah / 2)); x += widths[i]; });
+    const d = tctx.getImageData(0, 0, aw, ah).data;
+    const a8 = new Uint8Array(aw * ah);
+    for (let i = 0; i < a8.length; i++) a8[i] = d[i * 4 + 3];
 
     const fd = new FormData();
-    fd.append('image', new Blob([buf], { type: 'application/octet-stream' }), 'clock.rgb565');
+    fd.append('atlas', new Blob([buildUploadBody(2, aw, ah, a8)], { type: 'application/octet-stream' }), 'atlas.a8');
+    const clockFrame = ($('clockFrameStyle') && $('clockFrameStyle').value) || 'none';
+    if (clockFrame !== 'none') {
+      const b = document.createElement('canvas'); b.width = pw; b.height = ph;
+      const bctx = b.getContext('2d');
+      bctx.fillStyle = clockBg; bctx.fillRect(0, 0, pw, ph);
+      drawFrameOnCanvas(bctx, clockFrame, col, pw, ph);
+      const px = bctx.getImageData(0, 0, pw, ph).data;
+      const raw = new Uint8Array(pw * ph * 2);
+      for (let i = 0; i < pw * ph; i++) {
+        const v = rgb565(px[i * 4], px[i * 4 + 1], px[i * 4 + 2]); raw[i * 2] = v & 255; raw[i * 2 + 1] = v >> 8;
+      }
+      fd.append('background', new Blob([buildUploadBody(0, pw, ph, raw)], { type: 'application/octet-stream' }), 'bg.rgb565');
+    }
+    fd.append('kind', 'clock');
+    fd.append('format', 'hms');
+    fd.append('glyphs', CLOCK_GLYPHS);
+    fd.append('widths', widths.join(','));
+    fd.append('color', col);
     fd.append('bg', clockBg);
-    fd.append('bgMode', 'color');
-    fd.append('offx', 0);
-    fd.append('offy', 0);
-    fd.append('animate', 0);
-    fd.append('dir', 'none');
-    fd.append('speed', 0);
-    fd.append('interval', 0);
-
+    fd.append('offy', size <= 15 ? -2 : (size <= 20 ? -1 : 0));
+    fd.append('epoch', Math.floor(Date.now() / 1000));
+    fd.append('tz', -new Date().getTimezoneOffset());
     try {
-      await fetch(apiBase + '/upload', { method: 'POST', body: fd });
-    } catch (error) {
-      console.log('Clock upload error:', error && error.message ? error.message : String(error));
-    }
+      const r = await fetch(apiBase + '/widget', { method: 'POST', body: fd });
+      return r.ok;
+    } catch { return false; }
   };
 
   // Precise upload scheduling aligned to wall-clock seconds
@@ -1089,10 +1200,14 @@
   const scheduleNextClockUpload = (immediate=false) => {
     if (clockUploadTimerId) { clearTimeout(clockUploadTimerId); clockUploadTimerId = 0; }
     if (immediate) {
-      // Fire one upload now, then schedule next at the next wall second
-      renderAndUploadClock().finally(() => scheduleNextClockUpload(false));
+      // Settings changed: re-send the atlas, or fire one upload now and schedule the next at the next wall second
+      uploadClockWidget().then(ok => {
+        clockNative = ok;
+        if (!ok) renderAndUploadClock().finally(() => scheduleNextClockUpload(false));
+      });
       return;
     }
+    if (clockNative) return;
     const now = Date.now();
     const delay = 1000 - (now % 1000) + 2; // align to next second boundary + small fudge
     clockUploadTimerId = setTimeout(async () => {
@@ -1116,8 +1231,8 @@
       }
       if (clockTimer) clockTimer = requestAnimationFrame(loop);
     };
-    // Start upload aligned to next second and preview loop
-    scheduleNextClockUpload(true);
+    // Start upload aligned to next second (unless the device runs the clock) and preview loop
+    if (!clockNative) scheduleNextClockUpload(true);
     clockTimer = requestAnimationFrame(loop);
   };
 
@@ -1181,33 +1296,12 @@
     const dy = Math.floor(ph * 0.5 - dh / 2);
     try { tctx.drawImage(videoEl, dx, dy, dw, dh); } catch { return; }
 
-    const out = tctx.getImageData(0, 0, pw, ph);
-    const buf = new Uint8Array(4 + pw * ph * 2);
-    buf[0] = pw & 255; buf[1] = (pw >> 8) & 255; buf[2] = ph & 255; buf[3] = (ph >> 8) & 255;
-    let p = 4, d = out.data;
-    for (let y = 0; y < ph; y++) for (let x = 0; x < pw; x++) {
-      const i = (y * pw + x) * 4, r = d[i], g = d[i + 1], b = d[i + 2];
-      const v = rgb565(r, g, b);
-      buf[p++] = v & 255; buf[p++] = (v >> 8) & 255;
-    }
-
-    const fd = new FormData();
-    fd.append('image', new Blob([buf], { type: 'application/octet-stream' }), 'video.rgb565');
-    fd.append('bg', bg);
-    fd.append('bgMode', 'color');
-    fd.append('offx', 0);
-    fd.append('offy', 0);
-    fd.append('animate', 0);
-    fd.append('dir', 'left');
-    fd.append('speed', 20);
-    fd.append('interval', 5);
-
     try {
       if (nonBlocking) {
         videoUploadInFlight = true;
-        fetch(apiBase + '/upload', { method: 'POST', body: fd }).finally(() => { videoUploadInFlight = false; });
+        streamFrame(t).finally(() => { videoUploadInFlight = false; });
       } else {
-        await fetch(apiBase + '/upload', { method: 'POST', body: fd });
+        await streamFrame(t);
       }
     } catch { videoUploadInFlight = false; }
   };
@@ -1387,14 +1481,14 @@
           renderTemplate1(tctx, pw, ph, Date.now());
           // Draw preview immediately
           c.width = pw; c.height = ph; ctx.drawImage(temp, 0, 0);
-          await uploadCanvasRGB565(temp, '#000000');
+          await streamFrame(temp);
           // Schedule every second updates
           clockTemplateTimer = setInterval(async () => {
             const now = Date.now();
             renderTemplate1(tctx, pw, ph, now);
             const tplPanel = document.getElementById('clockTemplatePanel');
             if (tplPanel && !tplPanel.classList.contains('hidden')) ctx.drawImage(temp, 0, 0);
-            await uploadCanvasRGB565(temp, '#000000');
+            await streamFrame(temp);
           }, 1000);
         } else if (id === 'template2') {
           clockTemplatePreview = { text: 'Template 2', color: '#00FF00', bg: '#000000' };
@@ -2484,7 +2578,8 @@
       } else if (clockMode) {
         console.log('Clock: starting clock display');
         activeMode = 'clock';
-        await renderAndUploadClock();
+        clockNative = await uploadClockWidget();
+        if (!clockNative) await renderAndUploadClock();
         if (!clockTimer) startSmoothClockTimer();
       } else if (videoMode) {
         console.log('System: refreshing system health');
@@ -2768,22 +2863,7 @@
       if (youtubeTimer) {
         const lctx = ledOffscreen.getContext('2d');
         composeYTFrame(lctx, gifOffscreen);
-        // Convert to RGB565 and upload
-        const out = lctx.getImageData(0,0,128,64);
-        const buf = new Uint8Array(4 + 128*64*2);
-        buf[0]=128&255; buf[1]=(128>>8)&255; buf[2]=64&255; buf[3]=(64>>8)&255;
-        let p=4, d=out.data; for(let y=0;y<64;y++){ for(let x=0;x<128;x++){ const i=(y*128+x)*4; const r=d[i],g=d[i+1],b=d[i+2]; const v=((r&0xF8)<<8)|((g&0xFC)<<3)|(b>>3); buf[p++]=v&255; buf[p++]=(v>>8)&255; }}
-        const fd = new FormData();
-        fd.append('image', new Blob([buf], {type:'application/octet-stream'}), 'yt.rgb565');
-        fd.append('bg', $('youtubeBgColor').value);
-        fd.append('bgMode','image');
-        fd.append('offx', 0);
-        fd.append('offy', 0);
-        fd.append('animate',0);
-        fd.append('dir','none');
-        fd.append('speed',0);
-        fd.append('interval',0);
-        fetch(apiBase + '/upload', { method:'POST', body:fd }).catch(()=>{});
+        streamFrame(ledOffscreen).catch(()=>{});
       }
       // next frame
       gifFrameIndex = (gifFrameIndex + 1) % gifFrames.length;
@@ -3285,7 +3365,7 @@
     }
 
     const fd = new FormData();
-    fd.append('image', new Blob([buf], {type:'application/octet-stream'}), 'img.rgb565');
+    fd.append('image', new Blob([buildUploadBody(1, outW, outH, buf.subarray(4))], {type:'application/octet-stream'}), 'img.rgb565');
     fd.append('bg', $('bg').value);
     const effectiveBgMode = wantFrame ? 'image' : $('bgMode').value;
     fd.append('bgMode', effectiveBgMode);
@@ -3350,7 +3430,7 @@
           const v=rgb565(r,g,b); bufBg[pb++]=v&255; bufBg[pb++]=(v>>8)&255;
         }
         const fdBg = new FormData();
-        fdBg.append('image', new Blob([bufBg], {type:'application/octet-stream'}), 'bg.rgb565');
+        fdBg.append('image', new Blob([buildUploadBody(0, pw, ph, bufBg.subarray(4))], {type:'application/octet-stream'}), 'bg.rgb565');
         promises.push(fetch(apiBase + '/upload_bg', { method:'POST', body: fdBg }));
       }
       promises.push(sendOverlay());
@@ -3371,9 +3451,17 @@
     initWifiControls();
     initPanelConfig();
     initChannelModal();
+    syncDeviceClock();
     ensureFontsLoaded().then(() => drawPreview());
   };
 
+  // Give the panel the phone's wall clock so playlist time windows work without SNTP
+  const syncDeviceClock = () => {
+    const epoch = Math.floor(Date.now() / 1000);
+    const tz = -new Date().getTimezoneOffset();
+    fetch(apiBase + `/time?epoch=${epoch}&tz=${tz}`, { method: 'POST' }).catch(() => {});
+  };
+
   const initChannelModal = () => {
     const btn = $('btnEditChannel');
     const modal = $('editChannelModal');
@@ -3813,7 +3901,7 @@
     while ((tw > pw - 8 || size > ph - 4) && size > 8) { size -= 1; tctx.font = `bold ${size}px ${fam}`; tw = tctx.measureText('Genz Timer').width; }
     tctx.fillStyle = color; tctx.fillText('Genz Timer', pw/2, ph/2);
 
-    await uploadCanvasRGB565(temp, bg);
+    await streamFrame(temp);
   }
 
   function startTimerPreview(reset=false) {
@@ -0,0 +1,87 @@
+// Run-length span index for A8 coverage masks
+// Each row of the mask is split into runs of opaque (255) and partial (1..254) pixels;
+// transparent runs are not stored at all. Blits walk the spans instead of testing every
+// pixel: transparent runs are skipped, opaque runs are memcpy'd and only partial runs
+// (anti-aliased glyph edges) go through the blend kernel.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "blend565.h"
+
+enum AlphaSpanKind : uint8_t { SPAN_OPAQUE = 0, SPAN_PARTIAL = 1 };
+
+struct AlphaSpan {
+  uint16_t x;       // first column
+  uint16_t len;     // run length in pixels
+  uint8_t kind;     // AlphaSpanKind
+};
+
+struct AlphaSpanIndex {
+  std::vector<AlphaSpan> spans;     // all rows, in row order then column order
+  std::vector<uint32_t> rowStart;   // h+1 offsets into spans
+  uint16_t inkX0 = 0, inkY0 = 0;    // bounding box of non-transparent pixels
+  uint16_t inkX1 = 0, inkY1 = 0;    // (exclusive; empty when inkX1 <= inkX0)
+
+  void clear() { spans.clear(); rowStart.clear(); inkX0 = inkY0 = inkX1 = inkY1 = 0; }
+  bool empty() const { return rowStart.empty(); }
+  const AlphaSpan* rowBegin(int y) const { return spans.data() + rowStart[y]; }
+  const AlphaSpan* rowEnd(int y) const { return spans.data() + rowStart[y + 1]; }
+};
+
+static inline void buildAlphaSpans(const uint8_t* alpha, int w, int h, AlphaSpanIndex& out) {
+  out.clear();
+  out.rowStart.reserve((size_t)h + 1);
+  int x0 = w, y0 = h, x1 = 0, y1 = 0;
+  for (int y = 0; y < h; ++y) {
+    out.rowStart.push_back((uint32_t)out.spans.size());
+    const uint8_t* row = alpha + (size_t)y * w;
+    int x = 0;
+    while (x < w) {
+      const uint8_t a = row[x];
+      if (a == 0) { ++x; continue; }
+      const uint8_t kind = (a == 255) ? SPAN_OPAQUE : SPAN_PARTIAL;
+      int end = x + 1;
+      if (kind == SPAN_OPAQUE) { while (end < w && row[end] == 255) ++end; }
+      else { while (end < w && row[end] != 0 && row[end] != 255) ++end; }
+      out.spans.push_back(AlphaSpan{(uint16_t)x, (uint16_t)(end - x), kind});
+      if (x < x0) x0 = x;
+      if (end > x1) x1 = end;
+      if (y < y0) y0 = y;
+      y1 = y + 1;
+      x = end;
+    }
+  }
+  out.rowStart.push_back((uint32_t)out.spans.size());
+  if (x1 > x0) { out.inkX0 = (uint16_t)x0; out.inkY0 = (uint16_t)y0; out.inkX1 = (uint16_t)x1; out.inkY1 = (uint16_t)y1; }
+}
+
+// Blit source columns [x0, x1) of one row. src and alpha are indexed by source column,
+// dst points at the destination pixel of source column x0.
+static inline void blitSpanRow(uint16_t* dst, const uint16_t* src, const uint8_t* alpha,
+                               const AlphaSpan* first, const AlphaSpan* last, int x0, int x1) {
+  for (const AlphaSpan* sp = first; sp != last; ++sp) {
+    int a = sp->x, b = sp->x + sp->len;
+    if (b <= x0) continue;
+    if (a >= x1) break;
+    if (a < x0) a = x0;
+    if (b > x1) b = x1;
+    if (sp->kind == SPAN_OPAQUE) memcpy(dst + (a - x0), src + a, (size_t)(b - a) * sizeof(uint16_t));
+    else blendRow565(dst + (a - x0), src + a, alpha + a, b - a);
+  }
+}
+
+// Same walk for alpha-only text: every span is tinted with one color
+static inline void blitSpanRowSolid(uint16_t* dst, uint16_t color, const uint8_t* alpha,
+                                    const AlphaSpan* first, const AlphaSpan* last, int x0, int x1) {
+  for (const AlphaSpan* sp = first; sp != last; ++sp) {
+    int a = sp->x, b = sp->x + sp->len;
+    if (b <= x0) continue;
+    if (a >= x1) break;
+    if (a < x0) a = x0;
+    if (b > x1) b = x1;
+    if (sp->kind == SPAN_OPAQUE) { for (uint16_t* d = dst + (a - x0); d != dst + (b - x0); ++d) *d = color; }
+    else blendRowSolid565(dst + (a - x0), color, alpha + a, b - a);
+  }
+}
@@ -0,0 +1,109 @@
+// Hot cache for the web UI assets
+// The bytes a static request sends (the .gz sibling or the plain file) are kept in PSRAM (the
+// bulk pixel pool) together with their content type and ETag, so repeat requests skip the
+// LittleFS open, the metadata lookups and the flash reads. An entry is keyed by path and by
+// whether the client accepted gzip, since those two clients get different bytes.
+//
+// The cache holds at most `budget` bytes of content; the least recently used entries go first
+// and files larger than a quarter of the budget are not cached. Nothing is checked against
+// flash on a hit: whoever rewrites a servable file calls invalidate() with its path or prefix.
+// All access comes from the HTTP loop (and the boot task before the server starts), so there
+// is no locking. The bytes are shared: a response still being sent keeps them alive when its
+// entry is evicted or invalidated meanwhile.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "pixel_pool.h"
+#include "snapshot_file.h"
+#include "static_assets.h"
+
+struct AssetCacheEntry {
+  std::string path;                 // request path, e.g. /components/main.js
+  bool acceptsGzip = false;         // client variant the entry answers
+  bool gzip = false;                // bytes are the .gz sibling
+  const char* contentType = "";     // static string from the content type table
+  char etag[ASSET_ETAG_LEN] = {};
+  std::shared_ptr<const BulkVector<uint8_t>> bytes;
+  uint32_t lastUse = 0;
+
+  size_t size() const { return bytes->size(); }
+};
+
+struct AssetCache {
+  size_t budget;
+  size_t used = 0;
+  uint32_t tick = 0;
+  std::vector<AssetCacheEntry> entries;
+
+  // Statistics
+  uint32_t hits = 0, misses = 0, evictions = 0, invalidations = 0;
+
+  explicit AssetCache(size_t bytes) : budget(bytes) {}
+
+  size_t maxEntryBytes() const { return budget / 4; }
+
+  const AssetCacheEntry* find(const char* path, bool acceptsGzip) {
+    for (AssetCacheEntry& e : entries) {
+      if (e.acceptsGzip == acceptsGzip && e.path == path) {
+        e.lastUse = ++tick;
+        hits++;
+        return &e;
+      }
+    }
+    misses++;
+    return nullptr;
+  }
+
+  // Take over bytes as the entry for (path, acceptsGzip); nullptr when it is too large
+  const AssetCacheEntry* insert(const char* path, bool acceptsGzip, bool gzip, const char* contentType,
+                                BulkVector<uint8_t>&& bytes) {
+    if (bytes.size() > maxEntryBytes()) return nullptr;
+    remove([&](const AssetCacheEntry& e) { return e.acceptsGzip == acceptsGzip && e.path == path; });
+    while (!entries.empty() && used + bytes.size() > budget) {
+      size_t lru = 0;
+      for (size_t i = 1; i < entries.size(); ++i) if (entries[i].lastUse < entries[lru].lastUse) lru = i;
+      used -= entries[lru].size();
+      entries.erase(entries.begin() + lru);
+      evictions++;
+    }
+    AssetCacheEntry e;
+    e.path = path;
+    e.acceptsGzip = acceptsGzip;
+    e.gzip = gzip;
+    e.contentType = contentType;
+    formatAssetEtag(e.etag, snapshotHash(SNAPSHOT_FNV_BASIS, bytes.data(), bytes.size()));
+    e.bytes = std::make_shared<const BulkVector<uint8_t>>(std::move(bytes));
+    e.lastUse = ++tick;
+    used += e.size();
+    entries.push_back(std::move(e));
+    return &entries.back();
+  }
+
+  // Drop every entry whose path starts with prefix
+  void invalidate(const char* prefix) {
+    const size_t n = strlen(prefix);
+    invalidations += remove([&](const AssetCacheEntry& e) { return e.path.compare(0, n, prefix) == 0; });
+  }
+
+  void clear() {
+    entries.clear();
+    used = 0;
+  }
+
+ private:
+  template <typename Pred> uint32_t remove(Pred pred) {
+    uint32_t n = 0;
+    for (size_t i = entries.size(); i-- > 0;) {
+      if (!pred(entries[i])) continue;
+      used -= entries[i].size();
+      entries.erase(entries.begin() + i);
+      n++;
+    }
+    return n;
+  }
+};
@@ -0,0 +1,89 @@
+// RGB565 alpha blending kernels
+// - blend565(): single pixel, out = (src*a + dst*(255-a) + 127) / 255 per 8-bit channel
+// - blendRow565(): a row of per-pixel colors with A8 coverage
+// - blendRowSolid565(): one color with A8 coverage (tinted text)
+//
+// No divisions: red and blue share one 32-bit word (two 16-bit lanes), and the blend is
+// evaluated as d*255 + (s-d)*a, which wraps correctly across the lanes because every lane of
+// the result is non-negative, so a pixel costs two multiplies instead of six. The rounded /255
+// is the exact identity floor((x + 127) / 255) == (t + (t >> 8)) >> 8 with t = x + 128, for
+// x <= 255*255. Output is bit-exact with the original scalar blend. Rows are walked four
+// pixels at a time so fully transparent and fully opaque groups skip the arithmetic; inside
+// a mixed group, pixels at 0 or 255 still skip it, as glyph edges are short runs.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// 565 -> 8-bit channels, red/blue packed as 0x00RR00BB
+static inline uint32_t expandRB565(uint16_t p) {
+  const uint32_t t = ((uint32_t)(p & 0xF800) << 5) | (p & 0x1F);   // 0x001R001B, 5-bit lanes
+  return (t << 3) | ((t >> 2) & 0x00070007);
+}
+
+static inline uint32_t expandG565(uint16_t p) {
+  uint32_t g = (p >> 3) & 0xFC; g |= g >> 6;
+  return g;
+}
+
+// Per-lane floor((x + 127) / 255) for lanes holding at most 255*255
+static inline uint32_t div255Lanes(uint32_t x) {
+  x += 0x00800080;
+  return ((x + ((x >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+}
+
+// s*a + d*(255-a) == d*255 + (s-d)*a; (s-d) may borrow across lanes, the sum does not
+static inline uint16_t blendExpanded565(uint32_t srb, uint32_t sg, uint16_t dst565, uint32_t a) {
+  const uint32_t drb = expandRB565(dst565);
+  const uint32_t dg = expandG565(dst565);
+  const uint32_t rb = div255Lanes((drb << 8) - drb + (srb - drb) * a);
+  const uint32_t g = div255Lanes((dg << 8) - dg + (sg - dg) * a);
+  return (uint16_t)(((rb >> 8) & 0xF800) | ((g & 0xFC) << 3) | ((rb & 0xFF) >> 3));
+}
+
+static inline uint16_t blend565(uint16_t src565, uint16_t dst565, uint8_t a) {
+  if (a == 0) return dst565;
+  if (a == 255) return src565;
+  return blendExpanded565(expandRB565(src565), expandG565(src565), dst565, a);
+}
+
+// One pixel of blendRowSolid565(); color is also passed expanded
+static inline uint16_t blendSolid565(uint32_t srb, uint32_t sg, uint16_t color, uint16_t dst565, uint8_t a) {
+  if (a == 0) return dst565;
+  if (a == 255) return color;
+  return blendExpanded565(srb, sg, dst565, a);
+}
+
+// dst[i] = blend(src[i], dst[i], alpha[i]) for i in [0, n)
+static inline void blendRow565(uint16_t* dst, const uint16_t* src, const uint8_t* alpha, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint32_t quad;
+    memcpy(&quad, alpha + i, sizeof(quad));
+    if (quad == 0) continue;
+    if (quad == 0xFFFFFFFFu) { memcpy(dst + i, src + i, 4 * sizeof(uint16_t)); continue; }
+    dst[i]     = blend565(src[i],     dst[i],     alpha[i]);
+    dst[i + 1] = blend565(src[i + 1], dst[i + 1], alpha[i + 1]);
+    dst[i + 2] = blend565(src[i + 2], dst[i + 2], alpha[i + 2]);
+    dst[i + 3] = blend565(src[i + 3], dst[i + 3], alpha[i + 3]);
+  }
+  for (; i < n; ++i) dst[i] = blend565(src[i], dst[i], alpha[i]);
+}
+
+// dst[i] = blend(color, dst[i], alpha[i]) for i in [0, n); color is expanded once per row
+static inline void blendRowSolid565(uint16_t* dst, uint16_t color, const uint8_t* alpha, int n) {
+  const uint32_t srb = expandRB565(color);
+  const uint32_t sg = expandG565(color);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint32_t quad;
+    memcpy(&quad, alpha + i, sizeof(quad));
+    if (quad == 0) continue;
+    if (quad == 0xFFFFFFFFu) { dst[i] = dst[i + 1] = dst[i + 2] = dst[i + 3] = color; continue; }
+    dst[i]     = blendSolid565(srb, sg, color, dst[i],     alpha[i]);
+    dst[i + 1] = blendSolid565(srb, sg, color, dst[i + 1], alpha[i + 1]);
+    dst[i + 2] = blendSolid565(srb, sg, color, dst[i + 2], alpha[i + 2]);
+    dst[i + 3] = blendSolid565(srb, sg, color, dst[i + 3], alpha[i + 3]);
+  }
+  for (; i < n; ++i) dst[i] = blendSolid565(srb, sg, color, dst[i], alpha[i]);
+}
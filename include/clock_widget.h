@@ -0,0 +1,94 @@
+// Native clock / timer widget
+// The browser renders the glyphs a time display needs ("0123456789:" in the chosen font, plus
+// optionally ' ', '-', '.', 'A', 'P', 'M') side by side into one atlas image and uploads it once
+// to /widget. The firmware then formats the time from its own clock and redraws only the cells
+// whose glyph changed, so a running clock costs one small rect push per second and no traffic.
+//
+// The atlas is any /upload image format (see image_upload.h); alpha-only atlases are tinted with
+// the widget color. `glyphs` names the atlas glyphs left to right and `widths` their pixel widths,
+// e.g. glyphs=0123456789: widths=9,6,9,9,9,9,9,9,9,9,4.
+//
+// Layout: digits and ' ' share one cell width (the widest digit) so the text does not shift as
+// digits change; other glyphs keep their own width. The row is centered on the panel.
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t WIDGET_MAX_GLYPHS = 20;
+static const uint8_t WIDGET_MAX_CELLS = 12;   // longest text: "12:34:56 PM"
+
+enum WidgetKind : uint8_t { WIDGET_CLOCK = 0, WIDGET_COUNTDOWN = 1, WIDGET_STOPWATCH = 2 };
+enum WidgetFormat : uint8_t { WIDGET_HMS = 0, WIDGET_HM = 1, WIDGET_MS = 2 };
+
+struct WidgetAtlas {
+  char glyphs[WIDGET_MAX_GLYPHS + 1] = {};
+  uint16_t x[WIDGET_MAX_GLYPHS] = {};         // left edge of each glyph in the atlas
+  uint16_t w[WIDGET_MAX_GLYPHS] = {};
+  uint16_t width = 0, height = 0;             // atlas size
+  uint16_t digitW = 0;                        // shared digit cell width
+
+  // Glyph table from the request args; the widths must add up to the atlas width
+  bool parse(const char* names, const char* widths, uint16_t atlasW, uint16_t atlasH, const char** err) {
+    const size_t n = strlen(names);
+    if (n == 0 || n > WIDGET_MAX_GLYPHS) { *err = "Bad glyph list"; return false; }
+    uint16_t pos = 0, dw = 0;
+    const char* p = widths;
+    for (size_t i = 0; i < n; ++i) {
+      char* end;
+      const long v = strtol(p, &end, 10);
+      if (end == p || v <= 0 || v > 255) { *err = "Bad glyph widths"; return false; }
+      p = *end == ',' ? end + 1 : end;
+      x[i] = pos;
+      w[i] = (uint16_t)v;
+      pos += (uint16_t)v;
+      if (names[i] >= '0' && names[i] <= '9' && v > dw) dw = (uint16_t)v;
+    }
+    if (*p || pos != atlasW) { *err = "Glyph widths do not match the atlas"; return false; }
+    if (!dw) { *err = "Atlas has no digits"; return false; }
+    memcpy(glyphs, names, n + 1);
+    width = atlasW;
+    height = atlasH;
+    digitW = dw;
+    return true;
+  }
+
+  int find(char c) const {
+    const char* p = strchr(glyphs, c);
+    return (c && p) ? (int)(p - glyphs) : -1;
+  }
+
+  // Cell width for c; characters missing from the atlas are blank cells
+  uint16_t cellWidth(char c) const {
+    if ((c >= '0' && c <= '9') || c == ' ') return digitW;
+    const int g = find(c);
+    return g < 0 ? digitW / 2 : w[g];
+  }
+};
+
+// Text for a time value: seconds of the (local) day for a clock, remaining or elapsed seconds
+// for the timers. Timers show hours only when they have any in WIDGET_HMS.
+static inline void formatWidgetTime(char* out, WidgetKind kind, WidgetFormat fmt, uint32_t seconds, bool hour12) {
+  uint32_t h = seconds / 3600, m = (seconds / 60) % 60, s = seconds % 60;
+  if (kind == WIDGET_CLOCK) {
+    h %= 24;
+    const char* suffix = "";
+    if (hour12) {
+      suffix = h < 12 ? " AM" : " PM";
+      h = h % 12 ? h % 12 : 12;
+    }
+    if (fmt == WIDGET_HM) snprintf(out, WIDGET_MAX_CELLS + 1, hour12 ? "%2u:%02u%s" : "%02u:%02u%s", (unsigned)h, (unsigned)m, suffix);
+    else snprintf(out, WIDGET_MAX_CELLS + 1, hour12 ? "%2u:%02u:%02u%s" : "%02u:%02u:%02u%s", (unsigned)h, (unsigned)m, (unsigned)s, suffix);
+    return;
+  }
+  if (fmt == WIDGET_MS || (fmt == WIDGET_HMS && h == 0)) {
+    const uint32_t mm = seconds / 60 > 99 ? 99 : seconds / 60;
+    snprintf(out, WIDGET_MAX_CELLS + 1, "%02u:%02u", (unsigned)mm, (unsigned)s);
+  } else if (fmt == WIDGET_HM) {
+    snprintf(out, WIDGET_MAX_CELLS + 1, "%02u:%02u", (unsigned)(h > 99 ? 99 : h), (unsigned)m);
+  } else {
+    snprintf(out, WIDGET_MAX_CELLS + 1, "%02u:%02u:%02u", (unsigned)(h > 99 ? 99 : h), (unsigned)m, (unsigned)s);
+  }
+}
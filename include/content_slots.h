@@ -0,0 +1,111 @@
+// Stored content slots
+// A slot is one complete piece of content: the text bitmap, an optional background image and
+// the display settings it was uploaded with. Slots live in LittleFS as /slots/<id>.bin and are
+// activated by ID without the browser re-rendering anything.
+//
+// File layout (little endian):
+//   'C' 'S' version textKind flags animDir speedPercent brightness                      (8 bytes)
+//   i16 loopOffsetPx, u16 bgColor, u16 textColor, u16 textW, u16 textH, u16 bgW, u16 bgH (14 bytes)
+//   name, NUL padded                                                                      (24 bytes)
+//   2 reserved bytes, then the text pixels (RGB565, absent for alpha-only text), the alpha
+//   plane (A8, absent for plain RGB565 text) and the background pixels (RGB565, bgW*bgH)
+// textKind uses the same values as /last_text.dat: 0 RGB565, 1 A8+RGB565, 2 A8 tinted with textColor.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+static const uint8_t CONTENT_SLOT_COUNT = 8;
+static const uint8_t CONTENT_SLOT_MAGIC0 = 'C';
+static const uint8_t CONTENT_SLOT_MAGIC1 = 'S';
+static const uint8_t CONTENT_SLOT_VERSION = 1;
+static const uint8_t CONTENT_SLOT_HEADER = 48;
+static const uint8_t CONTENT_SLOT_NAME_MAX = 24;
+
+enum ContentTextKind : uint8_t { SLOT_TEXT_RGB565 = 0, SLOT_TEXT_A8_RGB565 = 1, SLOT_TEXT_A8 = 2 };
+
+static const uint8_t SLOT_FLAG_ANIMATE = 0x01;
+static const uint8_t SLOT_FLAG_BG_IMAGE = 0x02;
+static const uint8_t SLOT_FLAG_BRIGHTNESS = 0x04;  // brightness applies; otherwise the panel keeps its own
+
+// Display settings shared by /upload and the slots
+struct ContentSettings {
+  uint16_t bgColor = 0x0000;
+  uint16_t textColor = 0xFFFF;
+  bool animate = false;
+  int8_t animDir = -1;
+  uint8_t speedPercent = 80;
+  int16_t loopOffsetPx = 5;
+  bool setBrightness = false;
+  uint8_t brightness = 200;      // 8-bit panel brightness
+  bool bgImage = false;
+};
+
+struct ContentSlotMeta {
+  ContentSettings settings;
+  uint8_t textKind = SLOT_TEXT_RGB565;
+  uint16_t textW = 0, textH = 0;
+  uint16_t bgW = 0, bgH = 0;
+  char name[CONTENT_SLOT_NAME_MAX + 1] = {};
+
+  size_t textPixelBytes() const { return textKind == SLOT_TEXT_A8 ? 0 : (size_t)textW * textH * 2; }
+  size_t alphaBytes() const { return textKind == SLOT_TEXT_RGB565 ? 0 : (size_t)textW * textH; }
+  size_t bgBytes() const { return settings.bgImage ? (size_t)bgW * bgH * 2 : 0; }
+  size_t fileBytes() const { return CONTENT_SLOT_HEADER + textPixelBytes() + alphaBytes() + bgBytes(); }
+
+  // Keep printable ASCII other than quotes and backslashes so names can go into JSON verbatim
+  void setName(const char* s) {
+    size_t n = 0;
+    for (; *s && n < CONTENT_SLOT_NAME_MAX; ++s) {
+      if (*s >= 0x20 && *s < 0x7F && *s != '"' && *s != '\\') name[n++] = *s;
+    }
+    memset(name + n, 0, sizeof(name) - n);
+  }
+
+  void encode(uint8_t out[CONTENT_SLOT_HEADER]) const {
+    memset(out, 0, CONTENT_SLOT_HEADER);
+    out[0] = CONTENT_SLOT_MAGIC0;
+    out[1] = CONTENT_SLOT_MAGIC1;
+    out[2] = CONTENT_SLOT_VERSION;
+    out[3] = textKind;
+    out[4] = (settings.animate ? SLOT_FLAG_ANIMATE : 0) | (settings.bgImage ? SLOT_FLAG_BG_IMAGE : 0) |
+             (settings.setBrightness ? SLOT_FLAG_BRIGHTNESS : 0);
+    out[5] = (uint8_t)settings.animDir;
+    out[6] = settings.speedPercent;
+    out[7] = settings.brightness;
+    put16(out + 8, (uint16_t)settings.loopOffsetPx);
+    put16(out + 10, settings.bgColor);
+    put16(out + 12, settings.textColor);
+    put16(out + 14, textW);
+    put16(out + 16, textH);
+    put16(out + 18, bgW);
+    put16(out + 20, bgH);
+    memcpy(out + 22, name, CONTENT_SLOT_NAME_MAX);
+  }
+
+  bool decode(const uint8_t in[CONTENT_SLOT_HEADER]) {
+    if (in[0] != CONTENT_SLOT_MAGIC0 || in[1] != CONTENT_SLOT_MAGIC1 || in[2] != CONTENT_SLOT_VERSION) return false;
+    if (in[3] > SLOT_TEXT_A8) return false;
+    textKind = in[3];
+    settings.animate = (in[4] & SLOT_FLAG_ANIMATE) != 0;
+    settings.bgImage = (in[4] & SLOT_FLAG_BG_IMAGE) != 0;
+    settings.setBrightness = (in[4] & SLOT_FLAG_BRIGHTNESS) != 0;
+    settings.animDir = (int8_t)in[5] < 0 ? -1 : 1;
+    settings.speedPercent = in[6];
+    settings.brightness = in[7];
+    settings.loopOffsetPx = (int16_t)get16(in + 8);
+    settings.bgColor = get16(in + 10);
+    settings.textColor = get16(in + 12);
+    textW = get16(in + 14);
+    textH = get16(in + 16);
+    bgW = get16(in + 18);
+    bgH = get16(in + 20);
+    memcpy(name, in + 22, CONTENT_SLOT_NAME_MAX);
+    name[CONTENT_SLOT_NAME_MAX] = 0;
+    return textW && textH && (!settings.bgImage || (bgW && bgH));
+  }
+
+ private:
+  static void put16(uint8_t* p, uint16_t v) { p[0] = v & 255; p[1] = v >> 8; }
+  static uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+};
@@ -0,0 +1,155 @@
+// DDP (Distributed Display Protocol) packet assembly
+// Lighting controllers send RGB data over UDP in packets carrying a byte offset into the
+// display; a packet with the push flag ends the frame. Packets are written into an RGB888
+// back buffer in whatever order they arrive and the touched rows are presented on push.
+//
+// Header, 10 bytes, big endian (14 with a timecode):
+//   flags seq type id u32 offset u16 length [u32 timecode]
+//   flags  0x40 version 1, 0x01 push, 0x02 query, 0x04 reply, 0x08 storage, 0x10 timecode
+//   seq    low 4 bits, cycles 1..15; 0 means the sender does not number packets
+//   type   0x0B RGB 8 bits per channel (0x00 and 0x01 are accepted as the same)
+//   id     1 default display, 255 all
+// A push packet that also sets the query flag asks for a reply once the frame is on the
+// panel (an extension used by tools/ddp_bench.py to measure end-to-end latency).
+//
+// Sequence numbers distinguish loss from reordering: a jump ahead counts the skipped packets
+// as lost, a packet behind the newest one is still applied if it belongs to the frame being
+// assembled (and is no longer lost), and one that predates the last push is dropped as late.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "pixel_pool.h"
+
+static const uint16_t DDP_PORT = 4048;
+static const uint8_t DDP_HEADER = 10;
+static const uint8_t DDP_VERSION_MASK = 0xC0;
+static const uint8_t DDP_VERSION_1 = 0x40;
+static const uint8_t DDP_FLAG_PUSH = 0x01;
+static const uint8_t DDP_FLAG_QUERY = 0x02;
+static const uint8_t DDP_FLAG_REPLY = 0x04;
+static const uint8_t DDP_FLAG_STORAGE = 0x08;
+static const uint8_t DDP_FLAG_TIME = 0x10;
+static const uint8_t DDP_TYPE_RGB24 = 0x0B;
+static const uint8_t DDP_ID_DISPLAY = 1;
+static const uint8_t DDP_ID_ALL = 255;
+
+enum DdpResult : uint8_t { DDP_IGNORED, DDP_APPLIED, DDP_PUSH };
+
+struct DdpReceiver {
+  BulkVector<uint8_t> back;     // RGB888, row-major over w*h
+  int w = 0, h = 0;
+  int dirtyY0 = 0, dirtyY1 = 0; // rows written since the last push, empty when equal
+  uint8_t lastSeq = 0;          // newest sequence seen, 0 = none
+  uint32_t lastCount = 0;       // packets numbered so far, i.e. lastSeq without the wrap
+  uint32_t pushCount = 0;       // lastCount at the last push
+  bool ackRequested = false;    // the last push asked for a reply
+  uint8_t ackSeq = 0;
+
+  // Counters for /perf; late also covers duplicates, ignored covers malformed and foreign packets
+  uint32_t packets = 0, frames = 0, lost = 0, late = 0, ignored = 0;
+
+  // (Re)size the back buffer; a new geometry starts from black
+  void resize(int width, int height) {
+    if (width == w && height == h) return;
+    w = width; h = height;
+    back.assign((size_t)w * h * 3, 0);
+    dirtyY0 = dirtyY1 = 0;
+  }
+
+  void resetStats() { packets = frames = lost = late = ignored = 0; }
+
+  DdpResult feed(const uint8_t* p, size_t len) {
+    packets++;
+    if (len < DDP_HEADER || (p[0] & DDP_VERSION_MASK) != DDP_VERSION_1) return ignore();
+    const uint8_t flags = p[0];
+    const uint8_t seq = p[1] & 0x0F;
+    const uint8_t type = p[2];
+    const uint8_t id = p[3];
+    if (flags & (DDP_FLAG_REPLY | DDP_FLAG_STORAGE)) return ignore();
+    if (id != DDP_ID_DISPLAY && id != DDP_ID_ALL) return ignore();
+    if (type != DDP_TYPE_RGB24 && type != 0x00 && type != 0x01) return ignore();
+    const size_t header = (flags & DDP_FLAG_TIME) ? DDP_HEADER + 4 : DDP_HEADER;
+    const uint32_t offset = ((uint32_t)p[4] << 24) | ((uint32_t)p[5] << 16) | ((uint32_t)p[6] << 8) | p[7];
+    const size_t length = ((size_t)p[8] << 8) | p[9];
+    if (len < header + length) return ignore();
+    if (!acceptSeq(seq)) { late++; return DDP_IGNORED; }
+    write(offset, p + header, length);
+    if (!(flags & DDP_FLAG_PUSH)) return DDP_APPLIED;
+    pushCount = lastCount;
+    ackRequested = (flags & DDP_FLAG_QUERY) != 0;
+    ackSeq = seq;
+    frames++;
+    return DDP_PUSH;
+  }
+
+  // Rows touched since the last call; false when nothing changed
+  bool takeDirty(int& y0, int& y1) {
+    y0 = dirtyY0; y1 = dirtyY1;
+    dirtyY0 = dirtyY1 = 0;
+    return y1 > y0;
+  }
+
+  // Convert rows [y0, y1) of the back buffer into an RGB565 frame of the same width
+  void copyRows(uint16_t* dst, int y0, int y1) const {
+    const uint8_t* s = back.data() + (size_t)y0 * w * 3;
+    uint16_t* d = dst + (size_t)y0 * w;
+    for (size_t i = (size_t)(y1 - y0) * w; i; --i, s += 3) {
+      *d++ = (uint16_t)(((s[0] & 0xF8) << 8) | ((s[1] & 0xFC) << 3) | (s[2] >> 3));
+    }
+  }
+
+  // Header-only reply acknowledging a push, offset = frames presented so far
+  void buildAck(uint8_t out[DDP_HEADER]) const {
+    out[0] = DDP_VERSION_1 | DDP_FLAG_REPLY | DDP_FLAG_PUSH;
+    out[1] = ackSeq;
+    out[2] = DDP_TYPE_RGB24;
+    out[3] = DDP_ID_DISPLAY;
+    out[4] = (uint8_t)(frames >> 24); out[5] = (uint8_t)(frames >> 16);
+    out[6] = (uint8_t)(frames >> 8);  out[7] = (uint8_t)frames;
+    out[8] = out[9] = 0;
+  }
+
+ private:
+  DdpResult ignore() { ignored++; return DDP_IGNORED; }
+
+  // Distance from a to b going forward through 1..15
+  static int ahead(uint8_t a, uint8_t b) { return (b - a + 15) % 15; }
+
+  // Sequence numbers only have 4 bits, so they are unwrapped into a running count; a frame
+  // usually spans more than 15 packets and lateness is judged against the count at the push.
+  bool acceptSeq(uint8_t seq) {
+    if (seq == 0) return true;
+    if (lastSeq == 0) {
+      lastSeq = seq;
+      lastCount = pushCount + 1;
+      return true;
+    }
+    const int d = ahead(lastSeq, seq);
+    if (d == 0) return false;                    // duplicate
+    if (d <= 7) {                                // newer: anything skipped is lost until it shows up
+      lost += d - 1;
+      lastSeq = seq;
+      lastCount += d;
+      return true;
+    }
+    // Older than the newest packet: fine if it was sent after the last push
+    if (lastCount - (uint32_t)(15 - d) <= pushCount) return false;
+    if (lost) lost--;
+    return true;
+  }
+
+  void write(uint32_t offset, const uint8_t* data, size_t length) {
+    const size_t size = back.size();
+    if (offset >= size || !length) return;
+    if (length > size - offset) length = size - offset;
+    memcpy(back.data() + offset, data, length);
+    const int rowBytes = w * 3;
+    const int y0 = (int)(offset / rowBytes);
+    const int y1 = (int)((offset + length - 1) / rowBytes) + 1;
+    if (dirtyY1 <= dirtyY0) { dirtyY0 = y0; dirtyY1 = y1; return; }
+    if (y0 < dirtyY0) dirtyY0 = y0;
+    if (y1 > dirtyY1) dirtyY1 = y1;
+  }
+};
@@ -0,0 +1,186 @@
+// WebServer-compatible front end for HttpServer (include/http_server.h)
+// The firmware's routes were written against the Arduino WebServer: void() handlers that read the
+// request through server.arg()/header()/upload() and answer with server.send(). This class keeps
+// that interface but runs on the event-driven server, so several browsers are served at once over
+// keep-alive connections and handleClient() never blocks on a slow client.
+//
+// Differences from WebServer:
+// - The response is written after the handler returns: send() records it, sendContent() appends
+//   to its body and setContentLength() is not needed (the length is known when the handler ends).
+// - The first send() of a request wins, so an upload handler can reject a file and the completion
+//   handler's "OK" is dropped instead of being appended to the error.
+// - streamFile() and sendSource() hand the body to the server, which pulls it a few KB per pass;
+//   streamFile() takes over the file, the caller must not close it.
+// - Every request header is available; collectHeaders() is not needed. CORS headers and OPTIONS
+//   preflights are answered by the server for every path.
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <WebServer.h>      // HTTPMethod, HTTPUpload and the upload status names
+#include <memory>
+#include "http_server.h"
+
+class EventWebServer {
+ public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit EventWebServer(uint16_t port) : port_(port) {}
+
+  HttpServer& http() { return http_; }
+
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn) { on(uri, method, fn, nullptr); }
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+    HttpServer::UploadHandler upload;
+    if (ufn) {
+      upload = [this, ufn](HttpRequest& req, HttpResponse& res, const HttpUploadEvent& ev) {
+        Bind bind(*this, req, res);
+        deliverUpload(ev, ufn);
+      };
+    }
+    http_.on(uri.c_str(), verbsFor(method), [this, fn](HttpRequest& req, HttpResponse& res) {
+      Bind bind(*this, req, res);
+      fn();
+    }, upload);
+  }
+  void onNotFound(THandlerFunction fn) {
+    http_.onNotFound([this, fn](HttpRequest& req, HttpResponse& res) {
+      Bind bind(*this, req, res);
+      fn();
+    });
+  }
+
+  void begin() {
+    if (!http_.begin(port_)) Serial.printf("HTTP: listen on port %u failed\n", (unsigned)port_);
+  }
+  void stop() { http_.stop(); }
+  void handleClient() { http_.poll(); }
+
+  // ---- Request (valid inside a handler) ----
+  String uri() const { return req_ ? String(req_->path.c_str()) : String(); }
+  bool hasArg(const String& name) const { return req_ && req_->arg(name.c_str()); }
+  String arg(const String& name) const {
+    const std::string* v = req_ ? req_->arg(name.c_str()) : nullptr;
+    return v ? String(v->c_str()) : String();
+  }
+  bool hasHeader(const String& name) const { return req_ && req_->header(name.c_str()); }
+  String header(const String& name) const {
+    const std::string* v = req_ ? req_->header(name.c_str()) : nullptr;
+    return v ? String(v->c_str()) : String();
+  }
+  HTTPUpload& upload() { return upload_; }
+
+  // ---- Response ----
+  void sendHeader(const String& name, const String& value, bool first = false) {
+    (void)first;
+    if (res_) res_->header(name.c_str(), value.c_str());
+  }
+  void send(int code, const char* type = nullptr, const String& content = String()) {
+    if (res_) res_->send(code, type, content.c_str(), content.length());
+  }
+  void send(int code, const char* type, const char* content) {
+    if (res_) res_->send(code, type, content, content ? strlen(content) : 0);
+  }
+  void send(int code, const String& type, const String& content) { send(code, type.c_str(), content); }
+  void send_P(int code, PGM_P type, PGM_P content) { send(code, type, content); }
+  void send_P(int code, PGM_P type, PGM_P content, size_t len) {
+    if (res_) res_->send(code, type, content, len);
+  }
+  void setContentLength(size_t) {}
+  void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+  void sendContent(const char* content, size_t len) {
+    if (res_ && res_->sent() && !res_->source) res_->body.append(content, len);
+  }
+  void sendContent_P(PGM_P content, size_t len) { sendContent(content, len); }
+
+  // Body produced over time; len -1 when unknown (sent chunked)
+  void sendSource(int code, const char* type, long long len, HttpBodySource src) {
+    if (res_) res_->stream(code, type, len, std::move(src));
+  }
+
+  // Like WebServer::streamFile, including Content-Encoding: gzip for a .gz file sent under its
+  // original type; the server owns the file from here and closes it when the body is out
+  size_t streamFile(File& file, const String& type, int code = 200) {
+    const String name = file.name();
+    if (name.endsWith(".gz") && type != "application/x-gzip" && type != "application/octet-stream") {
+      sendHeader("Content-Encoding", "gzip");
+    }
+    const size_t size = file.size();
+    std::shared_ptr<File> f = std::make_shared<File>(file);
+    file = File();
+    sendSource(code, type.c_str(), (long long)size, [f](uint8_t* buf, size_t cap) -> long {
+      const size_t n = f->read(buf, cap);
+      if (n == 0) f->close();
+      return (long)n;
+    });
+    return size;
+  }
+
+ private:
+  // Points the request accessors at the request being handled, for the duration of a callback
+  struct Bind {
+    EventWebServer& s;
+    Bind(EventWebServer& server, HttpRequest& req, HttpResponse& res) : s(server) {
+      s.req_ = &req;
+      s.res_ = &res;
+    }
+    ~Bind() {
+      s.req_ = nullptr;
+      s.res_ = nullptr;
+    }
+  };
+
+  uint16_t port_;
+  HttpServer http_;
+  HttpRequest* req_ = nullptr;
+  HttpResponse* res_ = nullptr;
+  HTTPUpload upload_;
+
+  static uint8_t verbsFor(HTTPMethod method) {
+    if (method == HTTP_ANY) return HTTP_VERB_ANY;
+    if (method == HTTP_GET) return HTTP_VERB_GET;
+    if (method == HTTP_POST) return HTTP_VERB_POST;
+    if (method == HTTP_PUT) return HTTP_VERB_PUT;
+    if (method == HTTP_DELETE) return HTTP_VERB_DELETE;
+    if (method == HTTP_OPTIONS) return HTTP_VERB_OPTIONS;
+    if (method == HTTP_HEAD) return HTTP_VERB_HEAD;
+    return 0;
+  }
+
+  // WebServer hands upload data over in HTTPUpload::buf sized pieces; keep that contract
+  void deliverUpload(const HttpUploadEvent& ev, const THandlerFunction& ufn) {
+    HTTPUpload& up = upload_;
+    switch (ev.status) {
+      case HTTP_UPLOAD_START:
+        up.status = UPLOAD_FILE_START;
+        up.name = ev.name.c_str();
+        up.filename = ev.filename.c_str();
+        up.type = ev.type.c_str();
+        up.totalSize = 0;
+        up.currentSize = 0;
+        ufn();
+        break;
+      case HTTP_UPLOAD_WRITE:
+        up.status = UPLOAD_FILE_WRITE;
+        for (size_t off = 0; off < ev.len;) {
+          const size_t n = ev.len - off < sizeof(up.buf) ? ev.len - off : sizeof(up.buf);
+          memcpy(up.buf, ev.data + off, n);
+          up.currentSize = n;
+          ufn();
+          up.totalSize += n;
+          off += n;
+        }
+        break;
+      case HTTP_UPLOAD_END:
+        up.status = UPLOAD_FILE_END;
+        up.currentSize = 0;
+        ufn();
+        break;
+      case HTTP_UPLOAD_ABORTED:
+        up.status = UPLOAD_FILE_ABORTED;
+        up.currentSize = 0;
+        ufn();
+        break;
+    }
+  }
+};
@@ -0,0 +1,195 @@
+// Streaming decoder for /frame_delta bodies
+// A client streaming whole frames (clock, timer, video) sends only the tiles that changed
+// since the frame the device is known to show, identified by a sequence number.
+//
+// Wire format (little endian):
+//   'F' 'D' version tile flags reserved u16 width u16 height u32 baseSeq u32 seq   (18 bytes)
+//   flags & FRAME_DELTA_KEYFRAME: width*height RGB565 pixels follow, row-major; baseSeq is ignored
+//   otherwise: u16 tileCount, then per tile a u16 index (row-major over ceil(width/tile) columns)
+//              followed by that tile's RGB565 pixels, row-major, clipped at the right/bottom edge
+// tile is 8 or 16. The frame is drawn centered on the target like a static /upload.
+//
+// A delta is only accepted when baseSeq matches the sequence the device last applied and the
+// geometry is unchanged; anything else is reported as needing a resync (a keyframe).
+// Pixels are written into the target as they arrive and every touched tile is recorded.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+static const uint8_t FRAME_DELTA_MAGIC0 = 'F';
+static const uint8_t FRAME_DELTA_MAGIC1 = 'D';
+static const uint8_t FRAME_DELTA_VERSION = 1;
+static const uint8_t FRAME_DELTA_HEADER = 18;
+static const uint8_t FRAME_DELTA_KEYFRAME = 0x01;
+
+// Where a stream's tiles land in the target frame
+struct FrameDeltaGrid {
+  int offX = 0, offY = 0;       // frame position of pixel (0,0)
+  int w = 0, h = 0;
+  int tile = 0, cols = 0;
+  bool operator==(const FrameDeltaGrid& o) const {
+    return offX == o.offX && offY == o.offY && w == o.w && h == o.h && tile == o.tile;
+  }
+  bool operator!=(const FrameDeltaGrid& o) const { return !(*this == o); }
+};
+
+struct FrameDeltaDecoder {
+  enum State : uint8_t { HEADER, COUNT, TILE_INDEX, PIXELS, DONE, FAILED };
+
+  // Target frame and the stream it must continue
+  uint16_t* frame = nullptr;
+  int frameW = 0, frameH = 0;
+  uint32_t expectedBase = 0;    // 0: no valid base, only keyframes are accepted
+  uint16_t expectedW = 0, expectedH = 0;
+
+  // Parsed header
+  uint8_t tile = 8;
+  bool keyframe = false;
+  uint16_t w = 0, h = 0;
+  uint32_t baseSeq = 0, seq = 0;
+  int offX = 0, offY = 0;       // frame position of pixel (0,0)
+  int cols = 0, rows = 0;       // tile grid
+
+  // Progress
+  State state = HEADER;
+  uint8_t header[FRAME_DELTA_HEADER];
+  uint8_t fill = 0;             // bytes collected of the current header/count/index field
+  uint8_t field[2];
+  uint16_t tilesLeft = 0;
+  int tileX0 = 0, tileY0 = 0, tileW = 0, tileH = 0;
+  size_t pixelIndex = 0, pixelCount = 0;
+  bool haveLow = false;
+  uint8_t low = 0;
+  bool wrote = false;           // some pixels reached the target
+  bool resync = false;          // rejected because the client is out of sync
+  const char* error = nullptr;
+  std::vector<uint16_t> dirtyTiles;
+
+  void begin(uint16_t* target, int targetW, int targetH, uint32_t base, uint16_t baseW, uint16_t baseH) {
+    frame = target; frameW = targetW; frameH = targetH;
+    expectedBase = base; expectedW = baseW; expectedH = baseH;
+    state = HEADER; fill = 0;
+    tilesLeft = 0; pixelIndex = pixelCount = 0;
+    haveLow = false; wrote = false; resync = false; error = nullptr;
+    dirtyTiles.clear();
+  }
+
+  bool feed(const uint8_t* p, size_t len) {
+    while (len) {
+      switch (state) {
+        case HEADER:
+          header[fill++] = *p++; --len;
+          if (fill == FRAME_DELTA_HEADER && !parseHeader()) return false;
+          break;
+        case COUNT:
+        case TILE_INDEX:
+          field[fill++] = *p++; --len;
+          if (fill == 2 && !fieldDone()) return false;
+          break;
+        case PIXELS: {
+          if (haveLow) { putPixel((uint16_t)low | ((uint16_t)*p++ << 8)); --len; haveLow = false; }
+          while (len >= 2 && state == PIXELS) { putPixel((uint16_t)p[0] | ((uint16_t)p[1] << 8)); p += 2; len -= 2; }
+          if (len == 1 && state == PIXELS) { low = *p++; --len; haveLow = true; }
+          break;
+        }
+        case DONE: return fail("Trailing data");
+        case FAILED: return false;
+      }
+    }
+    return true;
+  }
+
+  // Point the decoder at the target again before a chunk: the owner may have reallocated it.
+  // A target of another size fails the frame, since tiles already written went to the old one.
+  bool retarget(uint16_t* target, size_t targetPixels, int targetW, int targetH) {
+    if (state == FAILED) return false;
+    if (!target || targetW != frameW || targetH != frameH || targetPixels != (size_t)targetW * (size_t)targetH) {
+      frame = nullptr;
+      return fail("Frame resized");
+    }
+    frame = target;
+    return true;
+  }
+
+  bool finish() {
+    if (state == FAILED) return false;
+    if (state != DONE) return fail("Truncated frame");
+    return true;
+  }
+
+  FrameDeltaGrid grid() const {
+    FrameDeltaGrid g;
+    g.offX = offX; g.offY = offY; g.w = w; g.h = h; g.tile = tile; g.cols = cols;
+    return g;
+  }
+
+ private:
+  bool fail(const char* why) { state = FAILED; error = why; return false; }
+
+  static uint32_t u32(const uint8_t* b) {
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+  }
+
+  bool parseHeader() {
+    if (header[0] != FRAME_DELTA_MAGIC0 || header[1] != FRAME_DELTA_MAGIC1) return fail("Bad header");
+    if (header[2] != FRAME_DELTA_VERSION) return fail("Unsupported version");
+    tile = header[3];
+    if (tile != 8 && tile != 16) return fail("Unsupported tile size");
+    keyframe = (header[4] & FRAME_DELTA_KEYFRAME) != 0;
+    w = header[6] | (header[7] << 8);
+    h = header[8] | (header[9] << 8);
+    baseSeq = u32(header + 10);
+    seq = u32(header + 14);
+    if (w == 0 || h == 0 || w > frameW || h > frameH) return fail("Invalid size");
+    if (seq == 0) return fail("Invalid sequence");
+    if (!keyframe && (expectedBase == 0 || baseSeq != expectedBase || w != expectedW || h != expectedH)) {
+      resync = true;
+      return fail("Resync required");
+    }
+    offX = frameW / 2 - w / 2;
+    offY = frameH / 2 - h / 2;
+    cols = (w + tile - 1) / tile;
+    rows = (h + tile - 1) / tile;
+    fill = 0;
+    if (keyframe) {
+      tileX0 = tileY0 = 0; tileW = w; tileH = h;
+      pixelIndex = 0; pixelCount = (size_t)w * h;
+      state = PIXELS;
+    } else {
+      state = COUNT;
+    }
+    return true;
+  }
+
+  bool fieldDone() {
+    const uint16_t v = field[0] | (field[1] << 8);
+    fill = 0;
+    if (state == COUNT) {
+      tilesLeft = v;
+      state = tilesLeft ? TILE_INDEX : DONE;
+      return true;
+    }
+    if (v >= cols * rows) return fail("Bad tile index");
+    dirtyTiles.push_back(v);
+    tileX0 = (v % cols) * tile;
+    tileY0 = (v / cols) * tile;
+    tileW = (tileX0 + tile <= w) ? tile : w - tileX0;
+    tileH = (tileY0 + tile <= h) ? tile : h - tileY0;
+    pixelIndex = 0;
+    pixelCount = (size_t)tileW * tileH;
+    state = PIXELS;
+    return true;
+  }
+
+  void putPixel(uint16_t v) {
+    const int x = offX + tileX0 + (int)(pixelIndex % tileW);
+    const int y = offY + tileY0 + (int)(pixelIndex / tileW);
+    if (x >= 0 && y >= 0 && x < frameW && y < frameH) frame[(size_t)y * frameW + x] = v;
+    wrote = true;
+    if (++pixelIndex < pixelCount) return;
+    if (keyframe) { state = DONE; return; }
+    state = (--tilesLeft) ? TILE_INDEX : DONE;
+  }
+};
@@ -0,0 +1,849 @@
+// Event-driven HTTP/1.1 server over non-blocking BSD sockets (lwIP on the device, POSIX on a host)
+// poll() makes one pass over the listening socket and every connection and never waits: it
+// accepts what is pending, reads what has arrived, parses it incrementally and writes as much
+// of each response as the socket takes. A large file or a slow proxied stream is sent a few KB
+// per pass, so other clients and the caller's loop keep running in between.
+//
+// - Up to HTTP_MAX_CLIENTS connections; when all are taken, the longest idle keep-alive
+//   connection makes room for a new one.
+// - Keep-alive by default for HTTP/1.1 (HTTP/1.0 with Connection: keep-alive), pipelined
+//   requests are served in order.
+// - Request bodies: application/x-www-form-urlencoded and multipart text fields become args;
+//   multipart file parts are streamed to the route's upload handler as they arrive; any other
+//   body is kept whole in the "plain" arg. Chunked request bodies are refused (411).
+// - Responses: a string body, or a pull source for bodies produced over time (files, proxies);
+//   sources of unknown length go out chunked. HEAD is answered by the GET route without a body.
+// - With cors set, every response carries the CORS headers and OPTIONS is answered for any
+//   path, so routes do not register preflight handlers.
+//
+// Handlers run to completion inside poll(); anything that waits should return a pull source.
+// Upload handlers usually feed one global decoder, so one multipart upload is streamed at a time;
+// a second one waits (unread, so TCP pushes back on the client) until the first has finished.
+#pragma once
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_ESP32)
+#include <fcntl.h>
+#include <unistd.h>
+#include "lwip/sockets.h"
+#include "esp_timer.h"
+static inline uint32_t httpNowMs() { return (uint32_t)(esp_timer_get_time() / 1000); }
+#else
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+static inline uint32_t httpNowMs() {
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static const int HTTP_MAX_CLIENTS = 6;
+static const size_t HTTP_MAX_HEAD = 4096;          // request line and headers
+static const size_t HTTP_MAX_FORM = 16384;         // buffered (non-file) request bodies
+static const size_t HTTP_MAX_FIELD = 8192;         // one multipart text field
+static const size_t HTTP_IO_CHUNK = 1460;          // one TCP segment per recv/send call
+static const size_t HTTP_READ_BUDGET = 8192;       // per connection and pass
+static const size_t HTTP_WRITE_BUDGET = 16384;     // per connection and pass
+static const uint32_t HTTP_IDLE_MS = 5000;         // no progress for this long closes the connection
+static const uint16_t HTTP_KEEPALIVE_MAX = 100;    // requests per connection
+
+enum HttpVerb : uint8_t {
+  HTTP_VERB_GET = 0x01, HTTP_VERB_POST = 0x02, HTTP_VERB_PUT = 0x04, HTTP_VERB_DELETE = 0x08,
+  HTTP_VERB_OPTIONS = 0x10, HTTP_VERB_HEAD = 0x20, HTTP_VERB_PATCH = 0x40, HTTP_VERB_ANY = 0xFF,
+};
+
+static inline uint8_t httpVerbFromName(const std::string& m) {
+  static const char* const kNames[] = { "GET", "POST", "PUT", "DELETE", "OPTIONS", "HEAD", "PATCH" };
+  for (int i = 0; i < 7; ++i) if (m == kNames[i]) return (uint8_t)(1u << i);
+  return 0;
+}
+
+static inline const char* httpReason(int code) {
+  switch (code) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+static inline void httpLower(std::string& s) {
+  for (char& c : s) if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+}
+
+static inline std::string httpTrim(const std::string& s) {
+  size_t a = 0, b = s.size();
+  while (a < b && (s[a] == ' ' || s[a] == '\t')) ++a;
+  while (b > a && (s[b - 1] == ' ' || s[b - 1] == '\t' || s[b - 1] == '\r')) --b;
+  return s.substr(a, b - a);
+}
+
+static inline std::string httpUrlDecode(const char* p, size_t n) {
+  std::string out;
+  out.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (p[i] == '+') {
+      out += ' ';
+    } else if (p[i] == '%' && i + 2 < n && isxdigit((unsigned char)p[i + 1]) && isxdigit((unsigned char)p[i + 2])) {
+      const char hex[3] = { p[i + 1], p[i + 2], 0 };
+      out += (char)strtol(hex, nullptr, 16);
+      i += 2;
+    } else {
+      out += p[i];
+    }
+  }
+  return out;
+}
+
+typedef std::vector<std::pair<std::string, std::string>> HttpPairs;
+
+// name=value&... into out
+static inline void httpParseForm(const char* p, size_t n, HttpPairs& out) {
+  size_t i = 0;
+  while (i < n) {
+    size_t end = i;
+    while (end < n && p[end] != '&') ++end;
+    size_t eq = i;
+    while (eq < end && p[eq] != '=') ++eq;
+    if (end > i) {
+      out.emplace_back(httpUrlDecode(p + i, eq - i), eq < end ? httpUrlDecode(p + eq + 1, end - eq - 1) : std::string());
+    }
+    i = end + 1;
+  }
+}
+
+// Value of attr in a header like: form-data; name="file"; filename="a.bin"
+static inline std::string httpHeaderParam(const std::string& value, const char* attr) {
+  const size_t n = strlen(attr);
+  size_t i = 0;
+  while ((i = value.find(attr, i)) != std::string::npos) {
+    const bool start = i == 0 || value[i - 1] == ';' || value[i - 1] == ' ';
+    if (start && i + n < value.size() && value[i + n] == '=') {
+      size_t v = i + n + 1;
+      if (v < value.size() && value[v] == '"') {
+        const size_t close = value.find('"', v + 1);
+        return value.substr(v + 1, (close == std::string::npos ? value.size() : close) - v - 1);
+      }
+      size_t end = v;
+      while (end < value.size() && value[end] != ';' && value[end] != ' ') ++end;
+      return value.substr(v, end - v);
+    }
+    i += n;
+  }
+  return std::string();
+}
+
+struct HttpRequest {
+  uint8_t verb = 0;
+  std::string method, path, query;
+  bool http11 = true;
+  bool keepAlive = true;
+  HttpPairs headers;            // names lower case
+  HttpPairs args;               // query string, then form fields in body order
+  size_t contentLength = 0;
+  std::string contentType;      // media type only, lower case
+  std::string boundary;         // multipart boundary
+
+  const std::string* header(const char* name) const {
+    std::string key(name);
+    httpLower(key);
+    for (const auto& h : headers) if (h.first == key) return &h.second;
+    return nullptr;
+  }
+  const std::string* arg(const char* name) const {
+    for (const auto& a : args) if (a.first == name) return &a.second;
+    return nullptr;
+  }
+};
+
+enum HttpUploadStatus : uint8_t { HTTP_UPLOAD_START, HTTP_UPLOAD_WRITE, HTTP_UPLOAD_END, HTTP_UPLOAD_ABORTED };
+
+struct HttpUploadEvent {
+  HttpUploadStatus status;
+  const std::string& name;        // form field
+  const std::string& filename;
+  const std::string& type;
+  const uint8_t* data;            // WRITE only
+  size_t len;
+  size_t total;                   // bytes of this part so far
+};
+
+// Fills buf with up to cap bytes of body: > 0 bytes written, 0 at the end, < 0 nothing yet.
+// While a source has nothing yet the connection is not idle: the source owns its own timeout
+// and ends the body (returns 0) when it gives up.
+typedef std::function<long(uint8_t* buf, size_t cap)> HttpBodySource;
+
+struct HttpResponse {
+  int status = 0;                 // 0 until the handler sends
+  std::string contentType;
+  std::string headers;            // "Name: value\r\n" lines
+  std::string body;
+  HttpBodySource source;
+  long long length = -1;          // source length, -1 unknown (sent chunked)
+
+  bool sent() const { return status != 0; }
+  void header(const std::string& name, const std::string& value) { headers += name + ": " + value + "\r\n"; }
+
+  // The first send wins, as on a socket; later ones are ignored
+  void send(int code, const char* type, const char* data, size_t n) {
+    if (status) return;
+    status = code;
+    contentType = type ? type : "";
+    body.assign(data, n);
+  }
+  void send(int code, const char* type, const std::string& content) { send(code, type, content.data(), content.size()); }
+  void stream(int code, const char* type, long long len, HttpBodySource src) {
+    if (status) return;
+    status = code;
+    contentType = type ? type : "";
+    length = len;
+    source = std::move(src);
+  }
+};
+
+// Incremental multipart/form-data parser: feed() any slice of the body, callbacks fire as soon
+// as part boundaries are recognised; only a boundary's worth of bytes is held back between feeds.
+struct HttpMultipart {
+  enum State : uint8_t { PREAMBLE, AFTER_DELIM, HEADERS, BODY, DONE, FAILED };
+
+  State state = PREAMBLE;
+  std::string delim;              // "\r\n--" boundary
+  std::string pend;
+  std::string name, filename, type;
+
+  std::function<void()> onBegin;
+  std::function<void(const uint8_t*, size_t)> onData;
+  std::function<void()> onEnd;
+
+  void start(const std::string& boundary) {
+    delim = "\r\n--" + boundary;
+    pend = "\r\n";                // the first delimiter has no leading CRLF
+    state = PREAMBLE;
+  }
+
+  bool inPart() const { return state == BODY; }
+
+  bool feed(const uint8_t* data, size_t n) {
+    pend.append((const char*)data, n);
+    for (;;) {
+      switch (state) {
+        case PREAMBLE: {
+          const size_t at = pend.find(delim);
+          if (at == std::string::npos) {
+            if (pend.size() >= delim.size()) pend.erase(0, pend.size() - delim.size() + 1);
+            return true;
+          }
+          pend.erase(0, at + delim.size());
+          state = AFTER_DELIM;
+          break;
+        }
+        case AFTER_DELIM:
+          if (pend.size() < 2) return true;
+          if (pend.compare(0, 2, "--") == 0) { state = DONE; pend.clear(); return true; }
+          if (pend.compare(0, 2, "\r\n") != 0) { state = FAILED; return false; }
+          pend.erase(0, 2);
+          state = HEADERS;
+          break;
+        case HEADERS: {
+          const size_t end = pend.find("\r\n\r\n");
+          if (end == std::string::npos) {
+            if (pend.size() > HTTP_MAX_HEAD) { state = FAILED; return false; }
+            return true;
+          }
+          name.clear(); filename.clear(); type.clear();
+          size_t line = 0;
+          while (line < end) {
+            size_t eol = pend.find("\r\n", line);
+            if (eol == std::string::npos || eol > end) eol = end;
+            const size_t colon = pend.find(':', line);
+            if (colon != std::string::npos && colon < eol) {
+              std::string key = pend.substr(line, colon - line);
+              httpLower(key);
+              const std::string value = httpTrim(pend.substr(colon + 1, eol - colon - 1));
+              if (key == "content-disposition") {
+                name = httpHeaderParam(value, "name");
+                filename = httpHeaderParam(value, "filename");
+              } else if (key == "content-type") {
+                type = value;
+              }
+            }
+            line = eol + 2;
+          }
+          pend.erase(0, end + 4);
+          state = BODY;
+          if (onBegin) onBegin();
+          break;
+        }
+        case BODY: {
+          const size_t at = pend.find(delim);
+          if (at == std::string::npos) {
+            // Everything except a possible partial delimiter at the end is part data
+            if (pend.size() >= delim.size()) {
+              const size_t safe = pend.size() - delim.size() + 1;
+              if (onData) onData((const uint8_t*)pend.data(), safe);
+              pend.erase(0, safe);
+            }
+            return true;
+          }
+          if (at && onData) onData((const uint8_t*)pend.data(), at);
+          pend.erase(0, at + delim.size());
+          state = AFTER_DELIM;
+          if (onEnd) onEnd();
+          break;
+        }
+        case DONE:
+          pend.clear();
+          return true;
+        case FAILED:
+          return false;
+      }
+    }
+  }
+};
+
+class HttpServer {
+ public:
+  typedef std::function<void(HttpRequest&, HttpResponse&)> Handler;
+  typedef std::function<void(HttpRequest&, HttpResponse&, const HttpUploadEvent&)> UploadHandler;
+
+  bool cors = true;
+
+  // Statistics
+  uint32_t accepted = 0, requests = 0, reused = 0, evicted = 0, timeouts = 0, errors = 0;
+  int active = 0, peak = 0;
+
+  ~HttpServer() { stop(); }
+
+  void resetStats() {
+    accepted = requests = reused = evicted = timeouts = errors = 0;
+    peak = active;
+  }
+
+  // First registration wins for a path and verb; HEAD uses the GET route
+  void on(const char* path, uint8_t verbs, Handler h, UploadHandler u = nullptr) {
+    routes_.push_back(Route{ path, verbs, std::move(h), std::move(u) });
+  }
+  void onNotFound(Handler h) { notFound_ = std::move(h); }
+
+  bool begin(uint16_t port) {
+    if (listenFd_ >= 0) return true;
+    const int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, HTTP_MAX_CLIENTS) < 0) {
+      close(fd);
+      return false;
+    }
+    setNonBlocking(fd);
+    listenFd_ = fd;
+    return true;
+  }
+
+  void stop() {
+    for (Conn& c : conns_) drop(c);
+    if (listenFd_ >= 0) close(listenFd_);
+    listenFd_ = -1;
+  }
+
+  // Port the server listens on (useful after begin(0) on a host)
+  uint16_t port() const {
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (listenFd_ < 0 || getsockname(listenFd_, (sockaddr*)&addr, &len) < 0) return 0;
+    return ntohs(addr.sin_port);
+  }
+
+  // One non-blocking pass; returns whether any connection made progress
+  bool poll() {
+    if (listenFd_ < 0) return false;
+    bool progress = acceptPending();
+    const uint32_t now = httpNowMs();
+    for (Conn& c : conns_) {
+      if (c.fd < 0) continue;
+      bool moved = false;
+      if (c.state == Conn::READ_HEAD || c.state == Conn::READ_BODY) moved |= readSome(c);
+      if (c.fd >= 0 && c.state == Conn::WRITE) moved |= writeSome(c);
+      if (c.fd < 0) continue;
+      if (moved || waitingToUpload(c) || waitingForSource(c)) c.lastMs = now;
+      else if (now - c.lastMs > HTTP_IDLE_MS) { timeouts++; drop(c); }
+      progress |= moved;
+    }
+    return progress;
+  }
+
+ private:
+  struct Route {
+    std::string path;
+    uint8_t verbs;
+    Handler handler;
+    UploadHandler upload;
+  };
+
+  struct Conn {
+    enum State : uint8_t { READ_HEAD, READ_BODY, WRITE };
+    int fd = -1;
+    State state = READ_HEAD;
+    uint32_t lastMs = 0;
+    uint16_t served = 0;
+    std::string in;                 // received, not yet parsed
+    HttpRequest req;
+    HttpResponse res;
+    const Route* route = nullptr;
+    size_t bodyLeft = 0;
+    enum BodyKind : uint8_t { BODY_NONE, BODY_BUFFER, BODY_MULTIPART } bodyKind = BODY_NONE;
+    std::string body;               // buffered body or the current text field
+    HttpMultipart multipart;
+    size_t partTotal = 0;
+    bool bodyTooLarge = false;
+    std::string out;                // response bytes not yet sent
+    size_t outPos = 0;
+    long long sourceLeft = -1;      // declared source bytes not yet pulled, -1 unknown
+    bool chunked = false, sourceDone = true, headOnly = false;
+    bool sourcePending = false;     // the source had nothing yet on its last pull
+  };
+
+  std::vector<Route> routes_;
+  Handler notFound_;
+  int listenFd_ = -1;
+  Conn conns_[HTTP_MAX_CLIENTS];
+  Conn* uploader_ = nullptr;        // connection whose multipart body is being streamed
+
+  static void setNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  }
+
+  static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK; }
+
+  static bool streamsUpload(const Conn& c) {
+    return c.state == Conn::READ_BODY && c.bodyKind == Conn::BODY_MULTIPART && c.route && c.route->upload;
+  }
+
+  // Body must not be read yet: another connection owns the upload handlers
+  bool waitingToUpload(const Conn& c) const { return streamsUpload(c) && uploader_ && uploader_ != &c; }
+
+  // Everything queued is out and the source is producing the rest
+  static bool waitingForSource(const Conn& c) {
+    return c.state == Conn::WRITE && c.sourcePending && c.outPos == c.out.size();
+  }
+
+  // The upload handler saw a file part start that will never end; let it release what it staged
+  void abortOpenPart(Conn& c) {
+    if (c.bodyKind == Conn::BODY_MULTIPART && c.multipart.inPart() && !c.multipart.filename.empty()) {
+      upload(c, HTTP_UPLOAD_ABORTED, nullptr, 0);
+    }
+  }
+
+  void drop(Conn& c) {
+    if (c.fd < 0) return;
+    if (c.state == Conn::READ_BODY) abortOpenPart(c);
+    if (uploader_ == &c) uploader_ = nullptr;
+    close(c.fd);
+    c.fd = -1;
+    c.in.clear(); c.in.shrink_to_fit();
+    c.out.clear(); c.out.shrink_to_fit();
+    c.body.clear(); c.body.shrink_to_fit();
+    c.res = HttpResponse();
+    c.req = HttpRequest();
+    active--;
+  }
+
+  bool acceptPending() {
+    bool any = false;
+    for (;;) {
+      Conn* slot = nullptr;
+      for (Conn& c : conns_) if (c.fd < 0) { slot = &c; break; }
+      if (!slot) {
+        // Full: give the slot of the longest idle keep-alive connection to a waiting client
+        Conn* idle = nullptr;
+        for (Conn& c : conns_) {
+          if (c.state == Conn::READ_HEAD && c.in.empty() && c.served > 0 && (!idle || c.lastMs < idle->lastMs)) idle = &c;
+        }
+        if (!idle) return any;
+        sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        const int fd = accept(listenFd_, (sockaddr*)&addr, &len);
+        if (fd < 0) return any;
+        evicted++;
+        drop(*idle);
+        open(*idle, fd);
+        any = true;
+        continue;
+      }
+      sockaddr_in addr;
+      socklen_t len = sizeof(addr);
+      const int fd = accept(listenFd_, (sockaddr*)&addr, &len);
+      if (fd < 0) return any;
+      open(*slot, fd);
+      any = true;
+    }
+  }
+
+  void open(Conn& c, int fd) {
+    setNonBlocking(fd);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    c.fd = fd;
+    c.state = Conn::READ_HEAD;
+    c.lastMs = httpNowMs();
+    c.served = 0;
+    accepted++;
+    if (++active > peak) peak = active;
+  }
+
+  bool readSome(Conn& c) {
+    bool moved = false;
+    uint8_t buf[HTTP_IO_CHUNK];
+    size_t budget = HTTP_READ_BUDGET;
+    // Parse what a previous pass left over (pipelined requests) before reading more
+    if (!c.in.empty()) moved |= parse(c);
+    while (c.fd >= 0 && budget && (c.state == Conn::READ_HEAD || c.state == Conn::READ_BODY) && !waitingToUpload(c)) {
+      const long n = recv(c.fd, buf, sizeof(buf), MSG_DONTWAIT);
+      if (n == 0 || (n < 0 && !wouldBlock())) { drop(c); return true; }
+      if (n < 0) break;
+      c.in.append((const char*)buf, (size_t)n);
+      budget -= (size_t)n < budget ? (size_t)n : budget;
+      moved = true;
+      parse(c);
+    }
+    return moved;
+  }
+
+  // Consume c.in as far as the state machine allows; returns whether anything was consumed
+  bool parse(Conn& c) {
+    bool moved = false;
+    while (c.fd >= 0 && !c.in.empty()) {
+      if (c.state == Conn::READ_HEAD) {
+        const size_t end = c.in.find("\r\n\r\n");
+        if (end == std::string::npos) {
+          if (c.in.size() > HTTP_MAX_HEAD) fail(c, 431);
+          return moved;
+        }
+        const bool ok = parseHead(c, end);
+        c.in.erase(0, end + 4);
+        moved = true;
+        if (!ok) return moved;
+        startRequest(c);
+      } else if (c.state == Conn::READ_BODY) {
+        if (streamsUpload(c)) {
+          if (waitingToUpload(c)) return moved;
+          uploader_ = &c;
+        }
+        const size_t n = c.in.size() < c.bodyLeft ? c.in.size() : c.bodyLeft;
+        consumeBody(c, (const uint8_t*)c.in.data(), n);
+        c.in.erase(0, n);
+        c.bodyLeft -= n;
+        moved = true;
+        if (c.fd >= 0 && c.bodyLeft == 0 && c.state == Conn::READ_BODY) finishRequest(c);
+      } else {
+        return moved;               // next request waits until this response is out
+      }
+    }
+    return moved;
+  }
+
+  bool parseHead(Conn& c, size_t end) {
+    HttpRequest& r = c.req;
+    r = HttpRequest();
+    const size_t eol = c.in.find("\r\n");
+    const std::string line = c.in.substr(0, eol);
+    const size_t sp1 = line.find(' ');
+    const size_t sp2 = sp1 == std::string::npos ? sp1 : line.find(' ', sp1 + 1);
+    if (sp2 == std::string::npos || line.compare(sp2 + 1, 7, "HTTP/1.") != 0) { fail(c, 400); return false; }
+    r.method = line.substr(0, sp1);
+    r.verb = httpVerbFromName(r.method);
+    const std::string target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    r.http11 = line.compare(sp2 + 1, 8, "HTTP/1.1") == 0;
+    const size_t q = target.find('?');
+    r.path = httpUrlDecode(target.data(), q == std::string::npos ? target.size() : q);
+    if (q != std::string::npos) {
+      r.query = target.substr(q + 1);
+      httpParseForm(r.query.data(), r.query.size(), r.args);
+    }
+    size_t pos = eol + 2;
+    while (pos < end) {
+      size_t next = c.in.find("\r\n", pos);
+      if (next == std::string::npos || next > end) next = end;
+      const size_t colon = c.in.find(':', pos);
+      if (colon != std::string::npos && colon < next) {
+        std::string key = c.in.substr(pos, colon - pos);
+        httpLower(key);
+        r.headers.emplace_back(key, httpTrim(c.in.substr(colon + 1, next - colon - 1)));
+      }
+      pos = next + 2;
+    }
+    const std::string* conn = r.header("connection");
+    std::string connection = conn ? *conn : std::string();
+    httpLower(connection);
+    r.keepAlive = r.http11 ? connection.find("close") == std::string::npos : connection.find("keep-alive") != std::string::npos;
+    if (const std::string* te = r.header("transfer-encoding")) {
+      if (!te->empty() && *te != "identity") { fail(c, 411); return false; }
+    }
+    if (const std::string* cl = r.header("content-length")) r.contentLength = strtoul(cl->c_str(), nullptr, 10);
+    if (const std::string* ct = r.header("content-type")) {
+      r.contentType = httpTrim(ct->substr(0, ct->find(';')));
+      httpLower(r.contentType);
+      if (r.contentType == "multipart/form-data") r.boundary = httpHeaderParam(*ct, "boundary");
+    }
+    if (!r.verb) { fail(c, 501); return false; }
+    return true;
+  }
+
+  const Route* findRoute(const HttpRequest& r) const {
+    const uint8_t verb = r.verb == HTTP_VERB_HEAD ? (uint8_t)(HTTP_VERB_HEAD | HTTP_VERB_GET) : r.verb;
+    for (const Route& rt : routes_) if ((rt.verbs & verb) && rt.path == r.path) return &rt;
+    return nullptr;
+  }
+
+  void startRequest(Conn& c) {
+    HttpRequest& r = c.req;
+    c.res = HttpResponse();
+    c.route = findRoute(r);
+    c.bodyLeft = r.contentLength;
+    c.body.clear();
+    c.bodyTooLarge = false;
+    c.partTotal = 0;
+    c.bodyKind = Conn::BODY_NONE;
+    if (r.contentLength) {
+      if (r.contentType == "multipart/form-data" && !r.boundary.empty()) {
+        c.bodyKind = Conn::BODY_MULTIPART;
+        startMultipart(c);
+      } else {
+        c.bodyKind = Conn::BODY_BUFFER;
+        if (r.contentLength > HTTP_MAX_FORM) c.bodyTooLarge = true;
+        else c.body.reserve(r.contentLength);
+      }
+      if (const std::string* expect = r.header("expect")) {
+        if (*expect == "100-continue" && !c.bodyTooLarge) rawSend(c, "HTTP/1.1 100 Continue\r\n\r\n");
+      }
+    }
+    c.state = Conn::READ_BODY;
+    if (c.bodyLeft == 0) finishRequest(c);
+  }
+
+  void startMultipart(Conn& c) {
+    HttpMultipart& m = c.multipart;
+    m.start(c.req.boundary);
+    m.onBegin = [this, &c]() {
+      c.partTotal = 0;
+      c.body.clear();
+      if (!c.multipart.filename.empty()) upload(c, HTTP_UPLOAD_START, nullptr, 0);
+    };
+    m.onData = [this, &c](const uint8_t* p, size_t n) {
+      if (!c.multipart.filename.empty()) {
+        c.partTotal += n;
+        upload(c, HTTP_UPLOAD_WRITE, p, n);
+      } else if (c.body.size() + n <= HTTP_MAX_FIELD) {
+        c.body.append((const char*)p, n);
+      }
+    };
+    m.onEnd = [this, &c]() {
+      if (!c.multipart.filename.empty()) upload(c, HTTP_UPLOAD_END, nullptr, 0);
+      else c.req.args.emplace_back(c.multipart.name, c.body);
+      c.body.clear();
+    };
+  }
+
+  void upload(Conn& c, HttpUploadStatus status, const uint8_t* p, size_t n) {
+    if (!c.route || !c.route->upload) return;
+    const HttpUploadEvent ev{ status, c.multipart.name, c.multipart.filename, c.multipart.type, p, n, c.partTotal };
+    c.route->upload(c.req, c.res, ev);
+  }
+
+  void consumeBody(Conn& c, const uint8_t* p, size_t n) {
+    if (c.bodyKind == Conn::BODY_MULTIPART) {
+      if (!c.multipart.feed(p, n)) c.bodyTooLarge = true;   // malformed; answered 400 at the end
+    } else if (c.bodyKind == Conn::BODY_BUFFER && !c.bodyTooLarge) {
+      c.body.append((const char*)p, n);
+    }
+  }
+
+  void finishRequest(Conn& c) {
+    HttpRequest& r = c.req;
+    HttpResponse& res = c.res;
+    if (uploader_ == &c) uploader_ = nullptr;
+    requests++;
+    if (c.served++) reused++;
+    // A multipart body must end with its closing boundary; a truncated one never reaches the handler
+    if (c.bodyKind == Conn::BODY_MULTIPART && c.multipart.state != HttpMultipart::DONE) {
+      abortOpenPart(c);
+      c.bodyTooLarge = true;
+    }
+    if (c.bodyKind == Conn::BODY_BUFFER && !c.bodyTooLarge) {
+      if (r.contentType == "application/x-www-form-urlencoded") httpParseForm(c.body.data(), c.body.size(), r.args);
+      else r.args.emplace_back("plain", c.body);
+    }
+    c.body.clear();
+    if (c.bodyTooLarge) {
+      res.send(c.bodyKind == Conn::BODY_MULTIPART ? 400 : 413, "text/plain",
+               c.bodyKind == Conn::BODY_MULTIPART ? "Malformed multipart body" : "Request body too large");
+      r.keepAlive = false;
+    } else if (r.verb == HTTP_VERB_OPTIONS && cors && !(c.route && (c.route->verbs & HTTP_VERB_OPTIONS))) {
+      res.send(204, nullptr, std::string());
+      res.header("Access-Control-Max-Age", "600");
+    } else if (c.route) {
+      c.route->handler(r, res);
+    } else if (notFound_) {
+      notFound_(r, res);
+    }
+    if (!res.sent()) res.send(c.route || notFound_ ? 500 : 404, "text/plain", c.route || notFound_ ? "No response" : "Not found");
+    if (c.served >= HTTP_KEEPALIVE_MAX) r.keepAlive = false;
+    startResponse(c);
+  }
+
+  void startResponse(Conn& c) {
+    const HttpRequest& r = c.req;
+    HttpResponse& res = c.res;
+    const bool noBody = res.status == 204 || res.status == 304 || (res.status >= 100 && res.status < 200);
+    c.headOnly = noBody || r.verb == HTTP_VERB_HEAD;
+    c.chunked = false;
+    std::string head = std::string(r.http11 ? "HTTP/1.1 " : "HTTP/1.0 ") + std::to_string(res.status) + " " + httpReason(res.status) + "\r\n";
+    if (!res.contentType.empty()) head += "Content-Type: " + res.contentType + "\r\n";
+    if (!noBody) {
+      if (res.source && res.length < 0) {
+        if (r.http11) { c.chunked = true; head += "Transfer-Encoding: chunked\r\n"; }
+        else c.req.keepAlive = false;                 // HTTP/1.0: the end of the body is the close
+      } else {
+        head += "Content-Length: " + std::to_string(res.source ? res.length : (long long)res.body.size()) + "\r\n";
+      }
+    }
+    head += c.req.keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    if (cors) {
+      head += "Access-Control-Allow-Origin: *\r\n"
+              "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
+              "Access-Control-Allow-Headers: Content-Type\r\n";
+    }
+    head += res.headers;
+    head += "\r\n";
+    c.out.swap(head);
+    c.outPos = 0;
+    if (!c.headOnly && !res.source) c.out += res.body;
+    res.body.clear();
+    res.body.shrink_to_fit();
+    c.sourceDone = c.headOnly || !res.source;
+    c.sourceLeft = res.length;
+    c.sourcePending = false;
+    if (c.sourceDone) res.source = nullptr;
+    c.state = Conn::WRITE;
+  }
+
+  // Queue the next piece of a pulled body; false when the source has nothing yet
+  bool refill(Conn& c) {
+    uint8_t buf[HTTP_IO_CHUNK * 2];
+    size_t cap = sizeof(buf);
+    if (c.sourceLeft >= 0 && (long long)cap > c.sourceLeft) cap = (size_t)c.sourceLeft;
+    const long n = cap ? c.res.source(buf, cap) : 0;
+    c.sourcePending = n < 0;
+    if (n < 0) return false;
+    c.out.clear();
+    c.outPos = 0;
+    if (n == 0) {
+      // A body shorter than its Content-Length can only be told apart by closing
+      if (c.sourceLeft > 0) { errors++; c.req.keepAlive = false; }
+      c.sourceDone = true;
+      c.res.source = nullptr;
+      if (c.chunked) c.out = "0\r\n\r\n";
+      return !c.out.empty();
+    }
+    if (c.sourceLeft > 0) c.sourceLeft -= n;
+    if (c.chunked) {
+      char size[20];
+      snprintf(size, sizeof(size), "%lx\r\n", (unsigned long)n);
+      c.out = size;
+      c.out.append((const char*)buf, (size_t)n);
+      c.out += "\r\n";
+    } else {
+      c.out.assign((const char*)buf, (size_t)n);
+    }
+    return true;
+  }
+
+  bool writeSome(Conn& c) {
+    bool moved = false;
+    size_t budget = HTTP_WRITE_BUDGET;
+    while (budget) {
+      if (c.outPos == c.out.size()) {
+        if (c.sourceDone) break;
+        if (!refill(c)) break;
+        moved = true;
+        continue;
+      }
+      size_t n = c.out.size() - c.outPos;
+      if (n > HTTP_IO_CHUNK * 4) n = HTTP_IO_CHUNK * 4;
+      const long sent = send(c.fd, c.out.data() + c.outPos, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+      if (sent < 0) {
+        if (wouldBlock()) break;
+        errors++;
+        drop(c);
+        return true;
+      }
+      c.outPos += (size_t)sent;
+      budget -= (size_t)sent < budget ? (size_t)sent : budget;
+      moved = true;
+    }
+    if (c.outPos == c.out.size() && c.sourceDone) {
+      const bool keep = c.req.keepAlive;
+      c.out.clear();
+      c.outPos = 0;
+      c.res = HttpResponse();
+      if (!keep) { drop(c); return true; }
+      c.state = Conn::READ_HEAD;
+      if (!c.in.empty()) parse(c);               // pipelined request already buffered
+    }
+    return moved;
+  }
+
+  // Interim or error bytes that go out ahead of any response
+  void rawSend(Conn& c, const char* s) {
+    const size_t n = strlen(s);
+    const long sent = send(c.fd, s, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+    (void)sent;
+  }
+
+  void fail(Conn& c, int code) {
+    c.req.keepAlive = false;
+    c.res = HttpResponse();
+    c.res.send(code, "text/plain", httpReason(code));
+    c.state = Conn::READ_BODY;
+    c.bodyKind = Conn::BODY_NONE;
+    startResponse(c);
+  }
+};
@@ -0,0 +1,268 @@
+// Streaming decoder for /upload text images and /upload_bg backgrounds
+//
+// Legacy wire format: u16 width, u16 height (little endian), then either width*height
+// interleaved A8+RGB565 triplets [a, lo, hi] or width*height RGB565 pairs [lo, hi]; the two
+// are told apart by the total body size (backgrounds are always RGB565).
+//
+// Versioned format (v1): 10-byte header
+//   'T' 'X' version format encoding reserved u16 width u16 height
+// followed by the payload for `format`:
+//   UPLOAD_FMT_RGB565     width*height [lo, hi]
+//   UPLOAD_FMT_A8_RGB565  width*height [a, lo, hi]
+//   UPLOAD_FMT_A8         width*height coverage bytes
+//   UPLOAD_FMT_A4         rows of (width+1)/2 bytes, high nibble first
+//   UPLOAD_FMT_A1         rows of (width+7)/8 bytes, MSB first
+// Alpha-only formats leave pixels empty; the caller tints the coverage with its text color.
+// `encoding` is UPLOAD_ENC_RAW or UPLOAD_ENC_PACKBITS (see packbits.h; one unit per pixel,
+// one byte per unit for A4/A1).
+// The magic cannot collide with a legacy header: 'T' 'X' as a width is 22612 pixels.
+//
+// Bytes are de-interleaved straight into the destination vectors as chunks arrive, so the
+// request body is never buffered. Chunk boundaries may fall anywhere, including inside the
+// header or a pixel. Legacy RGB565 bodies are decoded as A8+RGB565 and repacked once in
+// finish(), since their format is only known from the final length.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "packbits.h"
+#include "pixel_pool.h"
+
+enum ImageUploadFormat : uint8_t {
+  UPLOAD_FMT_RGB565 = 0,
+  UPLOAD_FMT_A8_RGB565 = 1,
+  UPLOAD_FMT_A8 = 2,
+  UPLOAD_FMT_A4 = 3,
+  UPLOAD_FMT_A1 = 4,
+  UPLOAD_FMT_LEGACY = 0xFF,   // unversioned header, format inferred from size
+};
+
+enum ImageUploadEncoding : uint8_t {
+  UPLOAD_ENC_RAW = 0,
+  UPLOAD_ENC_PACKBITS = 1,
+};
+
+static const uint8_t IMAGE_UPLOAD_MAGIC0 = 'T';
+static const uint8_t IMAGE_UPLOAD_MAGIC1 = 'X';
+static const uint8_t IMAGE_UPLOAD_VERSION = 1;
+static const uint8_t IMAGE_UPLOAD_HEADER_V1 = 10;
+
+static inline bool uploadFormatIsAlphaOnly(uint8_t fmt) {
+  return fmt == UPLOAD_FMT_A8 || fmt == UPLOAD_FMT_A4 || fmt == UPLOAD_FMT_A1;
+}
+
+static inline const char* uploadFormatName(uint8_t fmt) {
+  switch (fmt) {
+    case UPLOAD_FMT_RGB565: return "RGB565";
+    case UPLOAD_FMT_A8_RGB565: return "A8+RGB565";
+    case UPLOAD_FMT_A8: return "A8";
+    case UPLOAD_FMT_A4: return "A4";
+    case UPLOAD_FMT_A1: return "A1";
+    default: return "legacy";
+  }
+}
+
+// Bytes per PackBits unit: one pixel, or one packed byte for A4/A1
+static inline uint8_t uploadFormatUnit(uint8_t fmt) {
+  switch (fmt) {
+    case UPLOAD_FMT_RGB565: return 2;
+    case UPLOAD_FMT_A8_RGB565: return 3;
+    default: return 1;
+  }
+}
+
+struct ImageUploadDecoder {
+  enum State : uint8_t { HEADER, PIXELS, FAILED };
+
+  BulkVector<uint16_t>* pixels = nullptr;
+  BulkVector<uint8_t>* alpha = nullptr;
+  uint16_t maxW = 0, maxH = 0;
+  uint16_t w = 0, h = 0;
+  size_t n = 0;              // w*h
+  uint8_t format = UPLOAD_FMT_LEGACY;
+  uint8_t encoding = UPLOAD_ENC_RAW;
+  bool versioned = false;    // header starts with the 'TX' magic
+  bool rgb565Only = false;   // backgrounds: no alpha formats, legacy header means RGB565
+  size_t stride = 0;         // payload bytes per row (packed formats)
+  size_t payloadBytes = 0;   // expected payload size (upper bound for legacy)
+  size_t received = 0;       // payload bytes consumed
+  uint8_t header[IMAGE_UPLOAD_HEADER_V1];
+  uint8_t headerFill = 0;
+  State state = HEADER;
+  const char* error = nullptr;  // reply text when the upload is rejected
+  PackBitsStream rle;
+
+  void begin(BulkVector<uint16_t>& px, BulkVector<uint8_t>& a, uint16_t maxWidth, uint16_t maxHeight,
+             bool onlyRgb565 = false) {
+    pixels = &px; alpha = &a;
+    maxW = maxWidth; maxH = maxHeight;
+    rgb565Only = onlyRgb565;
+    w = h = 0; n = 0;
+    format = UPLOAD_FMT_LEGACY;
+    encoding = UPLOAD_ENC_RAW;
+    versioned = false;
+    stride = payloadBytes = received = 0;
+    headerFill = 0;
+    state = HEADER;
+    error = nullptr;
+  }
+
+  // Final format once finish() succeeded (legacy resolves to RGB565 or A8+RGB565)
+  bool alphaOnly() const { return uploadFormatIsAlphaOnly(format); }
+  size_t headerBytes() const { return versioned ? IMAGE_UPLOAD_HEADER_V1 : 4; }
+
+  // Consume one chunk; returns false once the upload has been rejected
+  bool feed(const uint8_t* p, size_t len) {
+    if (state == FAILED) return false;
+    while (state == HEADER && len) {
+      header[headerFill++] = *p++; --len;
+      if (!headerByte()) return false;
+    }
+    if (!len) return true;
+    if (encoding == UPLOAD_ENC_PACKBITS) {
+      return rle.feed(p, len, [this](const uint8_t* q, size_t m) { return feedPayload(q, m); });
+    }
+    return feedPayload(p, len);
+  }
+
+  // Validate the total size at end of body; returns true when the targets hold the complete image
+  bool finish() {
+    if (state == FAILED) return false;
+    if (state == HEADER) return fail("Bad image");
+    if (encoding == UPLOAD_ENC_PACKBITS && !rle.idle()) return fail("Truncated packet");
+    if (received == payloadBytes) {
+      if (format == UPLOAD_FMT_LEGACY) format = UPLOAD_FMT_A8_RGB565;
+      return true;
+    }
+    if (format != UPLOAD_FMT_LEGACY || received != n * 2) return fail("Size mismatch");
+
+    // Raw body byte k was stored at alpha[k/3] or in the low/high byte of pixels[k/3]
+    BulkVector<uint16_t> packed(n);
+    for (size_t i = 0; i < n; ++i) packed[i] = (uint16_t)rawByte(2 * i) | ((uint16_t)rawByte(2 * i + 1) << 8);
+    pixels->swap(packed);
+    BulkVector<uint8_t>().swap(*alpha);
+    format = UPLOAD_FMT_RGB565;
+    return true;
+  }
+
+ private:
+  bool fail(const char* why) { state = FAILED; error = why; return false; }
+
+  // Decoded payload bytes, in wire order
+  bool feedPayload(const uint8_t* p, size_t len) {
+    if (len > payloadBytes - received) return fail("Size mismatch");
+    switch (format) {
+      case UPLOAD_FMT_LEGACY:
+      case UPLOAD_FMT_A8_RGB565: feedTriplets(p, len); break;
+      case UPLOAD_FMT_RGB565: feedPairs(p, len); break;
+      case UPLOAD_FMT_A8: memcpy(alpha->data() + received, p, len); break;
+      case UPLOAD_FMT_A4: feedPacked<4>(p, len); break;
+      case UPLOAD_FMT_A1: feedPacked<1>(p, len); break;
+    }
+    received += len;
+    return true;
+  }
+
+  // [a, lo, hi]: a pixel's low byte is stored as soon as it arrives, the high byte OR'd in later
+  void feedTriplets(const uint8_t* p, size_t len) {
+    uint16_t* px = pixels->data();
+    uint8_t* al = alpha->data();
+    size_t pos = received / 3;
+    unsigned phase = (unsigned)(received % 3);
+    for (; phase != 0 && len; ++p, --len) {
+      if (phase == 1) px[pos] = *p;
+      else px[pos] |= (uint16_t)*p << 8;
+      if (++phase == 3) { phase = 0; ++pos; }
+    }
+    const size_t whole = len / 3;
+    for (size_t i = 0; i < whole; ++i, p += 3) {
+      al[pos + i] = p[0];
+      px[pos + i] = (uint16_t)p[1] | ((uint16_t)p[2] << 8);
+    }
+    pos += whole;
+    len -= whole * 3;
+    for (; len; ++p, --len, ++phase) {
+      if (phase == 0) al[pos] = *p;
+      else px[pos] = *p;
+    }
+  }
+
+  // [lo, hi]
+  void feedPairs(const uint8_t* p, size_t len) {
+    uint16_t* px = pixels->data();
+    size_t pos = received / 2;
+    if ((received & 1) && len) { px[pos++] |= (uint16_t)*p++ << 8; --len; }
+    const size_t whole = len / 2;
+    for (size_t i = 0; i < whole; ++i, p += 2) px[pos + i] = (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+    if (len & 1) px[pos + whole] = *p;
+  }
+
+  // Row-aligned packed coverage, first pixel in the most significant bits
+  template <int Bits> void feedPacked(const uint8_t* p, size_t len) {
+    const int perByte = 8 / Bits;
+    const unsigned mask = (1u << Bits) - 1;
+    const unsigned scale = 255 / mask;   // 17 for A4, 255 for A1
+    uint8_t* al = alpha->data();
+    size_t row = received / stride;
+    size_t col = received % stride;
+    for (; len; ++p, --len) {
+      uint8_t* dst = al + row * w;
+      int x = (int)col * perByte;
+      const int end = (x + perByte < (int)w) ? x + perByte : (int)w;
+      for (int shift = 8 - Bits; x < end; ++x, shift -= Bits) dst[x] = (uint8_t)(((*p >> shift) & mask) * scale);
+      if (++col == stride) { col = 0; ++row; }
+    }
+  }
+
+  uint8_t rawByte(size_t k) const {
+    const size_t i = k / 3;
+    switch (k % 3) {
+      case 0: return (*alpha)[i];
+      case 1: return (uint8_t)((*pixels)[i] & 0xFF);
+      default: return (uint8_t)((*pixels)[i] >> 8);
+    }
+  }
+
+  // Drop the old buffer before growing so the previous image and the new one never coexist
+  // (the pool hands the released block straight back when it is big enough)
+  template <typename V> static void allocate(V& v, size_t count) {
+    if (v.capacity() < count) V().swap(v);
+    v.resize(count);
+  }
+
+  template <typename V> static void release(V& v) { V().swap(v); }
+
+  bool headerByte() {
+    if (headerFill == 2) versioned = header[0] == IMAGE_UPLOAD_MAGIC0 && header[1] == IMAGE_UPLOAD_MAGIC1;
+    if (headerFill < headerBytes()) return true;
+
+    if (!versioned) {
+      w = header[0] | (header[1] << 8);
+      h = header[2] | (header[3] << 8);
+      if (rgb565Only) format = UPLOAD_FMT_RGB565;
+    } else {
+      if (header[2] != IMAGE_UPLOAD_VERSION) return fail("Unsupported version");
+      if (header[3] > UPLOAD_FMT_A1 || (rgb565Only && header[3] != UPLOAD_FMT_RGB565)) return fail("Unsupported format");
+      if (header[4] > UPLOAD_ENC_PACKBITS) return fail("Unsupported encoding");
+      format = header[3];
+      encoding = header[4];
+      w = header[6] | (header[7] << 8);
+      h = header[8] | (header[9] << 8);
+    }
+    if (w == 0 || h == 0 || w > maxW || h > maxH) return fail("Invalid size");
+    n = (size_t)w * (size_t)h;
+
+    switch (format) {
+      case UPLOAD_FMT_LEGACY:
+      case UPLOAD_FMT_A8_RGB565: payloadBytes = n * 3; allocate(*pixels, n); allocate(*alpha, n); break;
+      case UPLOAD_FMT_RGB565: payloadBytes = n * 2; allocate(*pixels, n); release(*alpha); break;
+      case UPLOAD_FMT_A8: payloadBytes = n; release(*pixels); allocate(*alpha, n); break;
+      case UPLOAD_FMT_A4: stride = ((size_t)w + 1) / 2; payloadBytes = stride * h; release(*pixels); allocate(*alpha, n); break;
+      case UPLOAD_FMT_A1: stride = ((size_t)w + 7) / 8; payloadBytes = stride * h; release(*pixels); allocate(*alpha, n); break;
+    }
+    if (encoding == UPLOAD_ENC_PACKBITS) rle.begin(uploadFormatUnit(format));
+    state = PIXELS;
+    return true;
+  }
+};
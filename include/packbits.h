@@ -0,0 +1,75 @@
+// Streaming PackBits decoder over fixed-size units
+// The classic byte-oriented PackBits scheme, generalised so a "unit" is one pixel of the
+// upload format (1 byte for coverage, 2 for RGB565, 3 for A8+RGB565). Runs of identical
+// pixels therefore compress regardless of how their bytes look.
+//   control 0..127    next control+1 units are literal
+//   control 129..255  next unit is repeated 257-control times
+//   control 128       no-op
+// Input may be split anywhere; decoded bytes are handed to a sink as they become available.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+struct PackBitsStream {
+  enum Mode : uint8_t { CONTROL, LITERAL, RUN };
+
+  uint8_t unit = 1;          // bytes per unit, 1..4
+  Mode mode = CONTROL;
+  size_t remaining = 0;      // literal bytes still to pass through, or run units still to emit
+  uint8_t run[4];            // unit being repeated
+  uint8_t runFill = 0;
+
+  void begin(uint8_t unitBytes) {
+    unit = unitBytes;
+    mode = CONTROL;
+    remaining = 0;
+    runFill = 0;
+  }
+
+  // True between packets, i.e. the stream may legally end here
+  bool idle() const { return mode == CONTROL; }
+
+  // sink(const uint8_t* data, size_t len) -> bool; a false return stops decoding
+  template <typename Sink> bool feed(const uint8_t* p, size_t len, Sink&& sink) {
+    while (len) {
+      switch (mode) {
+        case CONTROL: {
+          const uint8_t c = *p++; --len;
+          if (c < 128) { mode = LITERAL; remaining = (size_t)(c + 1) * unit; }
+          else if (c > 128) { mode = RUN; remaining = 257 - c; runFill = 0; }
+          break;
+        }
+        case LITERAL: {
+          const size_t take = len < remaining ? len : remaining;
+          if (!sink(p, take)) return false;
+          p += take; len -= take;
+          if ((remaining -= take) == 0) mode = CONTROL;
+          break;
+        }
+        case RUN: {
+          while (runFill < unit && len) { run[runFill++] = *p++; --len; }
+          if (runFill < unit) break;
+          if (!emitRun(sink)) return false;
+          mode = CONTROL;
+          break;
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  template <typename Sink> bool emitRun(Sink& sink) {
+    uint8_t buf[96];                          // a whole number of units for unit sizes 1..4
+    const size_t perBuf = sizeof(buf) / unit;
+    const size_t fill = (remaining < perBuf ? remaining : perBuf);
+    for (size_t i = 0; i < fill; ++i) memcpy(buf + i * unit, run, unit);
+    while (remaining) {
+      const size_t units = remaining < perBuf ? remaining : perBuf;
+      if (!sink(buf, units * unit)) return false;
+      remaining -= units;
+    }
+    return true;
+  }
+};
@@ -0,0 +1,102 @@
+// Frame timing instrumentation
+// - perfCycles(): CPU cycle counter on device, steady clock (ns) on host
+// - PerfHistogram: fixed log-scale buckets in microseconds (4 per octave, 1 us .. ~16 s)
+//   with count/max and percentile lookup, cheap enough to record on every frame
+// - Each histogram is recorded by one task at a time; other tasks clear it with requestReset(),
+//   which the recording task carries out before its next record()
+//
+// Cycle counts are per core and wrap after ~17 s at 240 MHz, so only time short spans
+// on a single task with them.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_ESP32)
+#include "esp_idf_version.h"
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include "esp_cpu.h"
+static inline uint32_t perfCycles() { return esp_cpu_get_cycle_count(); }
+#else
+#include "hal/cpu_hal.h"
+static inline uint32_t perfCycles() { return cpu_hal_get_cycle_count(); }
+#endif
+#else
+#include <chrono>
+static inline uint32_t perfCycles() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+// Set once at boot from the CPU clock (1000 on host: perfCycles() counts ns there)
+static uint32_t gPerfCyclesPerUs = 1000;
+
+static inline uint32_t perfCyclesToUs(uint32_t cycles) { return cycles / gPerfCyclesPerUs; }
+
+struct PerfHistogram {
+  static const int kSubBits = 2;                   // 4 buckets per octave
+  static const int kBuckets = 24 << kSubBits;      // up to 2^24 us
+  uint32_t buckets[kBuckets];
+  uint32_t count;
+  uint32_t maxUs;
+  uint64_t sumUs;
+  volatile bool resetPending;
+
+  // Clears at once: only while nothing records into this histogram
+  void reset() { memset(this, 0, sizeof(*this)); }
+  // Clears from any task without tearing count/sum/max under a concurrent record()
+  void requestReset() { resetPending = true; }
+  bool empty() const { return resetPending || count == 0; }
+
+  static int bucketFor(uint32_t us) {
+    if (us < (1u << kSubBits)) return (int)us;
+    const int msb = 31 - __builtin_clz(us);
+    const int sub = (int)((us >> (msb - kSubBits)) & ((1u << kSubBits) - 1));
+    const int b = ((msb - kSubBits + 1) << kSubBits) + sub;
+    return b < kBuckets ? b : kBuckets - 1;
+  }
+
+  // Largest value that lands in bucket b
+  static uint32_t bucketUpper(int b) {
+    if (b < (1 << kSubBits)) return (uint32_t)b;
+    const int msb = (b >> kSubBits) + kSubBits - 1;
+    const uint32_t sub = (uint32_t)(b & ((1 << kSubBits) - 1));
+    const uint32_t lo = (1u << msb) | (sub << (msb - kSubBits));
+    return lo + (1u << (msb - kSubBits)) - 1;
+  }
+
+  void record(uint32_t us) {
+    if (resetPending) reset();
+    buckets[bucketFor(us)]++;
+    count++;
+    sumUs += us;
+    if (us > maxUs) maxUs = us;
+  }
+
+  void recordCycles(uint32_t cycles) { record(perfCyclesToUs(cycles)); }
+
+  // Upper bound of the bucket holding the p-th percentile (p in 0..100), clamped to max
+  uint32_t percentile(uint32_t p) const {
+    if (empty()) return 0;
+    uint64_t rank = ((uint64_t)count * p + 99) / 100;
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+      seen += buckets[b];
+      if (seen >= rank) {
+        const uint32_t v = bucketUpper(b);
+        return v < maxUs ? v : maxUs;
+      }
+    }
+    return maxUs;
+  }
+};
+
+// Times a scope into a histogram
+struct PerfScope {
+  PerfHistogram& h;
+  uint32_t start;
+  explicit PerfScope(PerfHistogram& hist) : h(hist), start(perfCycles()) {}
+  ~PerfScope() { h.recordCycles(perfCycles() - start); }
+};
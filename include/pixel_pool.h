@@ -0,0 +1,181 @@
+// Placement-aware pooled allocator for pixel buffers
+// Two pools with a fixed placement policy:
+//   POOL_HOT   internal SRAM: buffers touched on every frame (frameBuffer, the marquee strip)
+//   POOL_BULK  PSRAM: content that is decoded or restored once and read rarely
+// If the preferred memory is exhausted a pool falls back to the other kind and counts it.
+//
+// Large blocks released by a pool's vectors are kept in a small per-pool cache and handed
+// back to the next request of a similar size, so an upload cycle (release old image, decode
+// new one) reuses the same block instead of returning it to the heap and fragmenting it.
+// Every block carries a 16-byte header with its size and whether it came from the fallback;
+// fallback blocks are never cached so the pool drifts back to its preferred memory.
+//
+// PoolAllocator<T, pool> plugs the pools into std::vector; HotVector<T> and BulkVector<T>
+// are the aliases used for pixel storage.
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_ESP32)
+#include "esp_heap_caps.h"
+static const uint32_t PIXEL_POOL_CAPS_INTERNAL = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+static const uint32_t PIXEL_POOL_CAPS_PSRAM = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+static inline void* pixelPoolRawAlloc(size_t bytes, uint32_t caps) { return heap_caps_malloc(bytes, caps); }
+static inline void pixelPoolRawFree(void* p) { heap_caps_free(p); }
+#else
+static const uint32_t PIXEL_POOL_CAPS_INTERNAL = 1;
+static const uint32_t PIXEL_POOL_CAPS_PSRAM = 2;
+static inline void* pixelPoolRawAlloc(size_t bytes, uint32_t) { return malloc(bytes); }
+static inline void pixelPoolRawFree(void* p) { free(p); }
+#endif
+
+enum PixelPoolId : uint8_t { POOL_HOT = 0, POOL_BULK = 1, POOL_COUNT = 2 };
+
+struct PixelPool {
+  static const int kSlots = 4;                // cached free blocks per pool
+  static const size_t kMinCached = 1024;      // smaller blocks go straight back to the heap
+  static const size_t kHeader = 16;           // keeps the payload 16-byte aligned
+
+  struct Block { void* raw; size_t bytes; };  // bytes = usable size after the header
+
+  const char* name;
+  uint32_t caps, fallbackCaps;
+  int maxCached;                              // slots actually used; internal SRAM caches less
+  Block cache[kSlots] = {};
+  int cached = 0;
+  std::mutex lock;
+
+  // Statistics, in bytes of payload
+  size_t inUse = 0, highWater = 0, cachedBytes = 0;
+  uint32_t allocs = 0, reuses = 0, fallbacks = 0, failures = 0;
+
+  PixelPool(const char* n, uint32_t c, uint32_t fc, int slots) : name(n), caps(c), fallbackCaps(fc), maxCached(slots) {}
+
+  void* allocate(size_t bytes) {
+    {
+      std::lock_guard<std::mutex> g(lock);
+      allocs++;
+      // Best fit among cached blocks no more than twice the request
+      int best = -1;
+      for (int i = 0; i < cached; ++i) {
+        if (cache[i].bytes >= bytes && cache[i].bytes / 2 <= bytes && (best < 0 || cache[i].bytes < cache[best].bytes)) best = i;
+      }
+      if (best >= 0) {
+        Block b = cache[best];
+        cache[best] = cache[--cached];
+        cachedBytes -= b.bytes;
+        reuses++;
+        track(b.bytes);
+        return (uint8_t*)b.raw + kHeader;
+      }
+    }
+    void* raw = pixelPoolRawAlloc(bytes + kHeader, caps);
+    if (!raw) {
+      trim();                                 // cached blocks may be what is in the way
+      raw = pixelPoolRawAlloc(bytes + kHeader, caps);
+    }
+    bool fellBack = false;
+    if (!raw) {
+      raw = pixelPoolRawAlloc(bytes + kHeader, fallbackCaps);
+      fellBack = raw != nullptr;
+    }
+    std::lock_guard<std::mutex> g(lock);
+    if (!raw) { failures++; return nullptr; }
+    if (fellBack) fallbacks++;
+    memcpy(raw, &bytes, sizeof(bytes));
+    ((uint8_t*)raw)[sizeof(size_t)] = fellBack;
+    track(bytes);
+    return (uint8_t*)raw + kHeader;
+  }
+
+  void release(void* p) {
+    if (!p) return;
+    void* raw = (uint8_t*)p - kHeader;
+    size_t bytes;
+    memcpy(&bytes, raw, sizeof(bytes));
+    const bool fellBack = ((uint8_t*)raw)[sizeof(size_t)] != 0;
+    void* evict = nullptr;
+    {
+      std::lock_guard<std::mutex> g(lock);
+      inUse -= bytes;
+      if (bytes < kMinCached || maxCached == 0 || fellBack) {
+        evict = raw;
+      } else {
+        if (cached == maxCached) {
+          // Keep the larger blocks: drop the smallest cached one if it is smaller than this
+          int smallest = 0;
+          for (int i = 1; i < cached; ++i) if (cache[i].bytes < cache[smallest].bytes) smallest = i;
+          if (cache[smallest].bytes >= bytes) {
+            evict = raw;
+            raw = nullptr;
+          } else {
+            evict = cache[smallest].raw;
+            cachedBytes -= cache[smallest].bytes;
+            cache[smallest] = cache[--cached];
+          }
+        }
+        if (raw) {
+          cache[cached++] = Block{ raw, bytes };
+          cachedBytes += bytes;
+        }
+      }
+    }
+    if (evict) pixelPoolRawFree(evict);
+  }
+
+  // Return every cached block to the heap
+  void trim() {
+    Block drop[kSlots];
+    int n;
+    {
+      std::lock_guard<std::mutex> g(lock);
+      n = cached;
+      memcpy(drop, cache, sizeof(Block) * n);
+      cached = 0;
+      cachedBytes = 0;
+    }
+    for (int i = 0; i < n; ++i) pixelPoolRawFree(drop[i].raw);
+  }
+
+ private:
+  void track(size_t bytes) {
+    inUse += bytes;
+    if (inUse > highWater) highWater = inUse;
+  }
+};
+
+// Never destroyed: static vectors may still release into their pool during shutdown
+static inline PixelPool& pixelPool(PixelPoolId id) {
+  static PixelPool* pools = new PixelPool[POOL_COUNT]{
+    { "hot", PIXEL_POOL_CAPS_INTERNAL, PIXEL_POOL_CAPS_PSRAM, 1 },
+    { "bulk", PIXEL_POOL_CAPS_PSRAM, PIXEL_POOL_CAPS_INTERNAL, PixelPool::kSlots },
+  };
+  return pools[id];
+}
+
+template <typename T, PixelPoolId Pool>
+struct PoolAllocator {
+  typedef T value_type;
+  template <typename U> struct rebind { typedef PoolAllocator<U, Pool> other; };
+
+  PoolAllocator() noexcept {}
+  template <typename U> PoolAllocator(const PoolAllocator<U, Pool>&) noexcept {}
+
+  T* allocate(size_t n) {
+    void* p = pixelPool(Pool).allocate(n * sizeof(T));
+    if (!p) throw std::bad_alloc();
+    return static_cast<T*>(p);
+  }
+  void deallocate(T* p, size_t) noexcept { pixelPool(Pool).release(p); }
+
+  template <typename U> bool operator==(const PoolAllocator<U, Pool>&) const noexcept { return true; }
+  template <typename U> bool operator!=(const PoolAllocator<U, Pool>&) const noexcept { return false; }
+};
+
+template <typename T> using HotVector = std::vector<T, PoolAllocator<T, POOL_HOT>>;
+template <typename T> using BulkVector = std::vector<T, PoolAllocator<T, POOL_BULK>>;
@@ -0,0 +1,122 @@
+// Playlist of content slots
+// Entries are shown in order or picked by weight; each stays up for a dwell time or for a
+// number of marquee cycles, and may be limited to a time-of-day window.
+//
+// Text form, as accepted by POST /playlist and stored in /playlist.txt, one entry per ';':
+//   slot,dwellMs,cycles,weight,startMin,endMin
+// Trailing fields may be omitted (dwell 0, cycles 0, weight 1, no window). cycles > 0 ends the
+// entry after that many scroll periods of animated text; otherwise dwellMs applies (0 means
+// PLAYLIST_DEFAULT_DWELL_MS). The window is [startMin, endMin) in local minutes of the day and
+// wraps past midnight when start > end; start == end means always.
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const uint8_t PLAYLIST_MAX_ENTRIES = 32;
+static const uint32_t PLAYLIST_DEFAULT_DWELL_MS = 10000;
+
+struct PlaylistEntry {
+  uint8_t slot = 0;
+  uint32_t dwellMs = 0;
+  uint16_t cycles = 0;
+  uint8_t weight = 1;
+  uint16_t startMin = 0, endMin = 0;
+
+  bool windowed() const { return startMin != endMin; }
+
+  // minute < 0: the time of day is unknown, so only unwindowed entries may play
+  bool inWindow(int minute) const {
+    if (!windowed()) return true;
+    if (minute < 0) return false;
+    if (startMin < endMin) return minute >= startMin && minute < endMin;
+    return minute >= startMin || minute < endMin;
+  }
+};
+
+struct Playlist {
+  std::vector<PlaylistEntry> entries;
+  bool weighted = false;
+
+  // Replace the entries from the text form; on error the playlist is left unchanged
+  bool parse(const char* spec, uint8_t slotCount, const char** err) {
+    std::vector<PlaylistEntry> out;
+    const char* p = spec;
+    while (*p) {
+      long v[6] = { -1, 0, 0, 1, 0, 0 };
+      int n = 0;
+      while (n < 6) {
+        char* end;
+        v[n++] = strtol(p, &end, 10);
+        if (end == p) { *err = "Bad number"; return false; }
+        p = end;
+        if (*p != ',') break;
+        ++p;
+      }
+      if (*p == ';') ++p;
+      else if (*p) { *err = "Bad separator"; return false; }
+      if (v[0] < 0 || v[0] >= slotCount) { *err = "Bad slot"; return false; }
+      if (v[1] < 0 || v[2] < 0 || v[2] > 65535 || v[3] < 0 || v[3] > 255) { *err = "Bad timing"; return false; }
+      if (v[4] < 0 || v[4] >= 1440 || v[5] < 0 || v[5] >= 1440) { *err = "Bad window"; return false; }
+      if (out.size() == PLAYLIST_MAX_ENTRIES) { *err = "Too many entries"; return false; }
+      PlaylistEntry e;
+      e.slot = (uint8_t)v[0];
+      e.dwellMs = (uint32_t)v[1];
+      e.cycles = (uint16_t)v[2];
+      e.weight = (uint8_t)v[3];
+      e.startMin = (uint16_t)v[4];
+      e.endMin = (uint16_t)v[5];
+      out.push_back(e);
+    }
+    entries.swap(out);
+    return true;
+  }
+
+  // Text form of the entries; returns the length that was needed
+  size_t format(char* out, size_t cap) const {
+    size_t len = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      const PlaylistEntry& e = entries[i];
+      char buf[48];
+      const int n = snprintf(buf, sizeof(buf), "%s%u,%u,%u,%u,%u,%u", i ? ";" : "", e.slot, (unsigned)e.dwellMs,
+                             e.cycles, e.weight, e.startMin, e.endMin);
+      for (int k = 0; k < n; ++k, ++len) if (len + 1 < cap) out[len] = buf[k];
+    }
+    if (cap) out[len < cap ? len : cap - 1] = 0;
+    return len;
+  }
+
+  // Entry to show after `current` (-1: none yet), or -1 when nothing may play right now.
+  // usable(slot) filters out slots that are not stored; rnd drives the weighted pick.
+  template <typename Usable> int next(int current, int minute, uint32_t rnd, Usable usable) const {
+    const int n = (int)entries.size();
+    if (!weighted) {
+      for (int k = 1; k <= n; ++k) {
+        const int i = ((current < 0 ? -1 : current) + k + n) % n;
+        if (playable(i, minute, usable)) return i;
+      }
+      return -1;
+    }
+    // Weighted: avoid repeating the current entry when anything else can play
+    uint32_t total = 0;
+    for (int i = 0; i < n; ++i) {
+      if (i != current && playable(i, minute, usable)) total += entries[i].weight;
+    }
+    if (total == 0) return (current >= 0 && playable(current, minute, usable)) ? current : -1;
+    uint32_t r = rnd % total;
+    for (int i = 0; i < n; ++i) {
+      if (i == current || !playable(i, minute, usable)) continue;
+      if (r < entries[i].weight) return i;
+      r -= entries[i].weight;
+    }
+    return -1;
+  }
+
+ private:
+  template <typename Usable> bool playable(int i, int minute, Usable& usable) const {
+    const PlaylistEntry& e = entries[i];
+    return usable(e.slot) && e.inWindow(minute) && (!weighted || e.weight > 0);
+  }
+};
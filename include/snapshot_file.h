@@ -0,0 +1,94 @@
+// Snapshot files for the last shown content (/last_frame.rgb565, /last_text.dat, /last_bg.rgb565)
+// Every file starts with a 32-byte header, little endian:
+//   'L' 'S' version kind u16 width u16 height meta[8]      (16 bytes)
+//   u32 payloadBytes, u64 contentHash, u32 crc              (16 bytes)
+// followed by the payload. contentHash (FNV-1a 64 over kind, size, meta and payload) names the
+// content: a save whose hash matches the file on flash is skipped. crc (CRC-32 over the header
+// up to the crc field, then the payload) catches torn or corrupted files on load. Writers go
+// through a temp file and a rename, so a power cut leaves either the old or the new snapshot.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_ESP32)
+#include "esp_rom_crc.h"
+static inline uint32_t snapshotCrc(uint32_t crc, const uint8_t* p, size_t n) { return esp_rom_crc32_le(crc, p, (uint32_t)n); }
+#else
+static inline uint32_t snapshotCrc(uint32_t crc, const uint8_t* p, size_t n) {
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+#endif
+
+static const uint8_t SNAPSHOT_MAGIC0 = 'L';
+static const uint8_t SNAPSHOT_MAGIC1 = 'S';
+static const uint8_t SNAPSHOT_VERSION = 1;
+static const uint8_t SNAPSHOT_HEADER = 32;
+static const uint8_t SNAPSHOT_CRC_OFFSET = 28;
+
+enum SnapshotKind : uint8_t { SNAP_FRAME = 0, SNAP_TEXT = 1, SNAP_BG = 2, SNAP_KINDS = 3 };
+
+static const uint64_t SNAPSHOT_FNV_BASIS = 0xcbf29ce484222325ULL;
+
+static inline uint64_t snapshotHash(uint64_t h, const uint8_t* p, size_t n) {
+  while (n--) { h ^= *p++; h *= 0x100000001b3ULL; }
+  return h;
+}
+
+struct SnapshotHeader {
+  uint8_t kind = SNAP_FRAME;
+  uint16_t w = 0, h = 0;
+  uint8_t meta[8] = {};
+  uint32_t payloadBytes = 0;
+  uint64_t hash = 0;
+  uint32_t crc = 0;
+
+  // Content hash over the header fields and n payload segments; sets hash and payloadBytes
+  void hashPayload(const uint8_t* const* data, const size_t* bytes, int n) {
+    uint8_t fixed[SNAPSHOT_HEADER];
+    payloadBytes = 0;
+    for (int i = 0; i < n; ++i) payloadBytes += (uint32_t)bytes[i];
+    encode(fixed);
+    uint64_t x = snapshotHash(SNAPSHOT_FNV_BASIS, fixed, 20);
+    for (int i = 0; i < n; ++i) x = snapshotHash(x, data[i], bytes[i]);
+    hash = x;
+  }
+
+  void encode(uint8_t out[SNAPSHOT_HEADER]) const {
+    out[0] = SNAPSHOT_MAGIC0;
+    out[1] = SNAPSHOT_MAGIC1;
+    out[2] = SNAPSHOT_VERSION;
+    out[3] = kind;
+    put(out + 4, w, 2);
+    put(out + 6, h, 2);
+    memcpy(out + 8, meta, sizeof(meta));
+    put(out + 16, payloadBytes, 4);
+    put(out + 20, hash, 8);
+    put(out + 28, crc, 4);
+  }
+
+  bool decode(const uint8_t in[SNAPSHOT_HEADER]) {
+    if (in[0] != SNAPSHOT_MAGIC0 || in[1] != SNAPSHOT_MAGIC1 || in[2] != SNAPSHOT_VERSION) return false;
+    kind = in[3];
+    w = (uint16_t)get(in + 4, 2);
+    h = (uint16_t)get(in + 6, 2);
+    memcpy(meta, in + 8, sizeof(meta));
+    payloadBytes = (uint32_t)get(in + 16, 4);
+    hash = get(in + 20, 8);
+    crc = (uint32_t)get(in + 28, 4);
+    return kind < SNAP_KINDS;
+  }
+
+ private:
+  static void put(uint8_t* p, uint64_t v, int n) { for (int i = 0; i < n; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+  static uint64_t get(const uint8_t* p, int n) {
+    uint64_t v = 0;
+    for (int i = 0; i < n; ++i) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+  }
+};
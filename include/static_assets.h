@@ -0,0 +1,78 @@
+// Static web UI assets served from LittleFS
+// tools/compress_assets.py writes a gzip sibling (main.js.gz next to main.js) for every asset that
+// compresses well; it is served with Content-Encoding: gzip to clients that accept it.
+// Each response carries a strong ETag (FNV-1a 64 over the bytes actually sent, learned on first
+// serve) and a Cache-Control policy: fonts never change under their name and are cached for a
+// year, everything else is revalidated with If-None-Match and answered 304 when unchanged.
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const uint8_t ASSET_ETAG_LEN = 19;   // 16 hex digits in quotes, plus NUL
+
+static inline const char* assetCacheControl(const char* path) {
+  static const char* const kFontExt[] = { ".ttf", ".otf", ".woff", ".woff2" };
+  const size_t n = strlen(path);
+  for (const char* ext : kFontExt) {
+    const size_t e = strlen(ext);
+    if (n >= e && strcmp(path + n - e, ext) == 0) return "public, max-age=31536000, immutable";
+  }
+  return "no-cache";
+}
+
+static inline void formatAssetEtag(char out[ASSET_ETAG_LEN], uint64_t hash) {
+  snprintf(out, ASSET_ETAG_LEN, "\"%08x%08x\"", (unsigned)(hash >> 32), (unsigned)hash);
+}
+
+// Next comma-separated token of a header value, without surrounding spaces; false at the end
+static inline bool nextHeaderToken(const char*& p, const char** tok, size_t* len) {
+  while (*p == ' ' || *p == '\t' || *p == ',') ++p;
+  if (!*p) return false;
+  const char* start = p;
+  while (*p && *p != ',') ++p;
+  const char* end = p;
+  while (end > start && (end[-1] == ' ' || end[-1] == '\t')) --end;
+  *tok = start;
+  *len = (size_t)(end - start);
+  return true;
+}
+
+// Accept-Encoding lists gzip (or *) without q=0
+static inline bool acceptsGzip(const char* acceptEncoding) {
+  const char* p = acceptEncoding;
+  const char* tok;
+  size_t len;
+  while (nextHeaderToken(p, &tok, &len)) {
+    size_t name = 0;
+    while (name < len && tok[name] != ';' && tok[name] != ' ') ++name;
+    const bool match = (name == 4 && strncmp(tok, "gzip", 4) == 0) || (name == 1 && tok[0] == '*');
+    if (!match) continue;
+    const char* q = tok + name;
+    const char* end = tok + len;
+    while (q < end && (*q == ';' || *q == ' ')) ++q;
+    if (end - q >= 3 && strncmp(q, "q=0", 3) == 0) {
+      const char* d = q + 3;
+      if (d < end && *d == '.') ++d;
+      while (d < end && *d == '0') ++d;
+      if (d == end) return false;     // q=0, q=0.0, q=0.000
+    }
+    return true;
+  }
+  return false;
+}
+
+// If-None-Match holds etag or *; W/ prefixes are ignored (weak comparison, RFC 9110 13.1.2)
+static inline bool etagMatches(const char* ifNoneMatch, const char* etag) {
+  const char* p = ifNoneMatch;
+  const char* tok;
+  size_t len;
+  const size_t n = strlen(etag);
+  while (nextHeaderToken(p, &tok, &len)) {
+    if (len == 1 && tok[0] == '*') return true;
+    if (len > 2 && tok[0] == 'W' && tok[1] == '/') { tok += 2; len -= 2; }
+    if (len == n && strncmp(tok, etag, n) == 0) return true;
+  }
+  return false;
+}
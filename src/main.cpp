@@ -6,7 +6,6 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
 #include <FS.h>
 #include <LittleFS.h>
 #include <HTTPClient.h>
@@ -14,11 +13,30 @@
 #include <ESP32-VirtualMatrixPanel-I2S-DMA.h>
 #include <string.h>
 #include <vector>
+#include <algorithm>
 #include <nvs_flash.h>
 #include <nvs.h>
 #include "esp_system.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include <time.h>
+#include <sys/time.h>
 #include <driver/i2s.h>
+#include <lwip/sockets.h>
+#include "blend565.h"
+#include "alpha_spans.h"
+#include "perf_stats.h"
+#include "pixel_pool.h"
+#include "image_upload.h"
+#include "frame_delta.h"
+#include "ddp_receiver.h"
+#include "content_slots.h"
+#include "playlist.h"
+#include "clock_widget.h"
+#include "snapshot_file.h"
+#include "static_assets.h"
+#include "asset_cache.h"
+#include "event_web_server.h"
 
 // Panel configuration (defaults). Adjust via UI if needed.
 #ifndef PANEL_RES_X
@@ -72,14 +90,8 @@ VirtualMatrixPanel  *vdisplay = nullptr;
 static const char* AP_SSID = "KHMER_PANEL";
 static const char* AP_PASS = "12341234"; // 8+ chars required
 
-WebServer server(80);
-
-// CORS headers for cross-origin requests
-void sendCORSHeaders() {
-  server.sendHeader("Access-Control-Allow-Origin", "*");
-  server.sendHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-  server.sendHeader("Access-Control-Allow-Headers", "Content-Type");
-}
+// Event-driven: CORS headers and OPTIONS preflights are answered by the server for every route
+EventWebServer server(80);
 
 // ================= I2S Tick-Tock Sound (MAX98357A) =================
 // I2S pins — ensure they are not used by HUB75
@@ -292,12 +304,18 @@ static String yt_cached_json;
 static String yt_cached_subs;
 static String yt_last_id;
 
+// Pixel buffers come from pixel_pool.h: per-frame buffers are HotVector (internal SRAM),
+// uploaded content is BulkVector (PSRAM); both reuse their blocks across uploads.
 // Uploaded text bitmap (RGB565), text-only cropped image
-static std::vector<uint8_t> uploadBuf;      // raw bytes as received (header + pixels)
-static std::vector<uint16_t> textPixels;    // pixels only, RGB565
-static std::vector<uint8_t>  textAlpha;     // optional A8 alpha per pixel
-static std::vector<uint16_t> frameBuffer;   // full virtual offscreen RGB565
-static std::vector<uint16_t> bgPixels;      // optional background image (virtual-sized)
+static BulkVector<uint16_t> textPixels;     // pixels only, RGB565
+static BulkVector<uint8_t>  textAlpha;      // optional A8 alpha per pixel
+static bool textTinted = false;             // alpha-only text: textPixels is empty, color is textColor
+static AlphaSpanIndex textSpans;            // opaque/partial runs of textAlpha, rebuilt per upload
+static ImageUploadDecoder textUpload;        // /upload body decoder writing into the staging buffers
+static BulkVector<uint16_t> textStagePixels; // /upload decodes here; swapped into textPixels at END
+static BulkVector<uint8_t>  textStageAlpha;
+static HotVector<uint16_t> frameBuffer;     // full virtual offscreen RGB565
+static BulkVector<uint16_t> bgPixels;       // optional background image (virtual-sized)
 static bool hasBgImage = false;
 static uint16_t imgW = 0, imgH = 0;         // text image size
 // Panel config (for multi-panel awareness)
@@ -313,62 +331,283 @@ static int16_t userOffX = 0;                // base X offset
 static int16_t userOffY = 0;                // base Y offset
 static bool animate = false;                // scroll enable
 static int8_t animDir = -1;                 // -1 = left, +1 = right
-static uint16_t animSpeedMs = 30;           // delay between frames (10..60)
-static int16_t  loopOffsetPx = 0;           // loop overlap/gap in pixels: <0 overlap, >0 gap
+static uint16_t animSpeedMs = 30;           // time per scrolled pixel (6..50), also the frame period
+static uint32_t scrollVelocityQ16 = 0;      // scroll speed in px/s, Q16.16 (derived from animSpeedMs)
+static int16_t  loopOffsetPx = 0;           // gap between text copies in pixels (negative is treated as 0)
 
 // Animation state
-static int16_t scrollX = 0;                 // current scroll position (left of text)
+static int16_t scrollX = 0;                 // current scroll position (left edge of the leading text copy)
+static uint32_t scrollFracQ16 = 0;          // sub-pixel part of the scroll position, Q0.16
+static int64_t scrollLastUs = 0;            // time the position was last advanced (0 = restart)
+static uint32_t scrollDistancePx = 0;       // total pixels scrolled since boot (speed check under load)
 static int16_t baseY = 0;                   // vertically centered baseline + userOffY
-static uint32_t lastAnim = 0;
 static uint32_t restartAt = 0;              // time to restart next cycle
 static bool waitingRestart = false;
-static std::vector<int16_t> heads;         // multi-head array for continuous text stream
-
-// ================= Alpha Blending Helpers (RGB565) =================
-static inline uint16_t blend565(uint16_t src565, uint16_t dst565, uint8_t a) {
-  if (a == 0) return dst565;
-  if (a == 255) return src565;
-  // Extract to 8-bit components
-  uint8_t sr = (src565 >> 8) & 0xF8; sr |= sr >> 5;
-  uint8_t sg = (src565 >> 3) & 0xFC; sg |= sg >> 6;
-  uint8_t sb = (src565 << 3) & 0xF8; sb |= sb >> 5;
-  uint8_t dr = (dst565 >> 8) & 0xF8; dr |= dr >> 5;
-  uint8_t dg = (dst565 >> 3) & 0xFC; dg |= dg >> 6;
-  uint8_t db = (dst565 << 3) & 0xF8; db |= db >> 5;
-  // Alpha blend: out = (src*a + dst*(255-a)) / 255
-  uint16_t ia = 255 - a;
-  uint8_t r = (uint8_t)((sr * a + dr * ia + 127) / 255);
-  uint8_t g = (uint8_t)((sg * a + dg * ia + 127) / 255);
-  uint8_t b = (uint8_t)((sb * a + db * ia + 127) / 255);
-  // Pack back to 565
-  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+
+// Periodic marquee strip: one period (text + gap) of the continuous text stream,
+// pre-rendered at upload time so each frame is a plain row copy at scrollX mod stripW
+static HotVector<uint16_t> stripPixels;     // stripW x stripH, alpha resolved against bgColor
+static HotVector<uint8_t>  stripAlpha;      // coverage per strip pixel, only kept over a bg image
+static AlphaSpanIndex stripSpans;           // opaque/partial runs of stripAlpha
+static int stripW = 0;                      // strip period in pixels (imgW + loopOffsetPx)
+static int stripH = 0;                      // strip rows (imgH at build time)
+static int stripTextW = 0;                  // text width at build time (extent of the leading copy)
+
+static inline bool hasTextImage() { return textTinted ? !textAlpha.empty() : !textPixels.empty(); }
+
+// Index the opaque/partial runs of textAlpha so blits skip transparent pixels
+static void rebuildTextSpans() {
+  if (!textAlpha.empty() && textAlpha.size() == (size_t)imgW * (size_t)imgH) {
+    buildAlphaSpans(textAlpha.data(), imgW, imgH, textSpans);
+  } else {
+    textSpans.clear();
+  }
+}
+
+// ================= Perf Instrumentation =================
+// Per-stage timings for /perf; all histograms are in microseconds
+static PerfHistogram gPerfBgRestore;    // background restore under the dirty rect
+static PerfHistogram gPerfBlit;         // strip copy/blend into frameBuffer
+static PerfHistogram gPerfPush;         // drawRGBBitmap push to the panel
+static PerfHistogram gPerfFrame;        // whole render-task frame incl. lock wait
+static PerfHistogram gPerfHttp;         // one server.handleClient() call
+static PerfHistogram gPerfSaveSettings; // settings write in the persistence task
+static PerfHistogram gPerfSaveFrame;    // snapshot writes in the persistence task
+static PerfHistogram gPerfFirstFrame;   // /upload start to first pushed frame
+static uint32_t gDeadlinesMissed = 0;   // frames that started after their next tick was due
+static int64_t gUploadStartUs = 0;      // set at /upload START, cleared at first frame
+
+// The render, DDP and persist tasks may be recording; each clears its histograms itself
+static void resetPerfStats() {
+  gPerfBgRestore.requestReset(); gPerfBlit.requestReset(); gPerfPush.requestReset(); gPerfFrame.requestReset();
+  gPerfHttp.requestReset(); gPerfSaveSettings.requestReset(); gPerfSaveFrame.requestReset(); gPerfFirstFrame.requestReset();
+  gDeadlinesMissed = 0;
+}
+
+static void appendPoolJson(String& json, PixelPoolId id) {
+  const PixelPool& p = pixelPool(id);
+  json += "\""; json += p.name; json += "\":{";
+  json += "\"in_use\":" + String((uint32_t)p.inUse) + ",";
+  json += "\"high_water\":" + String((uint32_t)p.highWater) + ",";
+  json += "\"cached\":" + String((uint32_t)p.cachedBytes) + ",";
+  json += "\"allocs\":" + String(p.allocs) + ",";
+  json += "\"reuses\":" + String(p.reuses) + ",";
+  json += "\"fallbacks\":" + String(p.fallbacks) + ",";
+  json += "\"failures\":" + String(p.failures) + "}";
+}
+
+static void appendPerfJson(String& json, const char* name, const PerfHistogram& h) {
+  json += "\""; json += name; json += "\":{";
+  const bool empty = h.empty();
+  json += "\"n\":" + String(empty ? 0 : h.count) + ",";
+  json += "\"p50\":" + String(h.percentile(50)) + ",";
+  json += "\"p95\":" + String(h.percentile(95)) + ",";
+  json += "\"p99\":" + String(h.percentile(99)) + ",";
+  json += "\"max\":" + String(empty ? 0 : h.maxUs) + "}";
+}
+
+// ================= Marquee Strip Renderer =================
+static void selectMarqueeCompositor();
+
+// All text copies are spaced exactly stripW apart, so the stream is periodic:
+// render one period once and copy it into the frame with a phase offset.
+// Copies never overlap: a period shorter than the text would fold the tail of the previous
+// copy into every period, including the first copy entering the screen, which has none.
+static void buildMarqueeStrip() {
+  int spacing = (int)imgW + std::max(0, (int)loopOffsetPx);
+  if (spacing < 1) spacing = 1;
+  stripW = spacing;
+  stripH = imgH;
+  stripTextW = imgW;
+
+  // Over a bg image the background under the text changes as it moves,
+  // so keep coverage and blend per frame; over a solid color resolve it now.
+  const bool overImage = hasBgImage && bgPixels.size() == frameBuffer.size();
+  const bool hasAlpha = !textAlpha.empty();
+  const size_t n = (size_t)stripW * (size_t)imgH;
+  stripPixels.assign(n, bgColor);
+  if (overImage) stripAlpha.assign(n, 0); else stripAlpha.clear();
+
+  for (int y = 0; y < (int)imgH; ++y) {
+    const size_t srcRow = (size_t)y * imgW;
+    const size_t dstRow = (size_t)y * stripW;
+    auto put = [&](int sx, uint8_t a) {
+      const size_t di = dstRow + (size_t)sx;
+      const uint16_t c = textTinted ? textColor : textPixels[srcRow + sx];
+      if (!overImage) {
+        stripPixels[di] = blend565(c, stripPixels[di], a);
+      } else {
+        // Keep the raw text color; coverage is applied against bgPixels per frame
+        stripPixels[di] = stripAlpha[di] ? blend565(c, stripPixels[di], a) : c;
+        stripAlpha[di] = (uint8_t)(a + (stripAlpha[di] * (255 - a) + 127) / 255);
+      }
+    };
+    if (hasAlpha && !textSpans.empty()) {
+      for (const AlphaSpan* sp = textSpans.rowBegin(y); sp != textSpans.rowEnd(y); ++sp) {
+        for (int sx = sp->x; sx < sp->x + sp->len; ++sx) put(sx, textAlpha[srcRow + sx]);
+      }
+    } else {
+      for (int sx = 0; sx < (int)imgW; ++sx) put(sx, 255);
+    }
+  }
+  if (overImage) buildAlphaSpans(stripAlpha.data(), stripW, imgH, stripSpans); else stripSpans.clear();
+  selectMarqueeCompositor();
+  Serial.printf("Marquee strip built: %dx%u (%s)\n", stripW, imgH, overImage ? "over image" : "resolved");
+}
+
+// Starting position: left scrolling enters from the right edge, right scrolling from the left
+static void resetMarqueePosition() {
+  scrollX = (animDir < 0) ? (int16_t)VIRT_W() : (int16_t)(-(int)imgW);
+  scrollFracQ16 = 0;
+  scrollLastUs = 0;
+}
+
+// Advance the stream by the distance covered at scrollVelocityQ16 since the last frame,
+// keeping scrollX bounded once the screen is filled. Late frames move further instead of
+// slowing the text down.
+static void advanceMarquee(int64_t nowUs) {
+  if (stripW <= 0) return;
+  if (scrollLastUs == 0) { scrollLastUs = nowUs; return; }
+  int64_t elapsedUs = nowUs - scrollLastUs;
+  scrollLastUs = nowUs;
+  if (elapsedUs <= 0) return;
+  if (elapsedUs > 1000000) elapsedUs = 1000000; // cap a stall at one second of travel
+
+  const uint64_t distQ16 = ((uint64_t)scrollVelocityQ16 * (uint64_t)elapsedUs) / 1000000ULL + scrollFracQ16;
+  scrollFracQ16 = (uint32_t)(distQ16 & 0xFFFF);
+  int32_t pos = scrollX;
+  const int32_t px = (int32_t)(distQ16 >> 16);
+  scrollDistancePx += (uint32_t)px;
+  if (animDir < 0) {
+    pos -= px;
+    while (pos <= -stripW) pos += stripW;
+  } else {
+    pos += px;
+    while (pos >= VIRT_W()) pos -= stripW;
+  }
+  scrollX = (int16_t)pos;
+}
+
+// Map the UI speed percentage to time per pixel
+static uint16_t speedPercentToMs(int speedPercent) {
+  // Aggressive speed mapping: 10% = 50ms (20 px/s), 100% = 6ms (167 px/s)
+  int targetMs;
+  if (speedPercent == 10) {
+    targetMs = 50;    // 0.5x of 100% speed (20 FPS)
+  } else if (speedPercent == 20) {
+    targetMs = 25;    // Same as current 100% speed (40 FPS)
+  } else if (speedPercent == 40) {
+    targetMs = 17;    // 1.5x faster than current 100% (59 FPS)
+  } else if (speedPercent == 60) {
+    targetMs = 13;    // 2x faster than current 100% (77 FPS)
+  } else if (speedPercent == 80) {
+    targetMs = 8;     // 3.5x faster than current 100% (125 FPS)
+  } else if (speedPercent == 100) {
+    targetMs = 6;     // 4x faster than current 100% (167 FPS)
+  } else {
+    // Linear interpolation between specific points
+    targetMs = map(speedPercent, 10, 100, 50, 6);
+  }
+  // Ensure minimum delay for ultra-fast scrolling
+  if (targetMs < 6) targetMs = 6;
+  return (uint16_t)targetMs;
+}
+
+// ================= Dirty Region Tracking =================
+// frameBuffer mirrors what the panel shows. While frameSynced is set, everything outside
+// the drawn rect is plain background, so redraws only restore and push the text area.
+static bool frameSynced = false;
+static int drawnX0 = 0, drawnY0 = 0, drawnX1 = 0, drawnY1 = 0;  // last text rect (exclusive end)
+
+static void clipToFrame(int& x0, int& y0, int& x1, int& y1) {
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > VIRT_W()) x1 = VIRT_W();
+  if (y1 > VIRT_H()) y1 = VIRT_H();
+}
+
+// Grow [x0,x1)x[y0,y1) to also cover the previously drawn text, or the whole frame if out of sync
+static void unionWithDrawn(int& x0, int& y0, int& x1, int& y1) {
+  if (!frameSynced) { x0 = 0; y0 = 0; x1 = VIRT_W(); y1 = VIRT_H(); return; }
+  if (drawnX1 > drawnX0 && drawnY1 > drawnY0) {
+    if (x1 <= x0 || y1 <= y0) { x0 = drawnX0; y0 = drawnY0; x1 = drawnX1; y1 = drawnY1; return; }
+    if (drawnX0 < x0) x0 = drawnX0;
+    if (drawnY0 < y0) y0 = drawnY0;
+    if (drawnX1 > x1) x1 = drawnX1;
+    if (drawnY1 > y1) y1 = drawnY1;
+  }
+}
+
+static void setDrawnRect(int x0, int y0, int x1, int y1) {
+  clipToFrame(x0, y0, x1, y1);
+  drawnX0 = x0; drawnY0 = y0; drawnX1 = x1; drawnY1 = y1;
+  frameSynced = true;
+}
+
+// The text content's background image, or nullptr when it has none for this frame size
+static const uint16_t* contentBgImage() {
+  return hasBgImage && bgPixels.size() == frameBuffer.size() ? bgPixels.data() : nullptr;
+}
+
+// Restore background (a frame-sized image, or the solid fill color) into a rect of frameBuffer
+static void restoreBackgroundRect(int x0, int y0, int x1, int y1, const uint16_t* image, uint16_t fill) {
+  clipToFrame(x0, y0, x1, y1);
+  if (x1 <= x0 || y1 <= y0) return;
+  const size_t frameW = (size_t)VIRT_W();
+  for (int y = y0; y < y1; ++y) {
+    const size_t row = (size_t)y * frameW;
+    if (image) {
+      memcpy(&frameBuffer[row + x0], &image[row + x0], (size_t)(x1 - x0) * sizeof(uint16_t));
+    } else {
+      std::fill(frameBuffer.begin() + row + x0, frameBuffer.begin() + row + x1, fill);
+    }
+  }
+}
+
+// Push a rect of frameBuffer to the panel: full-width bands go out as one contiguous bitmap
+static void pushFrameRect(int x0, int y0, int x1, int y1) {
+  clipToFrame(x0, y0, x1, y1);
+  if (!vdisplay || x1 <= x0 || y1 <= y0) return;
+  const int frameW = VIRT_W();
+  if (x0 == 0 && x1 == frameW) {
+    vdisplay->drawRGBBitmap(0, y0, &frameBuffer[(size_t)y0 * frameW], frameW, y1 - y0);
+  } else {
+    for (int y = y0; y < y1; ++y) {
+      vdisplay->drawRGBBitmap(x0, y, &frameBuffer[(size_t)y * frameW + x0], x1 - x0, 1);
+    }
+  }
 }
 
 // Display mode tracking
-enum DisplayMode { MODE_NONE, MODE_CLOCK, MODE_THEME };
+enum DisplayMode { MODE_NONE, MODE_CLOCK, MODE_THEME, MODE_STREAM, MODE_WIDGET };
 static DisplayMode currentMode = MODE_NONE;
+// /frame_delta stream state; anything else that redraws in MODE_STREAM clears gStreamSeq
+static uint32_t gStreamSeq = 0;              // last applied sequence, 0 = no valid base
+static uint16_t gStreamW = 0, gStreamH = 0;  // geometry of the streamed frame
+static int gActiveSlot = -1;                 // content slot on the panel, -1 = ad-hoc content
 
-// Persistent storage structure
+// Persistent storage structure; the defaults are what a fresh device persists before any upload
 struct LastSettings {
-  bool animate;
-  int8_t animDir;
-  uint16_t animSpeedMs;
-  uint8_t speedPercent;      // ADD: Speed percentage (10-100) for proper saving/loading
-  int16_t loopOffsetPx;
-  uint16_t bgColor;
-  uint16_t textColor;        // ADD: Text color
-  uint16_t brightness;
-  DisplayMode mode;
-  bool hasText;
-  bool hasBgImage;
-  uint16_t textWidth;
-  uint16_t textHeight;
-  int16_t scrollX;           // Current scroll position
-  uint16_t spacing;          // Animation spacing
-  uint32_t savedTime;        // When the state was saved
+  bool animate = false;
+  int8_t animDir = -1;
+  uint16_t animSpeedMs = 0;
+  uint8_t speedPercent = 80; // ADD: Speed percentage (10-100) for proper saving/loading
+  int16_t loopOffsetPx = 0;
+  uint16_t bgColor = 0;
+  uint16_t textColor = 0;    // ADD: Text color
+  uint16_t brightness = 200;
+  DisplayMode mode = MODE_NONE;
+  bool hasText = false;
+  bool hasBgImage = false;
+  uint16_t textWidth = 0;
+  uint16_t textHeight = 0;
+  int16_t scrollX = 0;       // Current scroll position
+  uint16_t spacing = 0;      // Animation spacing
+  uint32_t savedTime = 0;    // When the state was saved
+  int8_t activeSlot = -1;    // content slot on the panel, -1 = ad-hoc content
 };
 
-static LastSettings lastSettings = {0};
+static LastSettings lastSettings;
 static std::vector<uint16_t> lastFrameBuffer;  // Store last displayed frame
 static uint8_t currentBrightness = 200;  // Track current brightness
 static uint32_t lastSaveTime = 0;  // Track when we last saved the frame
@@ -380,7 +619,7 @@ static inline int panelIndexFromXY(int x, int y) {
   return row * cur_cols + col; // row-major for current layout
 }
 
-static void maskDisabledPanels() {
+static void maskDisabledPanels(int rowBegin = 0, int rowEnd = INT16_MAX) {
   if (g_panel_active.empty()) return;
   for (int row = 0; row < g_panel_rows; ++row) {
     for (int col = 0; col < g_panel_cols; ++col) {
@@ -389,6 +628,7 @@ static void maskDisabledPanels() {
         int x0 = col * PANEL_RES_X;
         int y0 = row * PANEL_RES_Y;
         for (int y = 0; y < PANEL_RES_Y; ++y) {
+          if (y0 + y < rowBegin || y0 + y >= rowEnd) continue;
           size_t base = (size_t)(y0 + y) * (size_t)VIRT_W() + (size_t)x0;
           for (int x = 0; x < PANEL_RES_X; ++x) {
             frameBuffer[base + (size_t)x] = 0x0000; // force black on disabled panel
@@ -399,6 +639,91 @@ static void maskDisabledPanels() {
   }
 }
 
+// ================= Specialized Marquee Compositor =================
+// One instantiation per (background source, panel mask, scroll direction, frame width).
+// selectMarqueeCompositor() picks it once per strip build, so the per-frame path runs
+// without mode branches and with a constant row stride on the default panel layout.
+template <bool OverImage, bool Masked, int Dir, int FixedW>
+static void marqueeFrameT(int x0, int y0, int x1, int y1) {
+  const int frameW = FixedW ? FixedW : VIRT_W();
+  const int frameH = VIRT_H();
+
+  // Restore the background under the dirty rect
+  const uint32_t tRestore = perfCycles();
+  for (int y = y0; y < y1; ++y) {
+    uint16_t* row = &frameBuffer[(size_t)y * frameW];
+    if (OverImage) memcpy(row + x0, &bgPixels[(size_t)y * frameW + x0], (size_t)(x1 - x0) * sizeof(uint16_t));
+    else std::fill(row + x0, row + x1, bgColor);
+  }
+  const uint32_t tBlit = perfCycles();
+  gPerfBgRestore.recordCycles(tBlit - tRestore);
+
+  // Copy the visible part of the text stream. Only the leading copy and those behind it
+  // exist: left scrolling fills x >= origin, right scrolling fills up to the leading copy.
+  const int origin = (int)scrollX + (int)userOffX;
+  int xBegin = 0, xEnd = frameW;
+  if (Dir < 0) {
+    if (origin > xBegin) xBegin = origin;
+  } else {
+    const int lead = origin + ((stripTextW > stripW) ? stripTextW : stripW);
+    if (lead < xEnd) xEnd = lead;
+  }
+  if (xBegin < xEnd) {
+    int phase = (xBegin - origin) % stripW;
+    if (phase < 0) phase += stripW;
+    for (int y = 0; y < stripH; ++y) {
+      const int dstY = baseY + y;
+      if (dstY < 0 || dstY >= frameH) continue;
+      const uint16_t* src = &stripPixels[(size_t)y * stripW];
+      uint16_t* dst = &frameBuffer[(size_t)dstY * frameW];
+      int x = xBegin, s = phase;
+      while (x < xEnd) {
+        const int run = (stripW - s < xEnd - x) ? (stripW - s) : (xEnd - x);
+        if (OverImage) blitSpanRow(dst + x, src, &stripAlpha[(size_t)y * stripW], stripSpans.rowBegin(y), stripSpans.rowEnd(y), s, s + run);
+        else memcpy(dst + x, src + s, (size_t)run * sizeof(uint16_t));
+        x += run;
+        s = 0;
+      }
+    }
+  }
+  gPerfBlit.recordCycles(perfCycles() - tBlit);
+
+  if (Masked) maskDisabledPanels(y0, y1);
+}
+
+typedef void (*MarqueeFrameFn)(int x0, int y0, int x1, int y1);
+static MarqueeFrameFn marqueeFrame = nullptr;
+
+template <bool OverImage, bool Masked, int Dir>
+static MarqueeFrameFn pickMarqueeWidth() {
+  if (VIRT_W() == PANEL_RES_X) return marqueeFrameT<OverImage, Masked, Dir, PANEL_RES_X>;
+  return marqueeFrameT<OverImage, Masked, Dir, 0>;
+}
+
+template <bool OverImage, bool Masked>
+static MarqueeFrameFn pickMarqueeDir() {
+  return (animDir < 0) ? pickMarqueeWidth<OverImage, Masked, -1>() : pickMarqueeWidth<OverImage, Masked, 1>();
+}
+
+template <bool OverImage>
+static MarqueeFrameFn pickMarqueeMask(bool masked) {
+  return masked ? pickMarqueeDir<OverImage, true>() : pickMarqueeDir<OverImage, false>();
+}
+
+static void selectMarqueeCompositor() {
+  bool masked = false;
+  for (size_t i = 0; i < g_panel_active.size(); ++i) if (g_panel_active[i] == 0) { masked = true; break; }
+  marqueeFrame = stripAlpha.empty() ? pickMarqueeMask<false>(masked) : pickMarqueeMask<true>(masked);
+}
+
+// Restore, compose and mask one marquee frame inside [x0,x1)x[y0,y1)
+static void renderMarqueeRect(int x0, int y0, int x1, int y1) {
+  clipToFrame(x0, y0, x1, y1);
+  if (stripW <= 0 || stripPixels.empty() || x1 <= x0 || y1 <= y0) return;
+  if (!marqueeFrame) selectMarqueeCompositor();
+  marqueeFrame(x0, y0, x1, y1);
+}
+
 static const char* panelLabelForIndex(int idx) {
   static const char* labels[] = {"main","second","third","fourth","fifth","sixth","seventh","eighth"};
   int n = sizeof(labels)/sizeof(labels[0]);
@@ -406,16 +731,113 @@ static const char* panelLabelForIndex(int idx) {
   return "panel";
 }
 
-// Persistent storage functions
-static void saveLastSettings() {
-  nvs_handle_t nvs_handle;
-  esp_err_t err = nvs_open("storage", NVS_READWRITE, &nvs_handle);
-  if (err != ESP_OK) {
-    Serial.printf("Error opening NVS: %s\n", esp_err_to_name(err));
+static bool renderWidgetFrame(int64_t nowUs);
+static bool saveWidget();
+static void applyPanelBrightness();
+
+// ================= Render Task =================
+// Scrolling runs in its own task, pinned next to loop() at a higher priority and paced by
+// an esp_timer, so slow HTTP handlers (Wi-Fi connect, TLS fetches) no longer stall it.
+// Handlers that change render state hold FrameLock while they do.
+#define RENDER_TASK_CORE 1
+#define RENDER_TASK_PRIO 2
+
+static SemaphoreHandle_t gFrameMutex = nullptr;
+static TaskHandle_t gRenderTask = nullptr;
+static esp_timer_handle_t gRenderTimer = nullptr;
+static uint32_t gRenderPeriodMs = 0;
+static volatile uint32_t gFramesRendered = 0;   // frames pushed by the render task
+static volatile uint32_t gFramesDropped = 0;    // timer ticks that arrived while a frame was still running
+static volatile uint32_t gMaxFrameGapUs = 0;    // worst interval between two rendered frames
+
+struct FrameLock {
+  FrameLock() { if (gFrameMutex) xSemaphoreTake(gFrameMutex, portMAX_DELAY); }
+  ~FrameLock() { if (gFrameMutex) xSemaphoreGive(gFrameMutex); }
+};
+
+// Move the marquee to where it should be at nowUs and draw it; returns false when nothing is scrolling
+static bool renderMarqueeFrame(int64_t nowUs) {
+  if (!animate || currentMode != MODE_CLOCK || stripW <= 0) return false;
+
+  // Position follows elapsed time, not the number of frames drawn
+  advanceMarquee(nowUs);
+
+  // Only the text band changes while scrolling; rows outside it are left untouched
+  int bx0 = 0, by0 = baseY, bx1 = VIRT_W(), by1 = baseY + stripH;
+  clipToFrame(bx0, by0, bx1, by1);
+  unionWithDrawn(bx0, by0, bx1, by1);
+
+  // Restore, copy the pre-rendered strip at the current phase and mask
+  renderMarqueeRect(bx0, by0, bx1, by1);
+
+  // Display the updated band
+  {
+    PerfScope perf(gPerfPush);
+    pushFrameRect(bx0, by0, bx1, by1);
+  }
+  setDrawnRect(0, baseY, VIRT_W(), baseY + stripH);
+  return true;
+}
+
+static void renderTask(void* arg) {
+  int64_t lastFrameUs = 0;
+  for (;;) {
+    uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (ticks > 1) { gFramesDropped += ticks - 1; gDeadlinesMissed++; }
+    bool drew;
+    int64_t now;
+    {
+      PerfScope perf(gPerfFrame);
+      FrameLock lock;
+      now = esp_timer_get_time();
+      drew = renderMarqueeFrame(now);
+      if (!drew) renderWidgetFrame(now);
+    }
+    if (!drew) { lastFrameUs = 0; continue; }
+    if (lastFrameUs) {
+      uint32_t gap = (uint32_t)(now - lastFrameUs);
+      if (gap > gMaxFrameGapUs) gMaxFrameGapUs = gap;
+    }
+    lastFrameUs = now;
+    gFramesRendered++;
+  }
+}
+
+static void renderTimerCallback(void* arg) {
+  if (gRenderTask) xTaskNotifyGive(gRenderTask);
+}
+
+// Derive the scroll velocity from animSpeedMs and re-arm the frame timer to one frame per pixel
+static void applyScrollSpeed() {
+  const uint32_t periodMs = animSpeedMs ? animSpeedMs : 1;
+  scrollVelocityQ16 = (uint32_t)((1000ULL << 16) / periodMs);
+  if (!gRenderTimer) return;
+  if (periodMs == gRenderPeriodMs) return;
+  esp_timer_stop(gRenderTimer);
+  esp_timer_start_periodic(gRenderTimer, (uint64_t)periodMs * 1000ULL);
+  gRenderPeriodMs = periodMs;
+  Serial.printf("Render period set to %u ms (%u.%02u px/s)\n", (unsigned)periodMs,
+                (unsigned)(scrollVelocityQ16 >> 16), (unsigned)(((scrollVelocityQ16 & 0xFFFF) * 100) >> 16));
+}
+
+static void startRenderTask() {
+  if (gRenderTask) return;
+  gFrameMutex = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(renderTask, "render", 4096, nullptr, RENDER_TASK_PRIO, &gRenderTask, RENDER_TASK_CORE);
+  esp_timer_create_args_t args = {};
+  args.callback = renderTimerCallback;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "render";
+  if (esp_timer_create(&args, &gRenderTimer) != ESP_OK) {
+    Serial.println("Render timer create failed");
     return;
   }
+  applyScrollSpeed();
+}
 
-  // Update current settings
+// Persistent storage functions
+// Copy the live state into lastSettings; callers hold FrameLock so the record is consistent
+static LastSettings captureLastSettings() {
   lastSettings.animate = animate;
   lastSettings.animDir = animDir;
   lastSettings.animSpeedMs = animSpeedMs;
@@ -423,203 +845,229 @@ static void saveLastSettings() {
   lastSettings.bgColor = bgColor;
   lastSettings.textColor = textColor;  // ADD: Save text color
   lastSettings.mode = currentMode;
-  lastSettings.hasText = !textPixels.empty();
+  lastSettings.hasText = hasTextImage();
   lastSettings.hasBgImage = hasBgImage;
   lastSettings.textWidth = imgW;
   lastSettings.textHeight = imgH;
 
   // Save current animation state - SIMPLE VERSION
   lastSettings.scrollX = scrollX;
-  lastSettings.spacing = imgW + loopOffsetPx;
+  lastSettings.spacing = imgW + std::max(0, (int)loopOffsetPx);
   lastSettings.savedTime = millis();
-
-  // Save settings to NVS
-  nvs_set_u8(nvs_handle, "animate", lastSettings.animate ? 1 : 0);
-  nvs_set_i8(nvs_handle, "animDir", lastSettings.animDir);
-  nvs_set_u16(nvs_handle, "animSpeedMs", lastSettings.animSpeedMs);
-  nvs_set_u8(nvs_handle, "speedPercent", lastSettings.speedPercent);
-  Serial.printf("Saving speed: percentage=%d%%, animSpeedMs=%d ms\n", lastSettings.speedPercent, lastSettings.animSpeedMs);
-  nvs_set_i16(nvs_handle, "loopOffsetPx", lastSettings.loopOffsetPx);
-  nvs_set_u16(nvs_handle, "bgColor", lastSettings.bgColor);
-  nvs_set_u16(nvs_handle, "textColor", lastSettings.textColor);  // ADD: Save text color
-  nvs_set_u8(nvs_handle, "mode", static_cast<uint8_t>(lastSettings.mode));
-  nvs_set_u8(nvs_handle, "hasText", lastSettings.hasText ? 1 : 0);
-  nvs_set_u8(nvs_handle, "hasBgImage", lastSettings.hasBgImage ? 1 : 0);
-  nvs_set_u16(nvs_handle, "textWidth", lastSettings.textWidth);
-  nvs_set_u16(nvs_handle, "textHeight", lastSettings.textHeight);
-
-  // Save animation state
-  nvs_set_i16(nvs_handle, "scrollX", lastSettings.scrollX);
-  nvs_set_u16(nvs_handle, "spacing", lastSettings.spacing);
-  nvs_set_u32(nvs_handle, "savedTime", lastSettings.savedTime);
-
-  // Save brightness
-  nvs_set_u8(nvs_handle, "brightness", currentBrightness);
   lastSettings.brightness = currentBrightness;
+  lastSettings.activeSlot = (int8_t)gActiveSlot;
+  return lastSettings;
+}
 
-  // Commit NVS changes with retry mechanism
-  err = nvs_commit(nvs_handle);
-  if (err != ESP_OK) {
-    Serial.printf("Error committing NVS: %s\n", esp_err_to_name(err));
-    // Retry commit once
-    delay(10);
-    err = nvs_commit(nvs_handle);
-    if (err != ESP_OK) {
-      Serial.printf("Error committing NVS on retry: %s\n", esp_err_to_name(err));
-    }
-  } else {
-    Serial.println("Settings saved to NVS successfully");
-  }
+// Settings record: the whole LastSettings as one NVS blob ("settings"), so a save is one
+// nvs_set_blob and a load one nvs_get_blob. Layout, little endian:
+//   u8 version, u8 body length, body (SETTINGS_BODY_V1 bytes for version 1), u32 CRC-32 over
+//   everything before it.
+// Later versions append fields to the body; a reader accepts any version whose body is at
+// least as long as the one it knows and ignores the rest.
+static const char* const SETTINGS_KEY = "settings";
+static const uint8_t SETTINGS_VERSION = 1;
+static const uint8_t SETTINGS_BODY_V1 = 30;
+static const size_t SETTINGS_MAX_BLOB = 2 + 255 + 4;
+
+// Per-key layout written by older firmware; migrated to the blob and erased on first boot
+static const char* const kLegacySettingsKeys[] = {
+  "animate", "animDir", "animSpeedMs", "speedPercent", "loopOffsetPx", "bgColor", "textColor", "mode",
+  "hasText", "hasBgImage", "textWidth", "textHeight", "scrollX", "spacing", "savedTime", "brightness", "activeSlot",
+};
 
-  // Force verification of saved speed data
-  uint8_t savedSpeedCheck = 0;
-  esp_err_t checkErr = nvs_get_u8(nvs_handle, "speedPercent", &savedSpeedCheck);
-  if (checkErr == ESP_OK) {
-    Serial.printf("Verified speedPercent saved correctly: %d%%\n", savedSpeedCheck);
-  } else {
-    Serial.printf("ERROR: speedPercent not found in NVS after save! Error: %s\n", esp_err_to_name(checkErr));
-  }
+static void putLE(uint8_t*& p, uint32_t v, int n) { for (int i = 0; i < n; ++i) *p++ = (uint8_t)(v >> (8 * i)); }
+static uint32_t getLE(const uint8_t*& p, int n) {
+  uint32_t v = 0;
+  for (int i = 0; i < n; ++i) v |= (uint32_t)*p++ << (8 * i);
+  return v;
+}
 
-  nvs_close(nvs_handle);
+static size_t encodeLastSettings(const LastSettings& s, uint8_t* out) {
+  uint8_t* p = out;
+  *p++ = SETTINGS_VERSION;
+  *p++ = SETTINGS_BODY_V1;
+  putLE(p, s.animate ? 1 : 0, 1);
+  putLE(p, (uint8_t)s.animDir, 1);
+  putLE(p, s.animSpeedMs, 2);
+  putLE(p, s.speedPercent, 1);
+  putLE(p, (uint16_t)s.loopOffsetPx, 2);
+  putLE(p, s.bgColor, 2);
+  putLE(p, s.textColor, 2);
+  putLE(p, s.brightness, 2);
+  putLE(p, (uint8_t)s.mode, 1);
+  putLE(p, s.hasText ? 1 : 0, 1);
+  putLE(p, s.hasBgImage ? 1 : 0, 1);
+  putLE(p, s.textWidth, 2);
+  putLE(p, s.textHeight, 2);
+  putLE(p, (uint16_t)s.scrollX, 2);
+  putLE(p, s.spacing, 2);
+  putLE(p, s.savedTime, 4);
+  putLE(p, (uint8_t)s.activeSlot, 1);
+  putLE(p, 0, 1);  // reserved
+  putLE(p, snapshotCrc(0, out, p - out), 4);
+  return p - out;
 }
 
-static void loadLastSettings() {
+// Fills s only when the blob is intact; fields out of range are clamped, not the record dropped
+static bool decodeLastSettings(const uint8_t* in, size_t len, LastSettings& s) {
+  if (len < 2 + 4 || in[0] < 1 || in[1] < SETTINGS_BODY_V1 || len != (size_t)2 + in[1] + 4) return false;
+  const uint8_t* c = in + 2 + in[1];
+  if (getLE(c, 4) != snapshotCrc(0, in, 2 + in[1])) return false;
+  const uint8_t* p = in + 2;
+  LastSettings d = s;
+  d.animate = getLE(p, 1) != 0;
+  d.animDir = (int8_t)getLE(p, 1) < 0 ? -1 : 1;
+  d.animSpeedMs = (uint16_t)getLE(p, 2);
+  d.speedPercent = (uint8_t)getLE(p, 1);
+  d.loopOffsetPx = (int16_t)getLE(p, 2);
+  d.bgColor = (uint16_t)getLE(p, 2);
+  d.textColor = (uint16_t)getLE(p, 2);
+  d.brightness = (uint16_t)getLE(p, 2);
+  const uint8_t mode = (uint8_t)getLE(p, 1);
+  d.hasText = getLE(p, 1) != 0;
+  d.hasBgImage = getLE(p, 1) != 0;
+  d.textWidth = (uint16_t)getLE(p, 2);
+  d.textHeight = (uint16_t)getLE(p, 2);
+  d.scrollX = (int16_t)getLE(p, 2);
+  d.spacing = (uint16_t)getLE(p, 2);
+  d.savedTime = getLE(p, 4);
+  d.activeSlot = (int8_t)getLE(p, 1);
+  d.speedPercent = constrain(d.speedPercent, 10, 100);
+  if (d.brightness > 255) d.brightness = 255;
+  if (d.activeSlot < -1 || d.activeSlot >= CONTENT_SLOT_COUNT) d.activeSlot = -1;
+  d.mode = mode > MODE_WIDGET ? MODE_NONE : static_cast<DisplayMode>(mode);
+  s = d;
+  return true;
+}
+
+static bool writeSettingsBlob(nvs_handle_t nvs_handle, const LastSettings& settings) {
+  uint8_t blob[SETTINGS_MAX_BLOB];
+  const size_t len = encodeLastSettings(settings, blob);
+  esp_err_t err = nvs_set_blob(nvs_handle, SETTINGS_KEY, blob, len);
+  if (err == ESP_OK) err = nvs_commit(nvs_handle);
+  if (err != ESP_OK) {
+    Serial.printf("Error saving settings to NVS: %s\n", esp_err_to_name(err));
+    return false;
+  }
+  return true;
+}
+
+static void writeLastSettings(const LastSettings& settings) {
   nvs_handle_t nvs_handle;
-  esp_err_t err = nvs_open("storage", NVS_READONLY, &nvs_handle);
+  esp_err_t err = nvs_open("storage", NVS_READWRITE, &nvs_handle);
   if (err != ESP_OK) {
-    Serial.println("No saved settings found, using defaults");
+    Serial.printf("Error opening NVS: %s\n", esp_err_to_name(err));
     return;
   }
+  if (writeSettingsBlob(nvs_handle, settings)) {
+    Serial.printf("Settings saved to NVS (speed %d%%, %d ms)\n", settings.speedPercent, settings.animSpeedMs);
+  }
+  nvs_close(nvs_handle);
+}
 
-  // Load settings from NVS
+// Read the per-key layout of older firmware into s; returns whether any key was present
+static bool readLegacySettings(nvs_handle_t nvs_handle, LastSettings& s) {
   uint8_t u8_val;
   int8_t i8_val;
   int16_t i16_val;
   uint16_t u16_val;
+  uint32_t u32_val;
+  bool found = false;
 
-  if (nvs_get_u8(nvs_handle, "animate", &u8_val) == ESP_OK) {
-    lastSettings.animate = (u8_val == 1);
-    animate = lastSettings.animate;
-  }
-  if (nvs_get_i8(nvs_handle, "animDir", &i8_val) == ESP_OK) {
-    lastSettings.animDir = i8_val;
-    animDir = lastSettings.animDir;
-  }
-  // Prioritize speed percentage over old animSpeedMs for proper loading
+  if (nvs_get_u8(nvs_handle, "animate", &u8_val) == ESP_OK) { s.animate = (u8_val == 1); found = true; }
+  if (nvs_get_i8(nvs_handle, "animDir", &i8_val) == ESP_OK) { s.animDir = i8_val < 0 ? -1 : 1; found = true; }
+  // Prefer the speed percentage; estimate it from animSpeedMs for the oldest layout
   if (nvs_get_u8(nvs_handle, "speedPercent", &u8_val) == ESP_OK) {
-    lastSettings.speedPercent = u8_val;
-    // Recalculate animSpeedMs from saved percentage using aggressive mapping
-    int targetMs;
-    if (lastSettings.speedPercent == 10) {
-      targetMs = 50;    // 0.5x of 100% speed (20 FPS)
-    } else if (lastSettings.speedPercent == 20) {
-      targetMs = 25;    // Same as current 100% speed (40 FPS)
-    } else if (lastSettings.speedPercent == 40) {
-      targetMs = 17;    // 1.5x faster than current 100% (59 FPS)
-    } else if (lastSettings.speedPercent == 60) {
-      targetMs = 13;    // 2x faster than current 100% (77 FPS)
-    } else if (lastSettings.speedPercent == 80) {
-      targetMs = 8;     // 3.5x faster than current 100% (125 FPS)
-    } else if (lastSettings.speedPercent == 100) {
-      targetMs = 6;     // 4x faster than current 100% (167 FPS)
-    } else {
-      // Linear interpolation between specific points
-      targetMs = map(lastSettings.speedPercent, 10, 100, 50, 6);
-    }
-    animSpeedMs = targetMs;
-    if (animSpeedMs < 6) animSpeedMs = 6;
-    Serial.printf("SUCCESS: Loaded speed percentage: %d%%, calculated animSpeedMs: %d ms\n", lastSettings.speedPercent, animSpeedMs);
-
-    // Double-check that we loaded the correct value
-    if (lastSettings.speedPercent >= 80) {
-      Serial.printf("SPEED CHECK: High speed loaded (%d%%), animation should be fast\n", lastSettings.speedPercent);
-    } else {
-      Serial.printf("SPEED CHECK: Slow speed loaded (%d%%), animation will be slow\n", lastSettings.speedPercent);
-    }
+    s.speedPercent = constrain(u8_val, 10, 100);
+    found = true;
   } else if (nvs_get_u16(nvs_handle, "animSpeedMs", &u16_val) == ESP_OK) {
-    // Fallback to old animSpeedMs (for compatibility with old settings)
-    lastSettings.animSpeedMs = u16_val;
-    animSpeedMs = lastSettings.animSpeedMs;
-    // Estimate percentage from old speed (inverse mapping)
-    if (animSpeedMs <= 5) lastSettings.speedPercent = 100;
-    else if (animSpeedMs <= 10) lastSettings.speedPercent = 80;
-    else if (animSpeedMs <= 15) lastSettings.speedPercent = 60;
-    else if (animSpeedMs <= 20) lastSettings.speedPercent = 40;
-    else if (animSpeedMs <= 30) lastSettings.speedPercent = 20;
-    else lastSettings.speedPercent = 10;
-    Serial.printf("Loaded old animSpeedMs: %d ms, estimated speed percentage: %d%%\n", animSpeedMs, lastSettings.speedPercent);
-  } else {
-    Serial.println("WARNING: speedPercent not found in NVS (first boot after code upload?)");
-    lastSettings.speedPercent = 80; // Default speed percentage
-    animSpeedMs = 8; // Default is 80% which maps to 8ms (125 FPS)
-    if (animSpeedMs < 6) animSpeedMs = 6;
-    Serial.printf("Using default speedPercent=%d%%, animSpeedMs=%d ms\n", lastSettings.speedPercent, animSpeedMs);
-
-    // Force save the default speed to prevent future issues
-    Serial.println("Force-saving default speed settings...");
-    nvs_set_u8(nvs_handle, "speedPercent", lastSettings.speedPercent);
-    esp_err_t forceSaveErr = nvs_commit(nvs_handle);
-    if (forceSaveErr == ESP_OK) {
-      Serial.println("Default speed settings force-saved successfully");
-    } else {
-      Serial.printf("ERROR: Failed to force-save default speed: %s\n", esp_err_to_name(forceSaveErr));
-    }
-  }
-  if (nvs_get_i16(nvs_handle, "loopOffsetPx", &i16_val) == ESP_OK) {
-    lastSettings.loopOffsetPx = i16_val;
-    loopOffsetPx = lastSettings.loopOffsetPx;
-  }
-  if (nvs_get_u16(nvs_handle, "bgColor", &u16_val) == ESP_OK) {
-    lastSettings.bgColor = u16_val;
-    bgColor = lastSettings.bgColor;
-  }
-  if (nvs_get_u16(nvs_handle, "textColor", &u16_val) == ESP_OK) {  // ADD: Load text color
-    lastSettings.textColor = u16_val;
-    textColor = lastSettings.textColor;
-  }
-  if (nvs_get_u8(nvs_handle, "mode", &u8_val) == ESP_OK) {
-    lastSettings.mode = static_cast<DisplayMode>(u8_val);
-    currentMode = lastSettings.mode;
-  }
-  if (nvs_get_u8(nvs_handle, "hasText", &u8_val) == ESP_OK) {
-    lastSettings.hasText = (u8_val == 1);
-  }
-  if (nvs_get_u8(nvs_handle, "hasBgImage", &u8_val) == ESP_OK) {
-    lastSettings.hasBgImage = (u8_val == 1);
-    hasBgImage = lastSettings.hasBgImage;
+    if (u16_val <= 5) s.speedPercent = 100;
+    else if (u16_val <= 10) s.speedPercent = 80;
+    else if (u16_val <= 15) s.speedPercent = 60;
+    else if (u16_val <= 20) s.speedPercent = 40;
+    else if (u16_val <= 30) s.speedPercent = 20;
+    else s.speedPercent = 10;
+    found = true;
   }
-  if (nvs_get_u16(nvs_handle, "textWidth", &u16_val) == ESP_OK) {
-    lastSettings.textWidth = u16_val;
-    imgW = u16_val;
-  }
-  if (nvs_get_u16(nvs_handle, "textHeight", &u16_val) == ESP_OK) {
-    lastSettings.textHeight = u16_val;
-    imgH = u16_val;
+  if (nvs_get_i16(nvs_handle, "loopOffsetPx", &i16_val) == ESP_OK) { s.loopOffsetPx = i16_val; found = true; }
+  if (nvs_get_u16(nvs_handle, "bgColor", &u16_val) == ESP_OK) { s.bgColor = u16_val; found = true; }
+  if (nvs_get_u16(nvs_handle, "textColor", &u16_val) == ESP_OK) { s.textColor = u16_val; found = true; }
+  if (nvs_get_u8(nvs_handle, "mode", &u8_val) == ESP_OK && u8_val <= MODE_WIDGET) {
+    s.mode = static_cast<DisplayMode>(u8_val);
+    found = true;
   }
+  if (nvs_get_u8(nvs_handle, "hasText", &u8_val) == ESP_OK) { s.hasText = (u8_val == 1); found = true; }
+  if (nvs_get_u8(nvs_handle, "hasBgImage", &u8_val) == ESP_OK) { s.hasBgImage = (u8_val == 1); found = true; }
+  if (nvs_get_u16(nvs_handle, "textWidth", &u16_val) == ESP_OK) { s.textWidth = u16_val; found = true; }
+  if (nvs_get_u16(nvs_handle, "textHeight", &u16_val) == ESP_OK) { s.textHeight = u16_val; found = true; }
+  if (nvs_get_i16(nvs_handle, "scrollX", &i16_val) == ESP_OK) { s.scrollX = i16_val; found = true; }
+  if (nvs_get_u16(nvs_handle, "spacing", &u16_val) == ESP_OK) { s.spacing = u16_val; found = true; }
+  if (nvs_get_u32(nvs_handle, "savedTime", &u32_val) == ESP_OK) { s.savedTime = u32_val; found = true; }
+  if (nvs_get_i8(nvs_handle, "activeSlot", &i8_val) == ESP_OK) { s.activeSlot = i8_val; found = true; }
+  if (nvs_get_u8(nvs_handle, "brightness", &u8_val) == ESP_OK) { s.brightness = u8_val; found = true; }
+  return found;
+}
 
-  // Load animation state
-  uint32_t u32_val;
-  if (nvs_get_i16(nvs_handle, "scrollX", &i16_val) == ESP_OK) {
-    lastSettings.scrollX = i16_val;
-    scrollX = i16_val;
-  }
-  if (nvs_get_u16(nvs_handle, "spacing", &u16_val) == ESP_OK) {
-    lastSettings.spacing = u16_val;
-  }
-  if (nvs_get_u32(nvs_handle, "savedTime", &u32_val) == ESP_OK) {
-    lastSettings.savedTime = u32_val;
+// Store the migrated settings as a blob, then drop the per-key entries
+static void migrateLegacySettings(const LastSettings& s) {
+  nvs_handle_t nvs_handle;
+  if (nvs_open("storage", NVS_READWRITE, &nvs_handle) != ESP_OK) return;
+  if (writeSettingsBlob(nvs_handle, s)) {
+    for (const char* key : kLegacySettingsKeys) nvs_erase_key(nvs_handle, key);
+    nvs_commit(nvs_handle);
+    Serial.println("Migrated per-key settings to the settings blob");
   }
+  nvs_close(nvs_handle);
+}
 
-  if (nvs_get_u8(nvs_handle, "brightness", &u8_val) == ESP_OK) {
-    lastSettings.brightness = u8_val;
-    currentBrightness = u8_val;
-    if (dma_display) {
-      dma_display->setBrightness8(lastSettings.brightness);
-    }
+static void applyLoadedSettings(const LastSettings& s) {
+  lastSettings = s;
+  animate = s.animate;
+  animDir = s.animDir;
+  animSpeedMs = speedPercentToMs(s.speedPercent);
+  lastSettings.animSpeedMs = animSpeedMs;
+  loopOffsetPx = s.loopOffsetPx;
+  bgColor = s.bgColor;
+  textColor = s.textColor;
+  currentMode = s.mode;
+  hasBgImage = s.hasBgImage;
+  imgW = s.textWidth;
+  imgH = s.textHeight;
+  scrollX = s.scrollX;
+  gActiveSlot = s.activeSlot;
+  currentBrightness = (uint8_t)s.brightness;
+  applyPanelBrightness();
+}
+
+static void loadLastSettings() {
+  nvs_handle_t nvs_handle;
+  esp_err_t err = nvs_open("storage", NVS_READONLY, &nvs_handle);
+  if (err != ESP_OK) {
+    Serial.println("No saved settings found, using defaults");
+    return;
   }
 
+  // Start from the live defaults so missing legacy keys keep them
+  LastSettings s = captureLastSettings();
+
+  uint8_t blob[SETTINGS_MAX_BLOB];
+  size_t len = sizeof(blob);
+  bool loaded = nvs_get_blob(nvs_handle, SETTINGS_KEY, blob, &len) == ESP_OK && decodeLastSettings(blob, len, s);
+  bool migrate = false;
+  if (!loaded) {
+    migrate = readLegacySettings(nvs_handle, s);
+    loaded = migrate;
+  }
   nvs_close(nvs_handle);
-  Serial.println("Settings loaded from NVS");
+
+  if (loaded) {
+    applyLoadedSettings(s);
+    if (migrate) migrateLegacySettings(lastSettings);
+    Serial.printf("Settings loaded from NVS (speed %d%%, %d ms)\n", lastSettings.speedPercent, animSpeedMs);
+  } else {
+    Serial.println("No saved settings found, using defaults");
+  }
 
   // Load saved YouTube channel ID
   if (nvs_open("storage", NVS_READONLY, &nvs_handle) == ESP_OK) {
@@ -633,231 +1081,358 @@ static void loadLastSettings() {
     nvs_close(nvs_handle);
   }
 
-  // Animation restoration will be done after text is loaded in loadLastFrame
+  // Animation restoration will be done after text is loaded in loadLastContent
   Serial.println("Animation settings loaded - will restore after text data is loaded");
 }
 
-static void saveLastFrame() {
-  if (frameBuffer.empty()) return;
+// ================= Snapshots =================
+// The last shown content survives a restart as three snapshot files (see snapshot_file.h).
+// gSnapshotHash remembers what each file holds, so saving unchanged content costs a hash
+// over RAM and no flash write; it is learned from the file header on first use.
+static const char* const kSnapshotPath[SNAP_KINDS] = { "/last_frame.rgb565", "/last_text.dat", "/last_bg.rgb565" };
+static uint64_t gSnapshotHash[SNAP_KINDS] = {};   // content hash on flash, 0 = no file
+static bool gSnapshotKnown[SNAP_KINDS] = {};      // gSnapshotHash is up to date
+static uint32_t gSnapshotWrites = 0, gSnapshotSkips = 0, gSnapshotErrors = 0;
+
+static void learnSnapshotHash(SnapshotKind kind) {
+  if (gSnapshotKnown[kind]) return;
+  gSnapshotHash[kind] = 0;
+  File f = LittleFS.open(kSnapshotPath[kind], "r");
+  if (f) {
+    uint8_t raw[SNAPSHOT_HEADER];
+    SnapshotHeader h;
+    if (f.read(raw, sizeof(raw)) == sizeof(raw) && h.decode(raw) && h.kind == kind) gSnapshotHash[kind] = h.hash;
+    f.close();
+  }
+  gSnapshotKnown[kind] = true;
+}
 
-  // Save frame buffer to file
-  File file = LittleFS.open("/last_frame.rgb565", "w");
-  if (!file) {
-    Serial.println("Failed to open last frame file for writing");
-    return;
+// Write n payload segments under h unless the file already holds the same content
+static bool writeSnapshot(SnapshotHeader& h, const uint8_t* const* data, const size_t* bytes, int n) {
+  const SnapshotKind kind = (SnapshotKind)h.kind;
+  h.hashPayload(data, bytes, n);
+  learnSnapshotHash(kind);
+  if (gSnapshotHash[kind] == h.hash) { gSnapshotSkips++; return true; }
+
+  uint8_t header[SNAPSHOT_HEADER];
+  h.encode(header);
+  uint32_t crc = snapshotCrc(0, header, SNAPSHOT_CRC_OFFSET);
+  for (int i = 0; i < n; ++i) crc = snapshotCrc(crc, data[i], bytes[i]);
+  h.crc = crc;
+  h.encode(header);
+
+  const String path = kSnapshotPath[kind];
+  const String tmp = path + ".tmp";
+  File f = LittleFS.open(tmp, "w");
+  bool ok = (bool)f;
+  if (ok) {
+    size_t written = f.write(header, sizeof(header));
+    for (int i = 0; i < n; ++i) written += f.write(data[i], bytes[i]);
+    f.close();
+    ok = written == sizeof(header) + h.payloadBytes;
+  }
+  // The rename replaces the old snapshot in one step; until then it is still intact
+  ok = ok && LittleFS.rename(tmp, path);
+  if (!ok) {
+    LittleFS.remove(tmp);
+    gSnapshotKnown[kind] = false;
+    gSnapshotErrors++;
+    Serial.printf("Snapshot %s: write failed\n", path.c_str());
+    return false;
   }
+  gSnapshotHash[kind] = h.hash;
+  gSnapshotWrites++;
+  Serial.printf("Snapshot %s: %u bytes written\n", path.c_str(), (unsigned)h.payloadBytes);
+  return true;
+}
+
+static void removeSnapshot(SnapshotKind kind) {
+  learnSnapshotHash(kind);
+  if (!gSnapshotHash[kind]) return;
+  LittleFS.remove(kSnapshotPath[kind]);
+  gSnapshotHash[kind] = 0;
+}
 
-  size_t bytesToWrite = frameBuffer.size() * sizeof(uint16_t);
-  size_t written = file.write(reinterpret_cast<const uint8_t*>(frameBuffer.data()), bytesToWrite);
-  file.close();
+// Reads a snapshot payload in pieces and checks the CRC at the end
+struct SnapshotReader {
+  File f;
+  SnapshotHeader h;
+  uint32_t crc = 0;
+  uint32_t got = 0;
+
+  bool open(SnapshotKind kind) {
+    f = LittleFS.open(kSnapshotPath[kind], "r");
+    if (!f) return false;
+    uint8_t raw[SNAPSHOT_HEADER];
+    if (f.read(raw, sizeof(raw)) != sizeof(raw) || !h.decode(raw) || h.kind != kind ||
+        f.size() != SNAPSHOT_HEADER + h.payloadBytes) {
+      f.close();
+      Serial.printf("Snapshot %s: bad header, ignored\n", kSnapshotPath[kind]);
+      return false;
+    }
+    crc = snapshotCrc(0, raw, SNAPSHOT_CRC_OFFSET);
+    return true;
+  }
 
-  if (written == bytesToWrite) {
-    Serial.printf("Last frame saved: %u bytes\n", (unsigned)written);
-  } else {
-    Serial.printf("Error saving last frame: wrote %u of %u bytes\n", (unsigned)written, (unsigned)bytesToWrite);
+  bool read(void* dst, size_t n) {
+    if (got + n > h.payloadBytes || f.read(static_cast<uint8_t*>(dst), n) != n) return false;
+    crc = snapshotCrc(crc, static_cast<const uint8_t*>(dst), n);
+    got += n;
+    return true;
   }
 
-  // Also save background image data if present
-  if (hasBgImage && !bgPixels.empty()) {
-    File bgFile = LittleFS.open("/last_bg.rgb565", "w");
-    if (bgFile) {
-      size_t bgBytesToWrite = bgPixels.size() * sizeof(uint16_t);
-      size_t bgWritten = bgFile.write(reinterpret_cast<const uint8_t*>(bgPixels.data()), bgBytesToWrite);
-      bgFile.close();
-      Serial.printf("Background image saved: %u bytes\n", (unsigned)bgWritten);
+  // True when the whole payload was read and matches the CRC
+  bool finish() {
+    f.close();
+    const bool ok = got == h.payloadBytes && crc == h.crc;
+    if (ok) {
+      gSnapshotHash[h.kind] = h.hash;
+      gSnapshotKnown[h.kind] = true;
     } else {
-      Serial.println("Failed to save background image file");
-    }
-  }
-
-  // Also save text data if we have it (for animation restoration)
-  if (!textPixels.empty()) {
-    File textFile = LittleFS.open("/last_text.dat", "w");
-    if (textFile) {
-      // Save header with dimensions and color
-      uint8_t header[8];
-      header[0] = imgW & 255;
-      header[1] = (imgW >> 8) & 255;
-      header[2] = imgH & 255;
-      header[3] = (imgH >> 8) & 255;
-      header[4] = textAlpha.empty() ? 0 : 1; // Alpha flag
-      header[5] = textColor & 255;
-      header[6] = (textColor >> 8) & 255;
-      header[7] = 0; // Reserved
-      textFile.write(header, 8);
-
-      // Save text pixels
-      size_t textBytes = textPixels.size() * sizeof(uint16_t);
-      textFile.write(reinterpret_cast<const uint8_t*>(textPixels.data()), textBytes);
-
-      // Save alpha channel if present
-      if (!textAlpha.empty()) {
-        textFile.write(textAlpha.data(), textAlpha.size());
-      }
-
-      textFile.close();
-      Serial.printf("Text data saved: %u pixels\n", (unsigned)textPixels.size());
+      Serial.printf("Snapshot %s: checksum mismatch, ignored\n", kSnapshotPath[h.kind]);
     }
+    return ok;
   }
-}
-
-static void loadLastFrame() {
-  // Try to load text data first
-  File textFile = LittleFS.open("/last_text.dat", "r");
-  if (textFile) {
-    Serial.println("Loading saved text data...");
+};
 
-    // Read header
-    uint8_t header[8];
-    if (textFile.read(header, 8) == 8) {
-      uint16_t savedImgW = header[0] | (header[1] << 8);
-      uint16_t savedImgH = header[2] | (header[3] << 8);
-      bool hasAlpha = (header[4] == 1);
-      uint16_t savedTextColor = header[5] | (header[6] << 8);
-
-      // Restore text color
-      textColor = savedTextColor;
-      Serial.printf("Restored text color: 0x%04X\n", textColor);
-
-      // Load text pixels
-      size_t textPixelCount = savedImgW * savedImgH;
-      textPixels.resize(textPixelCount);
-      size_t textBytesToRead = textPixelCount * sizeof(uint16_t);
-      size_t textBytesRead = textFile.read(reinterpret_cast<uint8_t*>(textPixels.data()), textBytesToRead);
-
-      // Load alpha channel if present
-      if (hasAlpha && textBytesRead == textBytesToRead) {
-        textAlpha.resize(textPixelCount);
-        size_t alphaBytesRead = textFile.read(textAlpha.data(), textPixelCount);
-        if (alphaBytesRead == textPixelCount) {
-          Serial.printf("Text data loaded: %ux%u pixels with alpha\n", savedImgW, savedImgH);
-        } else {
-          Serial.printf("Error loading alpha channel: read %u of %u bytes\n", (unsigned)alphaBytesRead, (unsigned)textPixelCount);
-          textAlpha.clear();
-        }
-      } else {
-        textAlpha.clear();
-        Serial.printf("Text data loaded: %ux%u pixels without alpha\n", savedImgW, savedImgH);
-      }
+// Copy of everything the snapshots hold, taken under FrameLock and written without it
+struct PersistFrame {
+  BulkVector<uint16_t> frame, bg, text;
+  BulkVector<uint8_t> alpha;
+  uint16_t frameW = 0, frameH = 0;
+  uint16_t textW = 0, textH = 0, textColor = 0;
+  bool hasBg = false, hasText = false, tinted = false;
+};
 
-      if (textBytesRead == textBytesToRead) {
-        imgW = savedImgW;
-        imgH = savedImgH;
-      }
-    }
-    textFile.close();
+static void captureLastFrame(PersistFrame& p) {
+  p.frame.assign(frameBuffer.begin(), frameBuffer.end());
+  p.frameW = VIRT_W();
+  p.frameH = VIRT_H();
+  p.hasBg = hasBgImage && !bgPixels.empty();
+  if (p.hasBg) p.bg.assign(bgPixels.begin(), bgPixels.end());
+  else p.bg.clear();
+  p.hasText = hasTextImage();
+  p.tinted = textTinted;
+  p.textW = imgW;
+  p.textH = imgH;
+  p.textColor = textColor;
+  if (p.hasText) {
+    p.text.assign(textPixels.begin(), textPixels.end());
+    p.alpha.assign(textAlpha.begin(), textAlpha.end());
+  } else {
+    p.text.clear();
+    p.alpha.clear();
   }
+}
 
-  // Load the frame buffer
-  File file = LittleFS.open("/last_frame.rgb565", "r");
-  if (!file) {
-    Serial.println("No last frame file found");
-    return;
+static void writeLastFrame(const PersistFrame& p) {
+  if (p.frame.empty()) return;
+
+  SnapshotHeader frame;
+  frame.kind = SNAP_FRAME;
+  frame.w = p.frameW;
+  frame.h = p.frameH;
+  const uint8_t* frameData[1] = { reinterpret_cast<const uint8_t*>(p.frame.data()) };
+  const size_t frameBytes[1] = { p.frame.size() * sizeof(uint16_t) };
+  writeSnapshot(frame, frameData, frameBytes, 1);
+
+  // Background image, or none so that a stale one is not restored
+  if (p.hasBg) {
+    SnapshotHeader bg;
+    bg.kind = SNAP_BG;
+    bg.w = p.frameW;
+    bg.h = p.frameH;
+    const uint8_t* bgData[1] = { reinterpret_cast<const uint8_t*>(p.bg.data()) };
+    const size_t bgBytes[1] = { p.bg.size() * sizeof(uint16_t) };
+    writeSnapshot(bg, bgData, bgBytes, 1);
+  } else {
+    removeSnapshot(SNAP_BG);
   }
 
-  size_t fileSize = file.size();
-  size_t expectedSize = VIRT_W() * VIRT_H() * sizeof(uint16_t);
+  // Text bitmap for animation restoration: RGB565 pixels (none for alpha-only text), then alpha
+  if (p.hasText) {
+    SnapshotHeader text;
+    text.kind = SNAP_TEXT;
+    text.w = p.textW;
+    text.h = p.textH;
+    text.meta[0] = p.tinted ? 2 : (p.alpha.empty() ? 0 : 1); // 0 = RGB565, 1 = +alpha, 2 = alpha only
+    text.meta[1] = p.textColor & 255;
+    text.meta[2] = (p.textColor >> 8) & 255;
+    const uint8_t* textData[2] = { reinterpret_cast<const uint8_t*>(p.text.data()), p.alpha.data() };
+    const size_t textBytes[2] = { p.tinted ? 0 : p.text.size() * sizeof(uint16_t), p.alpha.size() };
+    writeSnapshot(text, textData, textBytes, 2);
+  }
+}
 
-  if (fileSize != expectedSize) {
-    Serial.printf("Last frame size mismatch: %u bytes, expected %u bytes\n", (unsigned)fileSize, (unsigned)expectedSize);
-    file.close();
-    return;
+// Boot fast path: the frame snapshot alone puts the last picture back on the panel, so it is
+// read and pushed right after the DMA driver starts. Returns whether a frame was shown.
+static bool showLastFrame() {
+  SnapshotReader frame;
+  if (!frame.open(SNAP_FRAME)) {
+    Serial.println("No last frame snapshot found");
+    return false;
+  }
+  if (frame.h.w != VIRT_W() || frame.h.h != VIRT_H()) {
+    frame.f.close();
+    Serial.printf("Last frame is %ux%u, panel is %dx%d\n", frame.h.w, frame.h.h, VIRT_W(), VIRT_H());
+    return false;
+  }
+  HotVector<uint16_t> pixels((size_t)VIRT_W() * VIRT_H());
+  const bool frameOk = frame.read(pixels.data(), pixels.size() * sizeof(uint16_t));
+  if (!frame.finish() || !frameOk) return false;
+  frameBuffer.swap(pixels);
+  if (vdisplay) {
+    vdisplay->drawRGBBitmap(0, 0, frameBuffer.data(), VIRT_W(), VIRT_H());
   }
+  Serial.printf("Last frame shown: %u bytes\n", (unsigned)frame.h.payloadBytes);
+  return true;
+}
 
-  // Resize frame buffer and load data
-  frameBuffer.resize(VIRT_W() * VIRT_H());
-  size_t read = file.read(reinterpret_cast<uint8_t*>(frameBuffer.data()), fileSize);
-  file.close();
-
-  if (read == fileSize) {
-    Serial.printf("Last frame loaded: %u bytes\n", (unsigned)read);
-
-    // Try to load background image if it exists
-    File bgFile = LittleFS.open("/last_bg.rgb565", "r");
-    if (bgFile) {
-      size_t bgFileSize = bgFile.size();
-      size_t expectedBgSize = VIRT_W() * VIRT_H() * sizeof(uint16_t);
-
-      if (bgFileSize == expectedBgSize) {
-        bgPixels.resize(VIRT_W() * VIRT_H());
-        size_t bgRead = bgFile.read(reinterpret_cast<uint8_t*>(bgPixels.data()), bgFileSize);
-        bgFile.close();
-
-        if (bgRead == bgFileSize) {
-          hasBgImage = true;
-          Serial.printf("Background image loaded: %u bytes\n", (unsigned)bgRead);
-        } else {
-          Serial.printf("Error loading background image: read %u of %u bytes\n", (unsigned)bgRead, (unsigned)bgFileSize);
-          bgPixels.clear();
-          hasBgImage = false;
-        }
-      } else {
-        Serial.printf("Background image size mismatch: %u bytes, expected %u bytes\n", (unsigned)bgFileSize, (unsigned)expectedBgSize);
-        bgFile.close();
-        hasBgImage = false;
-      }
-    } else {
-      Serial.println("No saved background image found");
-      hasBgImage = false;
+// Text, background and the marquee state that go with the frame shown at boot
+static void loadLastContent(bool frameShown) {
+  // Try to load text data first
+  SnapshotReader text;
+  if (text.open(SNAP_TEXT)) {
+    Serial.println("Loading saved text data...");
+    const uint8_t format = text.h.meta[0];
+    const bool alphaOnly = format == 2;
+    const size_t n = (size_t)text.h.w * text.h.h;
+    BulkVector<uint16_t> pixels(alphaOnly ? 0 : n);
+    BulkVector<uint8_t> alpha(format == 0 ? 0 : n);
+    const bool ok = format <= 2 && text.read(pixels.data(), pixels.size() * sizeof(uint16_t)) &&
+                    text.read(alpha.data(), alpha.size());
+    if (text.finish() && ok) {
+      textPixels.swap(pixels);
+      textAlpha.swap(alpha);
+      textTinted = alphaOnly;
+      textColor = (uint16_t)(text.h.meta[1] | (text.h.meta[2] << 8));
+      imgW = text.h.w;
+      imgH = text.h.h;
+      rebuildTextSpans();
+      Serial.printf("Text data loaded: %ux%u pixels%s, color 0x%04X\n", imgW, imgH,
+                    alphaOnly ? " (alpha only)" : (textAlpha.empty() ? "" : " with alpha"), textColor);
     }
+  }
 
-    // Display the last frame immediately
-    if (vdisplay && !frameBuffer.empty()) {
-      vdisplay->drawRGBBitmap(0, 0, frameBuffer.data(), VIRT_W(), VIRT_H());
-      Serial.println("Last frame displayed on startup");
+  if (!frameShown) return;
+
+  // Background image, if one was saved with the frame
+  hasBgImage = false;
+  SnapshotReader bg;
+  if (bg.open(SNAP_BG)) {
+    BulkVector<uint16_t> bgStage((size_t)bg.h.w * bg.h.h);
+    const bool ok = bg.h.w == VIRT_W() && bg.h.h == VIRT_H() && bg.read(bgStage.data(), bgStage.size() * sizeof(uint16_t));
+    if (bg.finish() && ok) {
+      bgPixels.swap(bgStage);
+      hasBgImage = true;
+      Serial.printf("Background image loaded: %u bytes\n", (unsigned)bg.h.payloadBytes);
     }
+  }
 
-    // Restore animation if needed - IMPROVED VERSION
-    if (lastSettings.animate && lastSettings.hasText && !textPixels.empty()) {
-      Serial.println("Restoring animation state with text and colors");
+  // Restore animation if needed - IMPROVED VERSION
+  if (lastSettings.animate && lastSettings.hasText && hasTextImage()) {
+    Serial.println("Restoring animation state with text and colors");
 
-      // Initialize basic animation state
-      baseY = (int)VIRT_H() / 2 - (int)imgH / 2 + userOffY;
-      currentMode = MODE_CLOCK; // Set to clock mode to enable animation loop
+    // Initialize basic animation state
+    baseY = (int)VIRT_H() / 2 - (int)imgH / 2 + userOffY;
+    currentMode = MODE_CLOCK; // Set to clock mode to enable animation loop
 
-      // Ensure all color settings are properly restored
-      Serial.printf("Restored colors - BG: 0x%04X, Text: 0x%04X\n", bgColor, textColor);
+    // Ensure all color settings are properly restored
+    Serial.printf("Restored colors - BG: 0x%04X, Text: 0x%04X\n", bgColor, textColor);
 
-      // Simple spacing calculation
-      int spacing = imgW + loopOffsetPx;
-      if (spacing < 1) spacing = 1;
+    // Pre-render one period of the text stream
+    buildMarqueeStrip();
 
-      // IMPROVED: Ensure enough copies for seamless scrolling
-      // Need enough copies to cover screen width + extra buffer
-      const int minCopiesNeeded = (VIRT_W() / spacing) + 2; // Minimum to cover screen
-      const int totalCopies = (minCopiesNeeded > 4) ? minCopiesNeeded : 4; // Always have at least 4 copies
-      heads.clear();
-      heads.reserve(totalCopies);
+    // Use saved scroll position if it is a valid phase, otherwise restart from the edge
+    if (lastSettings.scrollX != 0 && lastSettings.scrollX > -(int)imgW - stripW && lastSettings.scrollX <= VIRT_W()) {
+      scrollX = lastSettings.scrollX;
+      Serial.printf("Using saved scroll position: %d\n", scrollX);
+    } else {
+      resetMarqueePosition();
+      Serial.printf("Starting scroll from edge position %d\n", scrollX);
+    }
 
-      // Simple restart from beginning (no complex time compensation)
-      if (animDir < 0) { // left scrolling - start from right edge
-        for (int i = 0; i < totalCopies; i++) {
-          heads.push_back(VIRT_W() + (i * spacing));
-        }
-      } else { // right scrolling - start from left edge
-        for (int i = 0; i < totalCopies; i++) {
-          heads.push_back(-imgW - (i * spacing));
-        }
-      }
+    Serial.printf("Animation restored: spacing=%d, direction=%s, scrollX=%d, loopOffset=%d\n",
+                  stripW, (animDir < 0) ? "left" : "right", scrollX, loopOffsetPx);
 
-      // Use saved scroll position if valid, otherwise start fresh
-      if (lastSettings.scrollX != 0) {
-        scrollX = lastSettings.scrollX;
-        Serial.printf("Using saved scroll position: %d\n", scrollX);
-      } else {
-        scrollX = 0;
-        Serial.println("Starting scroll from position 0");
-      }
+    waitingRestart = false;
+  }
+}
 
-      Serial.printf("Animation restored: %d heads, spacing=%d, direction=%s, scrollX=%d, loopOffset=%d\n",
-                    totalCopies, spacing, (animDir < 0) ? "left" : "right", scrollX, loopOffsetPx);
+// ================= Persistence Task =================
+// Handlers call requestPersist() once the new content is on the panel and reply right away.
+// The writer task collects requests as notification bits, waits until they stop arriving for
+// PERSIST_IDLE_MS (or PERSIST_MAX_DELAY_MS at most, so a steady stream of uploads still gets
+// saved), then copies the state under FrameLock and writes the copy to NVS and LittleFS while
+// rendering and HTTP carry on.
+#define PERSIST_TASK_CORE 0
+#define PERSIST_TASK_PRIO 1
+#define PERSIST_IDLE_MS 1500
+#define PERSIST_MAX_DELAY_MS 5000
+
+enum : uint32_t { PERSIST_SETTINGS = 0x01, PERSIST_FRAME = 0x02, PERSIST_WIDGET = 0x04 };
+
+static TaskHandle_t gPersistTask = nullptr;
+static volatile uint32_t gPersistRequests = 0;  // requestPersist() calls
+static volatile uint32_t gPersistFlushes = 0;   // batches written
+static uint32_t gPersistDeferred = 0;           // requested while the task was not running
+
+static void flushPersist(uint32_t what) {
+  static PersistFrame frame;   // reused between flushes so the pool hands back the same blocks
+  LastSettings settings;
+  {
+    FrameLock lock;
+    if (what & PERSIST_SETTINGS) settings = captureLastSettings();
+    if (what & PERSIST_FRAME) captureLastFrame(frame);
+  }
+  if (what & PERSIST_SETTINGS) { PerfScope perf(gPerfSaveSettings); writeLastSettings(settings); }
+  if (what & PERSIST_FRAME) { PerfScope perf(gPerfSaveFrame); writeLastFrame(frame); }
+  if ((what & PERSIST_WIDGET) && !saveWidget()) Serial.println("Clock widget: save failed");
+  gPersistFlushes++;
+}
 
-      waitingRestart = false;
-      lastAnim = millis(); // Start animation immediately
+static void persistTask(void* arg) {
+  for (;;) {
+    uint32_t pending = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &pending, portMAX_DELAY);
+    const TickType_t first = xTaskGetTickCount();
+    for (;;) {
+      const TickType_t waited = xTaskGetTickCount() - first;
+      if (waited >= pdMS_TO_TICKS(PERSIST_MAX_DELAY_MS)) break;
+      TickType_t wait = pdMS_TO_TICKS(PERSIST_MAX_DELAY_MS) - waited;
+      if (wait > pdMS_TO_TICKS(PERSIST_IDLE_MS)) wait = pdMS_TO_TICKS(PERSIST_IDLE_MS);
+      uint32_t more = 0;
+      if (xTaskNotifyWait(0, UINT32_MAX, &more, wait) != pdTRUE) break;  // quiet long enough
+      pending |= more;
     }
-  } else {
-    Serial.printf("Error loading last frame: read %u of %u bytes\n", (unsigned)read, (unsigned)fileSize);
+    flushPersist(pending);
+  }
+}
+
+static void startPersistTask() {
+  if (gPersistTask) return;
+  if (xTaskCreatePinnedToCore(persistTask, "persist", 6144, nullptr, PERSIST_TASK_PRIO, &gPersistTask,
+                              PERSIST_TASK_CORE) != pdPASS) {
+    gPersistTask = nullptr;
+    Serial.println("Persist task: create failed, saves deferred");
+    return;
+  }
+  if (gPersistDeferred) {
+    xTaskNotify(gPersistTask, gPersistDeferred, eSetBits);
+    gPersistDeferred = 0;
+  }
+}
+
+// Ask for the current state to be saved soon; never blocks on flash. Callers hold FrameLock,
+// so without the task the bits are kept for it rather than flushed here.
+static void requestPersist(uint32_t what) {
+  gPersistRequests++;
+  if (gPersistTask) {
+    xTaskNotify(gPersistTask, what, eSetBits);
+    return;
   }
+  gPersistDeferred |= what;
+  startPersistTask();  // retried on every request until it succeeds
 }
 
 static int indexFromToken(const String& tok) {
@@ -882,7 +1457,7 @@ static int indexFromToken(const String& tok) {
 }
 
 // Serve a file from LittleFS
-static String contentTypeFor(const String& path) {
+static const char* contentTypeFor(const String& path) {
   if (path.endsWith(".html")) return "text/html; charset=utf-8";
   if (path.endsWith(".css")) return "text/css";
   if (path.endsWith(".js")) return "application/javascript";
@@ -909,332 +1484,1609 @@ static const char FALLBACK_HTML[] PROGMEM = R"HTML(
 </body>
 )HTML";
 
-void handleRoot() {
-  sendCORSHeaders();
-  File f = LittleFS.open("/index.html", "r");
-  if (!f) {
-    server.send_P(200, "text/html; charset=utf-8", FALLBACK_HTML);
-    return;
+// ETags learned on first serve (see static_assets.h). An entry is reused while the file keeps
+// its size and modification time; handlers that rewrite servable files also forget it.
+#define ASSET_TAG_MAX 48
+
+struct AssetTag {
+  String path;              // file actually sent, e.g. /components/main.js.gz
+  size_t size;
+  time_t mtime;
+  char etag[ASSET_ETAG_LEN];
+};
+static std::vector<AssetTag> gAssetTags;
+static uint32_t gAssetHits = 0, gAssetNotModified = 0, gAssetGzip = 0;
+
+// UI assets kept in PSRAM (see asset_cache.h); plain-text files (snapshots, slots, settings)
+// are never cached so rewrites of device state need no invalidation
+#define ASSET_CACHE_BUDGET (1024 * 1024)
+static AssetCache gAssetCache(ASSET_CACHE_BUDGET);
+
+static void forgetStaticAssets(const char* prefix) {
+  for (size_t i = gAssetTags.size(); i-- > 0;) {
+    if (gAssetTags[i].path.startsWith(prefix)) gAssetTags.erase(gAssetTags.begin() + i);
   }
-  server.streamFile(f, contentTypeFor("/index.html"));
-  f.close();
+  gAssetCache.invalidate(prefix);
 }
 
-// Generic file handler for CSS, JS, images, etc.
-void handleStaticFile() {
-  sendCORSHeaders();
-  String path = server.uri();
-  if (path == "/") {
-    path = "/index.html";
+static const char* assetEtag(const String& path, File& f) {
+  const size_t size = f.size();
+  const time_t mtime = f.getLastWrite();
+  for (AssetTag& t : gAssetTags) {
+    if (t.path == path) {
+      if (t.size == size && t.mtime == mtime) return t.etag;
+      forgetStaticAssets(path.c_str());
+      break;
+    }
   }
+  uint8_t buf[1024];
+  uint64_t h = SNAPSHOT_FNV_BASIS;
+  size_t n;
+  while ((n = f.read(buf, sizeof(buf))) > 0) h = snapshotHash(h, buf, n);
+  f.seek(0);
+  if (gAssetTags.size() >= ASSET_TAG_MAX) gAssetTags.erase(gAssetTags.begin());
+  gAssetTags.push_back(AssetTag{ path, size, mtime, {} });
+  formatAssetEtag(gAssetTags.back().etag, h);
+  return gAssetTags.back().etag;
+}
 
-  File f = LittleFS.open(path, "r");
-  if (!f) {
-    server.send(404, "text/plain", "File not found");
-    return;
-  }
+static bool cacheableAsset(const char* contentType) { return strcmp(contentType, "text/plain") != 0; }
 
-  String contentType = contentTypeFor(path);
-  server.streamFile(f, contentType);
-  f.close();
+// Read f (the bytes served for path) into the cache; nullptr if it does not fit or the read fails
+static const AssetCacheEntry* fillAssetCache(const String& path, bool acceptsGz, bool gz, const char* contentType, File& f) {
+  const size_t size = f.size();
+  if (size > gAssetCache.maxEntryBytes()) return nullptr;
+  BulkVector<uint8_t> bytes(size);
+  if (f.read(bytes.data(), size) != size) return nullptr;
+  return gAssetCache.insert(path.c_str(), acceptsGz, gz, contentType, std::move(bytes));
 }
 
-static uint16_t hexTo565(const String &hex) {
-  // Expect formats like "#RRGGBB" or "RRGGBB"
-  String s = hex;
-  if (s.startsWith("#")) s.remove(0,1);
-  if (s.length() != 6) return 0; // default black
-  auto h2 = [](char c)->uint8_t{ if(c>='0'&&c<='9')return c-'0'; c|=0x20; if(c>='a'&&c<='f')return c-'a'+10; return 0; };
-  uint8_t r = (h2(s[0])<<4) | h2(s[1]);
-  uint8_t g = (h2(s[2])<<4) | h2(s[3]);
-  uint8_t b = (h2(s[4])<<4) | h2(s[5]);
-  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+static void sendAssetHeaders(const String& path, const char* etag) {
+  server.sendHeader("ETag", etag);
+  server.sendHeader("Cache-Control", assetCacheControl(path.c_str()));
+  server.sendHeader("Vary", "Accept-Encoding");
+}
+
+static void sendCachedAsset(const String& path, const AssetCacheEntry& e) {
+  sendAssetHeaders(path, e.etag);
+  if (etagMatches(server.header("If-None-Match").c_str(), e.etag)) {
+    gAssetNotModified++;
+    server.send(304);
+    return;
+  }
+  if (e.gzip) {
+    gAssetGzip++;
+    server.sendHeader("Content-Encoding", "gzip");
+  }
+  // The server pulls straight from the cached bytes; the shared pointer keeps them alive
+  std::shared_ptr<const BulkVector<uint8_t>> bytes = e.bytes;
+  size_t pos = 0;
+  server.sendSource(200, e.contentType, (long long)bytes->size(), [bytes, pos](uint8_t* buf, size_t cap) mutable -> long {
+    const size_t n = std::min(cap, bytes->size() - pos);
+    memcpy(buf, bytes->data() + pos, n);
+    pos += n;
+    return (long)n;
+  });
+}
+
+// Load the UI into the cache before the server starts: the page and every module under
+// /components, as a gzip-accepting browser would request them. Fonts come in on first use.
+static void warmAssetCache() {
+  std::vector<String> paths = { "/index.html", "/style.css" };
+  std::vector<String> dirs = { "/components" };
+  while (!dirs.empty()) {
+    File dir = LittleFS.open(dirs.back());
+    dirs.pop_back();
+    if (!dir || !dir.isDirectory()) continue;
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+      const String p = f.path();
+      if (f.isDirectory()) dirs.push_back(p);
+      else if (!p.endsWith(".gz")) paths.push_back(p);
+      f.close();
+    }
+  }
+  for (const String& path : paths) {
+    const char* type = contentTypeFor(path);
+    if (!cacheableAsset(type)) continue;
+    const bool gz = LittleFS.exists(path + ".gz");
+    File f = LittleFS.open(gz ? path + ".gz" : path, "r");
+    if (!f) continue;
+    fillAssetCache(path, true, gz, type, f);
+    f.close();
+  }
+  gAssetCache.hits = gAssetCache.misses = 0;
+  Serial.printf("Asset cache warmed: %u files, %u bytes\n", (unsigned)gAssetCache.entries.size(), (unsigned)gAssetCache.used);
+}
+
+// Send path (or its .gz sibling) with caching headers; false when the file does not exist
+static bool serveStaticAsset(const String& path) {
+  const bool acceptsGz = acceptsGzip(server.header("Accept-Encoding").c_str());
+  const char* type = contentTypeFor(path);
+  if (const AssetCacheEntry* hit = gAssetCache.find(path.c_str(), acceptsGz)) {
+    gAssetHits++;
+    sendCachedAsset(path, *hit);
+    return true;
+  }
+  String sent = path;
+  if (acceptsGz && LittleFS.exists(path + ".gz")) sent += ".gz";
+  File f = LittleFS.open(sent, "r");
+  if (!f) return false;
+  gAssetHits++;
+  if (cacheableAsset(type)) {
+    if (const AssetCacheEntry* e = fillAssetCache(path, acceptsGz, sent.length() != path.length(), type, f)) {
+      f.close();
+      sendCachedAsset(path, *e);
+      return true;
+    }
+    f.seek(0);
+  }
+  const char* etag = assetEtag(sent, f);
+  sendAssetHeaders(path, etag);
+  if (etagMatches(server.header("If-None-Match").c_str(), etag)) {
+    f.close();
+    gAssetNotModified++;
+    server.send(304);
+    return true;
+  }
+  if (sent.length() != path.length()) gAssetGzip++;
+  // streamFile adds Content-Encoding: gzip itself for a .gz file with a non-gzip content type,
+  // and closes f once the body is out
+  server.streamFile(f, type);
+  return true;
+}
+
+void handleRoot() {
+  if (!serveStaticAsset("/index.html")) {
+    server.send_P(200, "text/html; charset=utf-8", FALLBACK_HTML);
+  }
+}
+
+// Generic file handler for CSS, JS, images, etc.
+void handleStaticFile() {
+  String path = server.uri();
+  if (path == "/") {
+    path = "/index.html";
+  }
+  if (!serveStaticAsset(path)) {
+    server.send(404, "text/plain", "File not found");
+  }
+}
+
+static uint16_t hexTo565(const String &hex) {
+  // Expect formats like "#RRGGBB" or "RRGGBB"
+  String s = hex;
+  if (s.startsWith("#")) s.remove(0,1);
+  if (s.length() != 6) return 0; // default black
+  auto h2 = [](char c)->uint8_t{ if(c>='0'&&c<='9')return c-'0'; c|=0x20; if(c>='a'&&c<='f')return c-'a'+10; return 0; };
+  uint8_t r = (h2(s[0])<<4) | h2(s[1]);
+  uint8_t g = (h2(s[2])<<4) | h2(s[3]);
+  uint8_t b = (h2(s[4])<<4) | h2(s[5]);
+  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// Drop the partially decoded text; the live text and the last strip are untouched
+static void discardTextUpload() {
+  BulkVector<uint16_t>().swap(textStagePixels);
+  BulkVector<uint8_t>().swap(textStageAlpha);
 }
 
 void handleUploadData() {
   HTTPUpload& up = server.upload();
   if (up.status == UPLOAD_FILE_START) {
     Serial.println("/upload: START");
-    uploadBuf.clear();
-    imgW = imgH = 0;
+    gUploadStartUs = esp_timer_get_time();
+    // Allow text wider than panel for scrolling animation
+    // Set reasonable limits: max 4x panel width for long text.
+    // Decoded into staging buffers: the render and persist tasks and other requests keep
+    // reading textPixels/textAlpha with the old imgW/imgH until END swaps them under the lock.
+    textUpload.begin(textStagePixels, textStageAlpha, (uint16_t)VIRT_W() * 4, (uint16_t)VIRT_H());
   } else if (up.status == UPLOAD_FILE_WRITE) {
-    uploadBuf.insert(uploadBuf.end(), up.buf, up.buf + up.currentSize);
+    const bool wasHeader = textUpload.state == ImageUploadDecoder::HEADER;
+    if (!textUpload.feed(up.buf, up.currentSize)) {
+      if (wasHeader) Serial.printf("Rejected invalid size: %ux%u (max: %ux%u)\n", textUpload.w, textUpload.h, textUpload.maxW, textUpload.maxH);
+      return;
+    }
+    if (wasHeader && textUpload.state == ImageUploadDecoder::PIXELS) {
+      Serial.printf("Parsed image size: %ux%u\n", textUpload.w, textUpload.h);
+    }
   } else if (up.status == UPLOAD_FILE_END) {
-    Serial.printf("/upload: END bytes=%u\n", (unsigned)uploadBuf.size());
-    if (uploadBuf.size() < 4) { server.send(400, "text/plain", "Bad image"); return; }
-    imgW = uploadBuf[0] | (uploadBuf[1] << 8);
-    imgH = uploadBuf[2] | (uploadBuf[3] << 8);
-    Serial.printf("Parsed image size: %ux%u\n", imgW, imgH);
-    // Allow text wider than panel for scrolling animation
-    // Set reasonable limits: max 4x panel width for long text
-    const uint16_t maxAllowedWidth = (uint16_t)VIRT_W() * 4;
-    if (imgW == 0 || imgH == 0 || imgW > maxAllowedWidth || imgH > (uint16_t)VIRT_H()) {
-      Serial.printf("Rejected invalid size: %ux%u (max: %ux%u)\n", imgW, imgH, maxAllowedWidth, (uint16_t)VIRT_H());
-      server.send(400, "text/plain", "Invalid size");
+    Serial.printf("/upload: END bytes=%u\n", (unsigned)up.totalSize);
+    if (!textUpload.finish()) {
+      const size_t n = (size_t)textUpload.w * (size_t)textUpload.h;
+      Serial.printf("/upload: %s (expected %u or %u bytes, got %u)\n", textUpload.error,
+                    (unsigned)(4 + n * 2), (unsigned)(4 + n * 3), (unsigned)up.totalSize);
+      discardTextUpload();
+      server.send(400, "text/plain", textUpload.error);
       return;
     }
-    size_t expected565 = 4 + (size_t)imgW * (size_t)imgH * 2;
-    size_t expectedA8_565 = 4 + (size_t)imgW * (size_t)imgH * 3;
-    Serial.printf("Expected sizes: RGB565=%u, A8+RGB565=%u, received=%u\n", (unsigned)expected565, (unsigned)expectedA8_565, (unsigned)uploadBuf.size());
-
-    if (uploadBuf.size() == expectedA8_565) {
-      // Parse A8 + RGB565 interleaved
-      Serial.printf("Parsing A8+RGB565 format\n");
-      textPixels.assign((size_t)imgW * (size_t)imgH, 0);
-      textAlpha.assign((size_t)imgW * (size_t)imgH, 0);
-      const uint8_t* p = &uploadBuf[4];
-      for (size_t i = 0; i < (size_t)imgW * (size_t)imgH; ++i) {
-        uint8_t a = *p++;
-        uint16_t pix = (uint16_t)p[0] | ((uint16_t)p[1] << 8); p += 2;
-        textAlpha[i] = a;
-        textPixels[i] = pix;
+    FrameLock lock;
+    textPixels.swap(textStagePixels);
+    textAlpha.swap(textStageAlpha);
+    discardTextUpload();
+    imgW = textUpload.w;
+    imgH = textUpload.h;
+    textTinted = textUpload.alphaOnly();
+    rebuildTextSpans();
+    Serial.printf("/upload: parsed %ux%u mode=%s spans=%u\n", imgW, imgH, uploadFormatName(textUpload.format), (unsigned)textSpans.spans.size());
+    // No response here; will be sent in the completion handler
+  } else if (up.status == UPLOAD_FILE_ABORTED) {
+    Serial.println("/upload: ABORTED");
+    discardTextUpload();
+  }
+}
+
+// Draw the current text with the current settings, static or as a marquee; caller holds the frame lock
+static void presentText() {
+  baseY = (int)VIRT_H() / 2 - (int)imgH / 2 + userOffY; // vertical center + offset
+  Serial.printf("Drawing text at center x~%d y=%d on %dx%d\n", (int)VIRT_W()/2, baseY, (int)VIRT_W(), (int)VIRT_H());
+  waitingRestart = false;
+  if (animate) {
+    // Pre-render one period of the continuous text stream
+    buildMarqueeStrip();
+    resetMarqueePosition();
+    Serial.printf("Marquee ready: spacing=%d, start scrollX=%d\n", stripW, scrollX);
+    // Compose offscreen then push: the text band plus whatever the previous text covered
+    int ux0 = 0, uy0 = baseY, ux1 = VIRT_W(), uy1 = baseY + (int)imgH;
+    clipToFrame(ux0, uy0, ux1, uy1);
+    unionWithDrawn(ux0, uy0, ux1, uy1);
+    renderMarqueeRect(ux0, uy0, ux1, uy1);
+    pushFrameRect(ux0, uy0, ux1, uy1);
+    setDrawnRect(0, baseY, VIRT_W(), baseY + (int)imgH);
+    // pace the render task at the new speed
+    applyScrollSpeed();
+  } else {
+    int16_t x = (int)VIRT_W() / 2 - (int)imgW / 2 + userOffX; // horizontal center + offset
+    // Only the new text rect and the previously drawn one need restoring and pushing
+    int ux0 = x, uy0 = baseY, ux1 = x + (int)imgW, uy1 = baseY + (int)imgH;
+    clipToFrame(ux0, uy0, ux1, uy1);
+    unionWithDrawn(ux0, uy0, ux1, uy1);
+    restoreBackgroundRect(ux0, uy0, ux1, uy1, contentBgImage(), bgColor);
+    // Clip once, then blend whole row spans; disabled panels are blacked out by the mask below
+    const int startX = (x < 0) ? -x : 0;
+    const int endX = (x + (int)imgW > VIRT_W()) ? (VIRT_W() - x) : (int)imgW;
+    for (int y=0; y<(int)imgH && startX < endX; ++y) {
+      int dstY = baseY + y;
+      if (dstY < 0 || dstY >= (int)VIRT_H()) continue;
+      size_t si = (size_t)y * imgW + (size_t)startX;
+      uint16_t* dst = &frameBuffer[(size_t)dstY * (size_t)VIRT_W() + (size_t)(x + startX)];
+      if (textTinted) {
+        if (textSpans.empty()) continue;
+        const size_t rowBase = (size_t)y * imgW;
+        blitSpanRowSolid(dst, textColor, &textAlpha[rowBase], textSpans.rowBegin(y), textSpans.rowEnd(y), startX, endX);
+      } else if (!textSpans.empty()) {
+        const size_t rowBase = (size_t)y * imgW;
+        blitSpanRow(dst, &textPixels[rowBase], &textAlpha[rowBase], textSpans.rowBegin(y), textSpans.rowEnd(y), startX, endX);
+      } else if (!textAlpha.empty()) {
+        blendRow565(dst, &textPixels[si], &textAlpha[si], endX - startX);
+      } else {
+        memcpy(dst, &textPixels[si], (size_t)(endX - startX) * sizeof(uint16_t));
+      }
+    }
+    maskDisabledPanels(uy0, uy1);
+    pushFrameRect(ux0, uy0, ux1, uy1);
+    // Remember only the inked area so the next upload restores as little as possible
+    if (!textSpans.empty()) {
+      if (textSpans.inkX1 > textSpans.inkX0) {
+        setDrawnRect(x + textSpans.inkX0, baseY + textSpans.inkY0, x + textSpans.inkX1, baseY + textSpans.inkY1);
+      } else {
+        setDrawnRect(0, 0, 0, 0);
       }
-    } else if (uploadBuf.size() == expected565) {
-      // Legacy RGB565 only
-      Serial.printf("Parsing RGB565 format\n");
-      const uint16_t* pixels = reinterpret_cast<const uint16_t*>(&uploadBuf[4]);
-      textPixels.assign(pixels, pixels + (imgW * imgH));
-      textAlpha.clear();
     } else {
-      Serial.printf("Size mismatch error: expected %u or %u bytes, got %u\n", (unsigned)expected565, (unsigned)expectedA8_565, (unsigned)uploadBuf.size());
-      server.send(400, "text/plain", "Size mismatch");
-      return;
+      setDrawnRect(x, baseY, x + (int)imgW, baseY + (int)imgH);
     }
-    Serial.printf("/upload: parsed %ux%u mode=%s\n", imgW, imgH, textAlpha.empty()?"RGB565":"A8+RGB565");
-    // No response here; will be sent in the completion handler
   }
+
+}
+
+// Live display settings, as /upload and the content slots describe them
+static ContentSettings currentContentSettings() {
+  ContentSettings s;
+  s.bgColor = bgColor;
+  s.textColor = textColor;
+  s.animate = animate;
+  s.animDir = animDir;
+  s.speedPercent = lastSettings.speedPercent;
+  s.loopOffsetPx = loopOffsetPx;
+  s.brightness = currentBrightness;
+  s.bgImage = hasBgImage;
+  return s;
+}
+
+// Overlay the upload query args; anything missing gets /upload's defaults
+static void contentSettingsFromArgs(ContentSettings& s) {
+  s.bgColor = hexTo565(server.arg("bg"));
+  // Alpha-only text is tinted with this, so keep the previous color when none is sent
+  if (server.hasArg("color")) s.textColor = hexTo565(server.arg("color"));
+  s.animate = (server.arg("animate") == "1");
+  s.animDir = (server.arg("dir") == "right") ? 1 : -1;
+  // Speed mapping: 10% = 50ms (slow), 100% = 6ms (fast), default 80%
+  s.speedPercent = server.hasArg("speed") ? constrain(server.arg("speed").toInt(), 10, 100) : 80;
+  s.loopOffsetPx = server.hasArg("interval") ? constrain(server.arg("interval").toInt(), 1, 300) : 5;
+  // brightness percent 0..100
+  if (server.hasArg("brightness")) {
+    int bp = constrain(server.arg("brightness").toInt(), 0, 100);
+    s.setBrightness = true;
+    s.brightness = (uint8_t)((bp * 255) / 100);
+  }
+  // Clear cached bg image if switching to plain color
+  if (server.hasArg("bgMode") && server.arg("bgMode") == "color") s.bgImage = false;
+}
+
+static void applyContentSettings(const ContentSettings& s) {
+  bgColor = s.bgColor;
+  textColor = s.textColor;
+  animate = s.animate;
+  animDir = s.animDir;
+  lastSettings.speedPercent = s.speedPercent;
+  animSpeedMs = speedPercentToMs(s.speedPercent);
+  loopOffsetPx = s.loopOffsetPx;
+  if (s.setBrightness) currentBrightness = s.brightness;
+  applyPanelBrightness();
+  hasBgImage = s.bgImage;
 }
 
 void handleUploadDone() {
-  sendCORSHeaders();
+  FrameLock lock;
 
+  // The widget paints its own background color, so leaving it invalidates the whole frame
+  const bool wasWidget = currentMode == MODE_WIDGET;
   // Stop theme mode if it was running
   if (currentMode == MODE_THEME) {
     Serial.println("Stopping theme mode, switching to clock mode");
   }
   currentMode = MODE_CLOCK;
+  gActiveSlot = -1;  // ad-hoc content, not a stored slot
 
   // Read options - force centering but USE ANIMATION SETTINGS
-  bgColor = hexTo565(server.arg("bg"));
-  textColor = hexTo565(server.arg("color"));  // ADD: Read text color from upload
+  const uint16_t prevBgColor = bgColor;
+  const bool prevBgImage = hasBgImage;
+  ContentSettings settings = currentContentSettings();
+  contentSettingsFromArgs(settings);
+  applyContentSettings(settings);
   userOffX = 0; // Force center horizontally
   userOffY = 0; // Force center vertically
 
-  // FIX: Read animation parameters from client instead of hardcoding
-  animate = (server.arg("animate") == "1");
-  animDir = (server.arg("dir") == "right") ? 1 : -1;
-  // Speed mapping: 10% = 40ms (slow), 100% = 2ms (fast), with proper interpolation
-  if (server.hasArg("speed")) {
-    int speedPercent = constrain(server.arg("speed").toInt(), 10, 100);
-    // Save both the percentage and the calculated milliseconds
-    lastSettings.speedPercent = speedPercent;
-    // Reverse mapping: higher percentage = faster animation = lower delay
-    // Aggressive speed mapping: 10% = 50ms (20 FPS), 100% = 12.5ms (80 FPS)
-    // Special mapping for specific percentages:
-    int targetMs;
-    if (speedPercent == 10) {
-      targetMs = 50;    // 0.5x of 100% speed (20 FPS)
-    } else if (speedPercent == 20) {
-      targetMs = 25;    // Same as current 100% speed (40 FPS)
-    } else if (speedPercent == 40) {
-      targetMs = 17;    // 1.5x faster than current 100% (59 FPS)
-    } else if (speedPercent == 60) {
-      targetMs = 13;    // 2x faster than current 100% (77 FPS)
-    } else if (speedPercent == 80) {
-      targetMs = 8;     // 3.5x faster than current 100% (125 FPS)
-    } else if (speedPercent == 100) {
-      targetMs = 6;     // 4x faster than current 100% (167 FPS)
-    } else {
-      // Linear interpolation between specific points
-      targetMs = map(speedPercent, 10, 100, 50, 6);
-    }
-    animSpeedMs = targetMs;
-    // Ensure minimum delay for ultra-fast scrolling
-    if (animSpeedMs < 6) animSpeedMs = 6;
-    Serial.printf("Upload: speedPercent=%d%%, calculated animSpeedMs=%d ms\n", speedPercent, animSpeedMs);
-  } else {
-    lastSettings.speedPercent = 80; // Default speed percentage
-    animSpeedMs = 8; // Default is 80% which maps to 8ms (125 FPS)
-    Serial.printf("Upload: using default speedPercent=%d%%, animSpeedMs=%d ms\n", lastSettings.speedPercent, animSpeedMs);
-  }
-  loopOffsetPx = server.hasArg("interval") ? constrain(server.arg("interval").toInt(), 1, 300) : 5;
-
   // DEBUG: Print animation settings to Serial
-  Serial.printf("Animation settings: animate=%s, dir=%s, speed=%d ms, interval=%d px\n",
+  Serial.printf("Animation settings: animate=%s, dir=%s, speed=%d%% (%d ms), interval=%d px\n",
                 animate ? "true" : "false",
                 (animDir == -1) ? "left" : "right",
-                animSpeedMs, loopOffsetPx);
-  // brightness percent 0..100
-  if (server.hasArg("brightness")) {
-    int bp = constrain(server.arg("brightness").toInt(), 0, 100);
-    uint8_t b8 = (uint8_t)((bp * 255) / 100);
-    currentBrightness = b8;
-    dma_display->setBrightness8(b8);
-  }
-  // Clear cached bg image if switching to plain color
-  if (server.hasArg("bgMode") && server.arg("bgMode") == "color") {
-    hasBgImage = false;
-  }
+                lastSettings.speedPercent, animSpeedMs, loopOffsetPx);
+  // A different background invalidates every pixel outside the text
+  if (bgColor != prevBgColor || hasBgImage != prevBgImage || wasWidget) frameSynced = false;
 
   // If we have a bitmap, either draw once or start animating
-  if (!textPixels.empty()) {
-    baseY = (int)VIRT_H() / 2 - (int)imgH / 2 + userOffY; // vertical center + offset
-    Serial.printf("/upload: drawing at center x~%d y=%d on %dx%d\n", (int)VIRT_W()/2, baseY, (int)VIRT_W(), (int)VIRT_H());
-    waitingRestart = false;
-    if (animate) {
-      // Initialize multi-head array for continuous text stream
-      int gap = (int)loopOffsetPx;
-      int spacing = (int)imgW + gap; if (spacing < 1) spacing = 1;
-
-      // Calculate how many copies we need to fill the screen + buffer
-      const int totalCopies = ((VIRT_W() + spacing * 2) / spacing) + 3;
-      heads.clear();
-      heads.reserve(totalCopies);
-
-      if (animDir < 0) { // left scrolling - start from right edge
-        for (int i = 0; i < totalCopies; i++) {
-          heads.push_back(VIRT_W() + (i * spacing));
-        }
-      } else { // right scrolling - start from left edge
-        for (int i = 0; i < totalCopies; i++) {
-          heads.push_back(-imgW - (i * spacing));
-        }
-      }
+  if (hasTextImage()) {
+    presentText();
 
-      Serial.printf("Initialized %d heads for continuous scrolling\n", totalCopies);
-      // Compose full frame offscreen then push
-      if (hasBgImage && bgPixels.size() == frameBuffer.size()) {
-        frameBuffer = bgPixels;
-      } else {
-        std::fill(frameBuffer.begin(), frameBuffer.end(), bgColor);
-      }
-      auto blitAt = [&](int xPos){
-        int16_t x0 = xPos + userOffX;
-        for (int y=0; y<(int)imgH; ++y) {
-          int dstY = baseY + y;
-          if (dstY < 0 || dstY >= (int)VIRT_H()) continue;
-          int srcRow = y * imgW;
-          for (int x=0; x<(int)imgW; ++x) {
-            int dstX = x0 + x;
-            if (dstX < 0 || dstX >= (int)VIRT_W()) continue;
-            size_t si = (size_t)srcRow + (size_t)x;
-            size_t di = (size_t)dstY * (size_t)VIRT_W() + (size_t)dstX;
-            if (di >= frameBuffer.size()) continue;
-            if (!g_panel_active.empty()) {
-              int pidx = panelIndexFromXY(dstX, dstY);
-              if (pidx >= 0 && pidx < (int)g_panel_active.size() && g_panel_active[pidx] == 0) continue;
-            }
-            if (!textAlpha.empty()) {
-              uint8_t a = textAlpha[si];
-              if (a == 0) continue;
-              uint16_t dst = frameBuffer[di];
-              uint16_t src = textPixels[si];
-              frameBuffer[di] = blend565(src, dst, a);
-            } else {
-              frameBuffer[di] = textPixels[si];
-            }
-          }
-        }
-      };
-      // Draw all heads for continuous text stream
-      for (int i = 0; i < (int)heads.size(); i++) {
-        blitAt(heads[i]);
-      }
-      maskDisabledPanels();
-      vdisplay->drawRGBBitmap(0, 0, frameBuffer.data(), VIRT_W(), VIRT_H());
-      // ensure animation starts moving immediately on next loop
-      lastAnim = millis() - animSpeedMs;
-    } else {
-      if (hasBgImage && bgPixels.size() == frameBuffer.size()) {
-        frameBuffer = bgPixels;
-      } else {
-        std::fill(frameBuffer.begin(), frameBuffer.end(), bgColor);
-      }
-      int16_t x = (int)VIRT_W() / 2 - (int)imgW / 2 + userOffX; // horizontal center + offset
-      for (int y=0; y<(int)imgH; ++y) {
-        int dstY = baseY + y;
-        if (dstY < 0 || dstY >= (int)VIRT_H()) continue;
-        int srcRow = y * imgW;
-        for (int x2=0; x2<(int)imgW; ++x2) {
-          int dstX = x + x2;
-          if (dstX < 0 || dstX >= (int)VIRT_W()) continue;
-          size_t si = (size_t)srcRow + (size_t)x2;
-          size_t di = (size_t)dstY * (size_t)VIRT_W() + (size_t)dstX;
-          if (di >= frameBuffer.size()) continue;
-          if (!g_panel_active.empty()) {
-            int pidx = panelIndexFromXY(dstX, dstY);
-            if (pidx >= 0 && pidx < (int)g_panel_active.size() && g_panel_active[pidx] == 0) continue;
-          }
-          if (!textAlpha.empty()) {
-            uint8_t a = textAlpha[si];
-            if (a == 0) continue;
-            uint16_t dst = frameBuffer[di];
-            uint16_t src = textPixels[si];
-            frameBuffer[di] = blend565(src, dst, a);
-          } else {
-            frameBuffer[di] = textPixels[si];
-          }
-        }
-      }
-      maskDisabledPanels();
-      vdisplay->drawRGBBitmap(0, 0, frameBuffer.data(), VIRT_W(), VIRT_H());
+    // Request-to-first-frame latency for this upload
+    if (gUploadStartUs) {
+      gPerfFirstFrame.record((uint32_t)(esp_timer_get_time() - gUploadStartUs));
+      gUploadStartUs = 0;
     }
 
-    // Save settings and last frame
-    saveLastSettings();
-    saveLastFrame();
+    // Saved by the persistence task once uploads settle
+    requestPersist(PERSIST_SETTINGS | PERSIST_FRAME);
   }
   server.send(200, "text/plain", "OK");
 }
 
+// Copy a bw x bh RGB565 image centered onto a panel-sized canvas filled with fill
+static void centerOnPanel(BulkVector<uint16_t>& dst, const uint16_t* src, uint16_t bw, uint16_t bh, uint16_t fill) {
+  dst.assign((size_t)VIRT_W() * (size_t)VIRT_H(), fill);
+  int offx = ((int)VIRT_W() - (int)bw) / 2;
+  int offy = ((int)VIRT_H() - (int)bh) / 2;
+  for (int y=0; y<(int)bh; ++y) {
+    int dy = offy + y; if (dy < 0 || dy >= (int)VIRT_H()) continue;
+    for (int x=0; x<(int)bw; ++x) {
+      int dx = offx + x; if (dx < 0 || dx >= (int)VIRT_W()) continue;
+      dst[(size_t)dy * VIRT_W() + (size_t)dx] = src[(size_t)y * bw + (size_t)x];
+    }
+  }
+}
+
 // Handle background image upload at /upload_bg
 // Expects RGB565 little-endian with 4-byte header [wL,wH,hL,hH]
 void handleUploadBgData() {
   HTTPUpload& up = server.upload();
-  static std::vector<uint8_t> buf;
-  static uint16_t bw = 0, bh = 0;
+  // Decoded into a staging image; bgPixels is only touched under the frame lock at END
+  static ImageUploadDecoder decoder;
+  static BulkVector<uint16_t> stage;
+  static BulkVector<uint8_t> unusedAlpha;
   if (up.status == UPLOAD_FILE_START) {
-    buf.clear(); bw = bh = 0;
+    decoder.begin(stage, unusedAlpha, (uint16_t)VIRT_W() * 2, (uint16_t)VIRT_H() * 2, true);
   } else if (up.status == UPLOAD_FILE_WRITE) {
-    buf.insert(buf.end(), up.buf, up.buf + up.currentSize);
+    decoder.feed(up.buf, up.currentSize);
+  } else if (up.status == UPLOAD_FILE_ABORTED) {
+    BulkVector<uint16_t>().swap(stage);
   } else if (up.status == UPLOAD_FILE_END) {
-    if (buf.size() < 4) { server.send(400, "text/plain", "Bad image"); return; }
-    bw = buf[0] | (buf[1] << 8);
-    bh = buf[2] | (buf[3] << 8);
-    size_t expected = 4 + (size_t)bw * (size_t)bh * 2;
-    if (buf.size() != expected) { server.send(400, "text/plain", "Size mismatch"); return; }
+    if (!decoder.finish()) {
+      Serial.printf("/upload_bg: %s (%u bytes)\n", decoder.error, (unsigned)up.totalSize);
+      BulkVector<uint16_t>().swap(stage);
+      server.send(400, "text/plain", decoder.error);
+      return;
+    }
+    FrameLock lock;
     // Resize bgPixels to panel size and blit (centered if different size)
-    bgPixels.assign((size_t)VIRT_W() * (size_t)VIRT_H(), bgColor);
-    const uint16_t* src = reinterpret_cast<const uint16_t*>(&buf[4]);
-    int offx = ((int)VIRT_W() - (int)bw) / 2;
-    int offy = ((int)VIRT_H() - (int)bh) / 2;
-    for (int y=0; y<(int)bh; ++y) {
-      int dy = offy + y; if (dy < 0 || dy >= (int)VIRT_H()) continue;
-      for (int x=0; x<(int)bw; ++x) {
-        int dx = offx + x; if (dx < 0 || dx >= (int)VIRT_W()) continue;
-        bgPixels[(size_t)dy * VIRT_W() + (size_t)dx] = src[(size_t)y * bw + (size_t)x];
+    centerOnPanel(bgPixels, stage.data(), decoder.w, decoder.h, bgColor);
+    BulkVector<uint16_t>().swap(stage);
+    hasBgImage = true;
+    frameSynced = false;
+    gStreamSeq = 0;
+    // A running marquee was resolved against the old background; re-render its strip
+    if (animate && hasTextImage()) buildMarqueeStrip();
+    // Show background immediately if no text
+    if (!hasTextImage()) {
+      if (bgPixels.size() == (size_t)VIRT_W() * (size_t)VIRT_H()) {
+        vdisplay->drawRGBBitmap(0, 0, bgPixels.data(), VIRT_W(), VIRT_H());
+        // Save background as last frame
+        frameBuffer.assign(bgPixels.begin(), bgPixels.end());
+        setDrawnRect(0, 0, 0, 0);
+        requestPersist(PERSIST_SETTINGS | PERSIST_FRAME);
+      } else {
+        vdisplay->fillScreen(bgColor);
       }
     }
-    hasBgImage = true;
-    // Show background immediately if no text
-    if (textPixels.empty()) {
-      if (bgPixels.size() == (size_t)VIRT_W() * (size_t)VIRT_H()) {
-        vdisplay->drawRGBBitmap(0, 0, bgPixels.data(), VIRT_W(), VIRT_H());
-        // Save background as last frame
-        frameBuffer = bgPixels;
-        saveLastSettings();
-        saveLastFrame();
-      } else {
-        vdisplay->fillScreen(bgColor);
-      }
+  }
+}
+
+void handleUploadBgDone() {
+  // No additional args needed; just acknowledge
+  server.send(200, "text/plain", "OK");
+}
+
+// ================= Content Slots =================
+// Stored content activated by ID (see content_slots.h). /slot_upload stores the text (form
+// part "text", sent first), an optional background (part "bg") and the /upload settings args
+// in one request; /slot_activate puts a slot on the panel. Slot pixels stay resident in PSRAM
+// within gSlotBudget, least recently used slots dropping out first, so activating a resident
+// slot is a copy and a redraw; the others are read back from LittleFS.
+#define SLOT_DIR "/slots"
+
+struct ContentSlot {
+  bool used = false;
+  bool resident = false;      // pixels below are loaded
+  uint32_t lastUse = 0;
+  ContentSlotMeta meta;
+  BulkVector<uint16_t> text;
+  BulkVector<uint8_t> alpha;
+  BulkVector<uint16_t> bg;
+
+  size_t residentBytes() const { return text.size() * 2 + alpha.size() + bg.size() * 2; }
+  void drop() {
+    BulkVector<uint16_t>().swap(text);
+    BulkVector<uint8_t>().swap(alpha);
+    BulkVector<uint16_t>().swap(bg);
+    resident = false;
+  }
+};
+
+static ContentSlot contentSlots[CONTENT_SLOT_COUNT];
+static size_t gSlotBudget = 0;          // bytes of slot pixels kept in RAM, set at boot
+static uint32_t gSlotUseClock = 0;
+
+static String slotPath(int id) {
+  return String(SLOT_DIR "/") + String(id) + ".bin";
+}
+
+// Drop least recently used slot pixels until the resident set fits the budget
+static void trimSlotResidency(int keep, int keep2 = -1) {
+  for (;;) {
+    size_t total = 0;
+    int victim = -1;
+    for (int id = 0; id < CONTENT_SLOT_COUNT; ++id) {
+      const ContentSlot& s = contentSlots[id];
+      if (!s.resident) continue;
+      total += s.residentBytes();
+      if (id != keep && id != keep2 && (victim < 0 || s.lastUse < contentSlots[victim].lastUse)) victim = id;
+    }
+    if (total <= gSlotBudget) return;
+    if (victim < 0) victim = keep2 >= 0 ? keep2 : keep;  // even the kept slots do not fit: the active one is on the panel already
+    if (victim < 0 || !contentSlots[victim].resident) return;
+    contentSlots[victim].drop();
+  }
+}
+
+// Slot pixels are read from flash in chunks so the playlist can load the next entry between
+// loop() passes without holding up HTTP; activating a slot that is not resident finishes the
+// read in one go.
+#define SLOT_PRELOAD_CHUNK 8192
+
+struct SlotPreload {
+  int id = -1;                // slot being read, -1 when idle
+  File file;
+  size_t done = 0;            // pixel bytes read so far
+};
+static SlotPreload slotPreload;
+
+static void cancelSlotPreload() {
+  if (slotPreload.id < 0) return;
+  slotPreload.file.close();
+  contentSlots[slotPreload.id].drop();
+  slotPreload.id = -1;
+}
+
+static bool startSlotPreload(int id) {
+  if (slotPreload.id == id) return true;
+  cancelSlotPreload();
+  ContentSlot& slot = contentSlots[id];
+  if (!slot.used || slot.resident) return slot.resident;
+  const ContentSlotMeta& m = slot.meta;
+  File f = LittleFS.open(slotPath(id), "r");
+  if (!f || f.size() != m.fileBytes() || !f.seek(CONTENT_SLOT_HEADER)) {
+    if (f) f.close();
+    Serial.printf("Slot %d: open failed\n", id);
+    return false;
+  }
+  slot.text.resize(m.textPixelBytes() / 2);
+  slot.alpha.resize(m.alphaBytes());
+  slot.bg.resize(m.bgBytes() / 2);
+  slotPreload.id = id;
+  slotPreload.file = f;
+  slotPreload.done = 0;
+  return true;
+}
+
+// Read the next chunk of the slot being preloaded; false once the preload ended (or failed)
+static bool stepSlotPreload() {
+  if (slotPreload.id < 0) return false;
+  const int id = slotPreload.id;
+  ContentSlot& slot = contentSlots[id];
+  const ContentSlotMeta& m = slot.meta;
+  // The file is the three planes back to back; find the one the next chunk falls in
+  const size_t planes[3] = { m.textPixelBytes(), m.alphaBytes(), m.bgBytes() };
+  uint8_t* dst[3] = { reinterpret_cast<uint8_t*>(slot.text.data()), slot.alpha.data(), reinterpret_cast<uint8_t*>(slot.bg.data()) };
+  size_t off = slotPreload.done;
+  int p = 0;
+  while (p < 3 && off >= planes[p]) off -= planes[p++];
+  if (p < 3) {
+    const size_t n = std::min((size_t)SLOT_PRELOAD_CHUNK, planes[p] - off);
+    if (slotPreload.file.read(dst[p] + off, n) != n) {
+      Serial.printf("Slot %d: read failed (%ux%u)\n", id, m.textW, m.textH);
+      cancelSlotPreload();
+      return false;
+    }
+    slotPreload.done += n;
+    if (slotPreload.done < planes[0] + planes[1] + planes[2]) return true;
+  }
+  slotPreload.file.close();
+  slotPreload.id = -1;
+  slot.resident = true;
+  slot.lastUse = ++gSlotUseClock;
+  Serial.printf("Slot %d: loaded %u pixels from flash\n", id, (unsigned)((size_t)m.textW * m.textH));
+  trimSlotResidency(gActiveSlot, id);
+  return false;
+}
+
+// Written next to the old file and renamed over it, like the snapshots: a power cut or a full
+// filesystem leaves the previous slot intact instead of a truncated one
+static bool writeSlotFile(const ContentSlot& slot, int id) {
+  const String path = slotPath(id);
+  const String tmp = path + ".tmp";
+  File f = LittleFS.open(tmp, "w");
+  bool ok = (bool)f;
+  if (ok) {
+    const ContentSlotMeta& m = slot.meta;
+    uint8_t header[CONTENT_SLOT_HEADER];
+    m.encode(header);
+    size_t written = f.write(header, sizeof(header));
+    written += f.write(reinterpret_cast<const uint8_t*>(slot.text.data()), m.textPixelBytes());
+    written += f.write(slot.alpha.data(), m.alphaBytes());
+    written += f.write(reinterpret_cast<const uint8_t*>(slot.bg.data()), m.bgBytes());
+    f.close();
+    ok = written == m.fileBytes();
+  }
+  ok = ok && LittleFS.rename(tmp, path);
+  if (!ok) LittleFS.remove(tmp);
+  return ok;
+}
+
+// Scan the slot files at boot; only headers are read, pixels load on first activation
+static void loadContentSlotIndex() {
+  LittleFS.mkdir(SLOT_DIR);
+  const size_t psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+  gSlotBudget = std::min(psram / 4, (size_t)1024 * 1024);
+  int found = 0;
+  for (int id = 0; id < CONTENT_SLOT_COUNT; ++id) {
+    ContentSlot& slot = contentSlots[id];
+    File f = LittleFS.open(slotPath(id), "r");
+    if (!f) continue;
+    uint8_t header[CONTENT_SLOT_HEADER];
+    slot.used = f.read(header, sizeof(header)) == sizeof(header) && slot.meta.decode(header) &&
+                f.size() == slot.meta.fileBytes();
+    f.close();
+    if (slot.used) found++;
+    else Serial.printf("Slot %d: invalid file ignored\n", id);
+  }
+  Serial.printf("Content slots: %d stored, RAM budget %u bytes\n", found, (unsigned)gSlotBudget);
+}
+
+// Put a slot on the panel; the caller persists the new state afterwards
+static bool activateContentSlot(int id, String& err) {
+  if (id < 0 || id >= CONTENT_SLOT_COUNT || !contentSlots[id].used) { err = "Unknown slot"; return false; }
+  ContentSlot& slot = contentSlots[id];
+  if (!slot.resident) {
+    if (!startSlotPreload(id)) { err = "Slot read failed"; return false; }
+    while (stepSlotPreload()) {}
+    if (!slot.resident) { err = "Slot read failed"; return false; }
+  }
+  slot.lastUse = ++gSlotUseClock;
+  {
+    FrameLock lock;
+    const ContentSlotMeta& m = slot.meta;
+    textPixels.assign(slot.text.begin(), slot.text.end());
+    textAlpha.assign(slot.alpha.begin(), slot.alpha.end());
+    textTinted = m.textKind == SLOT_TEXT_A8;
+    imgW = m.textW;
+    imgH = m.textH;
+    rebuildTextSpans();
+    // A background stored for another panel layout falls back to the solid color
+    ContentSettings s = m.settings;
+    s.bgImage = s.bgImage && slot.bg.size() == (size_t)VIRT_W() * (size_t)VIRT_H();
+    if (s.bgImage) bgPixels.assign(slot.bg.begin(), slot.bg.end());
+    currentMode = MODE_CLOCK;
+    applyContentSettings(s);
+    userOffX = 0;
+    userOffY = 0;
+    frameSynced = false;
+    gActiveSlot = id;
+    presentText();
+  }
+  trimSlotResidency(id);
+  return true;
+}
+
+static ImageUploadDecoder slotTextDecoder, slotBgDecoder;
+static BulkVector<uint16_t> slotTextStage, slotBgStage;
+static BulkVector<uint8_t> slotAlphaStage, slotUnusedAlpha;
+static bool slotHaveText = false, slotHaveBg = false;
+static bool slotBgFirst = false;   // the bg part came before the text part
+static const char* slotError = nullptr;
+
+static void releaseSlotStage() {
+  BulkVector<uint16_t>().swap(slotTextStage);
+  BulkVector<uint16_t>().swap(slotBgStage);
+  BulkVector<uint8_t>().swap(slotAlphaStage);
+  slotHaveText = slotHaveBg = slotBgFirst = false;
+  slotError = nullptr;
+}
+
+void handleSlotUploadData() {
+  HTTPUpload& up = server.upload();
+  const bool isBg = up.name == "bg";
+  ImageUploadDecoder& d = isBg ? slotBgDecoder : slotTextDecoder;
+  if (up.status == UPLOAD_FILE_START) {
+    if (isBg) {
+      if (!slotHaveText) slotBgFirst = true;
+      d.begin(slotBgStage, slotUnusedAlpha, (uint16_t)VIRT_W() * 2, (uint16_t)VIRT_H() * 2, true);
+    } else {
+      const bool bgFirst = slotBgFirst;
+      releaseSlotStage();  // the text part starts a new slot upload
+      slotBgFirst = bgFirst;
+      d.begin(slotTextStage, slotAlphaStage, (uint16_t)VIRT_W() * 4, (uint16_t)VIRT_H());
+    }
+  } else if (up.status == UPLOAD_FILE_WRITE) {
+    d.feed(up.buf, up.currentSize);
+  } else if (up.status == UPLOAD_FILE_END) {
+    if (!d.finish()) slotError = d.error;
+    else if (isBg) slotHaveBg = true;
+    else slotHaveText = true;
+  } else if (up.status == UPLOAD_FILE_ABORTED) {
+    releaseSlotStage();  // the completion handler does not run for an aborted body
+  }
+}
+
+void handleSlotUploadDone() {
+  const int id = server.hasArg("id") ? server.arg("id").toInt() : -1;
+  const char* err = nullptr;
+  if (id < 0 || id >= CONTENT_SLOT_COUNT) err = "Invalid slot id";
+  else if (slotError) err = slotError;
+  else if (!slotHaveText) err = "Missing text part";
+  else if (slotBgFirst) err = "The bg part must follow the text part";
+  if (err) {
+    Serial.printf("/slot_upload: %s\n", err);
+    server.send(400, "text/plain", err);
+    releaseSlotStage();
+    return;
+  }
+
+  ContentSlot& slot = contentSlots[id];
+  ContentSlotMeta m;
+  m.settings = currentContentSettings();
+  contentSettingsFromArgs(m.settings);
+  m.settings.bgImage = slotHaveBg;
+  m.textKind = slotTextDecoder.alphaOnly() ? SLOT_TEXT_A8 : (slotAlphaStage.empty() ? SLOT_TEXT_RGB565 : SLOT_TEXT_A8_RGB565);
+  m.textW = slotTextDecoder.w;
+  m.textH = slotTextDecoder.h;
+  m.setName(server.hasArg("name") ? server.arg("name").c_str() : "");
+  if (!m.name[0]) snprintf(m.name, sizeof(m.name), "Slot %d", id);
+
+  if (slotPreload.id == id) cancelSlotPreload();
+  const ContentSlotMeta oldMeta = slot.meta;
+  const bool oldUsed = slot.used;
+  slot.drop();
+  slot.text.swap(slotTextStage);
+  slot.alpha.swap(slotAlphaStage);
+  if (slotHaveBg) {
+    centerOnPanel(slot.bg, slotBgStage.data(), slotBgDecoder.w, slotBgDecoder.h, m.settings.bgColor);
+    m.bgW = VIRT_W();
+    m.bgH = VIRT_H();
+  }
+  releaseSlotStage();
+  slot.meta = m;
+  slot.used = true;
+  slot.resident = true;
+  slot.lastUse = ++gSlotUseClock;
+  if (!writeSlotFile(slot, id)) {
+    // The old file is untouched; its pixels load from flash again on the next activation
+    slot.drop();
+    slot.meta = oldMeta;
+    slot.used = oldUsed;
+    server.send(500, "text/plain", "Failed to store slot");
+    return;
+  }
+  Serial.printf("Slot %d stored: \"%s\" %ux%u %u bytes\n", id, m.name, m.textW, m.textH, (unsigned)m.fileBytes());
+
+  String activateErr;
+  const bool activated = server.arg("activate") == "1" && activateContentSlot(id, activateErr);
+  if (!activated) {
+    if (gActiveSlot == id) gActiveSlot = -1;  // the panel still shows the slot's old content
+    trimSlotResidency(-1);
+  }
+  String json = "{";
+  json += "\"id\":" + String(id) + ",";
+  json += "\"bytes\":" + String((uint32_t)m.fileBytes()) + ",";
+  json += "\"activated\":" + String(activated ? "true" : "false");
+  json += "}";
+  server.send(200, "application/json", json);
+  if (activated) requestPersist(PERSIST_SETTINGS | PERSIST_FRAME);
+}
+
+static void appendSlotJson(String& json, int id) {
+  const ContentSlot& s = contentSlots[id];
+  const ContentSlotMeta& m = s.meta;
+  json += "{\"id\":" + String(id) + ",";
+  json += "\"name\":\""; json += m.name; json += "\",";
+  json += "\"w\":" + String(m.textW) + ",\"h\":" + String(m.textH) + ",";
+  json += "\"format\":\"" + String(m.textKind == SLOT_TEXT_A8 ? "a8" : (m.textKind == SLOT_TEXT_A8_RGB565 ? "a8+rgb565" : "rgb565")) + "\",";
+  json += "\"bg_image\":" + String(m.settings.bgImage ? "true" : "false") + ",";
+  json += "\"animate\":" + String(m.settings.animate ? "true" : "false") + ",";
+  json += "\"bytes\":" + String((uint32_t)m.fileBytes()) + ",";
+  json += "\"resident\":" + String(s.resident ? "true" : "false") + "}";
+}
+
+// ================= Playlist =================
+// Rotates stored content slots on the device (see playlist.h), so content keeps cycling with
+// no browser attached. playlistPoll() runs from loop(): it times the current entry against
+// esp_timer (dwell) or the render task's scroll distance (cycles), switches by activating the
+// next slot, and meanwhile reads that slot's pixels from flash a chunk per pass so the switch
+// itself is a RAM copy. Time windows need the wall clock, from SNTP once STA is connected or
+// from POST /time; until then only unwindowed entries play. Anything else taking the panel
+// (an upload, a stream, a manual slot activation) stops the playlist.
+#define PLAYLIST_PATH "/playlist.txt"
+
+static Playlist playlist;
+static bool gPlaylistOn = false;
+static int gLocalTzMin = 0;           // local time offset from UTC in minutes
+static int gPlaylistCur = -1;            // entry on the panel, -1 = none yet
+static int gPlaylistNext = -1;           // entry being preloaded
+static int64_t gPlaylistSinceUs = 0;     // when the current entry went up
+static uint32_t gPlaylistStartPx = 0;    // scrollDistancePx at that moment
+static uint32_t gPlaylistSwitches = 0;
+
+// Local minute of the day, or -1 while the clock has not been set
+static int playlistMinuteOfDay() {
+  const time_t now = time(nullptr);
+  if (now < 1600000000) return -1;
+  const int64_t local = (int64_t)now + (int64_t)gLocalTzMin * 60;
+  return (int)(((local / 60) % 1440 + 1440) % 1440);
+}
+
+static int nextPlaylistEntry(int current) {
+  return playlist.next(current, playlistMinuteOfDay(), esp_random(),
+                       [](uint8_t slot) { return contentSlots[slot].used; });
+}
+
+static void savePlaylist() {
+  char spec[PLAYLIST_MAX_ENTRIES * 40];
+  playlist.format(spec, sizeof(spec));
+  File f = LittleFS.open(PLAYLIST_PATH, "w");
+  if (!f) { Serial.println("Playlist: save failed"); return; }
+  char head[32];
+  const int n = snprintf(head, sizeof(head), "%d %d %d\n", gPlaylistOn ? 1 : 0, playlist.weighted ? 1 : 0, gLocalTzMin);
+  f.write(reinterpret_cast<const uint8_t*>(head), n);
+  f.write(reinterpret_cast<const uint8_t*>(spec), strlen(spec));
+  f.close();
+}
+
+static void loadPlaylist() {
+  File f = LittleFS.open(PLAYLIST_PATH, "r");
+  if (!f) return;
+  char buf[PLAYLIST_MAX_ENTRIES * 40 + 32];
+  const size_t n = f.read(reinterpret_cast<uint8_t*>(buf), sizeof(buf) - 1);
+  f.close();
+  buf[n] = 0;
+  int on = 0, weighted = 0, tz = 0;
+  char* spec = strchr(buf, '\n');
+  const char* err = "Bad header";
+  if (!spec || sscanf(buf, "%d %d %d", &on, &weighted, &tz) != 3 || !playlist.parse(spec + 1, CONTENT_SLOT_COUNT, &err)) {
+    Serial.printf("Playlist: ignoring %s (%s)\n", PLAYLIST_PATH, err);
+    return;
+  }
+  playlist.weighted = weighted != 0;
+  gLocalTzMin = tz;
+  gPlaylistOn = on && !playlist.entries.empty();
+  Serial.printf("Playlist: %u entries, %s\n", (unsigned)playlist.entries.size(), gPlaylistOn ? "running" : "stopped");
+}
+
+static void stopPlaylist(const char* why) {
+  if (!gPlaylistOn) return;
+  gPlaylistOn = false;
+  gPlaylistCur = gPlaylistNext = -1;
+  cancelSlotPreload();
+  Serial.printf("Playlist stopped: %s\n", why);
+  savePlaylist();
+}
+
+// Put entry i on the panel and start reading the one after it
+static void showPlaylistEntry(int i) {
+  String err;
+  const int slot = playlist.entries[i].slot;
+  if (!activateContentSlot(slot, err)) {
+    // Hold for the default dwell and try the following entry then
+    Serial.printf("Playlist: slot %d: %s\n", slot, err.c_str());
+    gPlaylistCur = -1;
+    gPlaylistSinceUs = esp_timer_get_time();
+    gPlaylistNext = nextPlaylistEntry(i);
+    return;
+  }
+  gPlaylistCur = i;
+  gPlaylistSinceUs = esp_timer_get_time();
+  gPlaylistStartPx = scrollDistancePx;
+  gPlaylistSwitches++;
+  // Switches are not persisted: rotating content would otherwise rewrite flash every dwell
+  gPlaylistNext = nextPlaylistEntry(i);
+  if (gPlaylistNext >= 0 && playlist.entries[gPlaylistNext].slot != slot) startSlotPreload(playlist.entries[gPlaylistNext].slot);
+}
+
+static bool playlistEntryDone() {
+  const int64_t elapsedMs = (esp_timer_get_time() - gPlaylistSinceUs) / 1000;
+  if (gPlaylistCur < 0) return elapsedMs >= PLAYLIST_DEFAULT_DWELL_MS;
+  const PlaylistEntry& e = playlist.entries[gPlaylistCur];
+  if (e.cycles && animate && stripW > 0) return scrollDistancePx - gPlaylistStartPx >= (uint32_t)e.cycles * (uint32_t)stripW;
+  return elapsedMs >= (e.dwellMs ? e.dwellMs : PLAYLIST_DEFAULT_DWELL_MS);
+}
+
+static void playlistPoll() {
+  if (!gPlaylistOn) return;
+  if (gPlaylistCur >= 0 && (gActiveSlot != playlist.entries[gPlaylistCur].slot || currentMode != MODE_CLOCK)) {
+    stopPlaylist("display taken over");
+    return;
+  }
+  stepSlotPreload();
+  if (gPlaylistCur >= 0 && !playlistEntryDone()) return;
+  if (gPlaylistCur < 0 && gPlaylistSinceUs && !playlistEntryDone()) return;
+  // The preloaded entry may have left its time window or lost its slot meanwhile
+  int i = gPlaylistNext;
+  if (i < 0 || i >= (int)playlist.entries.size() || !contentSlots[playlist.entries[i].slot].used ||
+      !playlist.entries[i].inWindow(playlistMinuteOfDay())) {
+    i = nextPlaylistEntry(gPlaylistCur);
+  }
+  if (i < 0) {
+    // Nothing may play right now; keep the current content and look again after a dwell
+    gPlaylistSinceUs = esp_timer_get_time();
+    if (gPlaylistCur >= 0) gPlaylistStartPx = scrollDistancePx;
+    return;
+  }
+  if (i == gPlaylistCur) {
+    gPlaylistSinceUs = esp_timer_get_time();
+    gPlaylistStartPx = scrollDistancePx;
+    return;
+  }
+  showPlaylistEntry(i);
+}
+
+static void startPlaylist() {
+  gPlaylistOn = true;
+  gPlaylistCur = gPlaylistNext = -1;
+  gPlaylistSinceUs = 0;
+  playlistPoll();
+}
+
+static String playlistStatusJson() {
+  char spec[PLAYLIST_MAX_ENTRIES * 40];
+  playlist.format(spec, sizeof(spec));
+  const int minute = playlistMinuteOfDay();
+  String json = "{";
+  json += "\"enabled\":" + String(gPlaylistOn ? "true" : "false") + ",";
+  json += "\"mode\":\"" + String(playlist.weighted ? "weighted" : "order") + "\",";
+  json += "\"tz\":" + String(gLocalTzMin) + ",";
+  json += "\"minute\":" + String(minute) + ",";
+  json += "\"entry\":" + String(gPlaylistCur) + ",";
+  json += "\"slot\":" + String(gPlaylistCur >= 0 ? (int)playlist.entries[gPlaylistCur].slot : -1) + ",";
+  json += "\"next\":" + String(gPlaylistNext) + ",";
+  json += "\"preloading\":" + String(slotPreload.id) + ",";
+  json += "\"elapsed_ms\":" + String(gPlaylistOn ? (uint32_t)((esp_timer_get_time() - gPlaylistSinceUs) / 1000) : 0) + ",";
+  json += "\"switches\":" + String(gPlaylistSwitches) + ",";
+  json += "\"entries\":\""; json += spec; json += "\"";
+  json += "}";
+  return json;
+}
+
+// ================= Clock Widget =================
+// Clock, countdown and stopwatch drawn by the firmware from a glyph atlas (see clock_widget.h).
+// The render task calls renderWidgetFrame() on every tick; it formats the current time and,
+// when the text changed, restores and redraws only the cells whose glyph differs. The clock
+// reads the system time (SNTP or /time), the timers esp_timer, so nothing has to stay connected.
+#define WIDGET_PATH "/widget.bin"
+#define WIDGET_HEADER 64
+
+static WidgetAtlas widgetAtlas;
+static BulkVector<uint16_t> widgetPixels;    // atlas RGB565, empty when tinted with gWidgetTextColor
+static BulkVector<uint8_t> widgetAlpha;      // atlas coverage, empty for opaque RGB565 glyphs
+static WidgetKind gWidgetKind = WIDGET_CLOCK;
+static WidgetFormat gWidgetFormat = WIDGET_HMS;
+static bool gWidgetHour12 = false;
+static int16_t gWidgetOffX = 0, gWidgetOffY = 0;
+// The widget's own look; textColor, bgColor, bgPixels and currentBrightness belong to the
+// text content and lastSettings, so showing the widget never changes what the text restores to
+static uint16_t gWidgetTextColor = 0xFFFF, gWidgetBgColor = 0;
+static BulkVector<uint16_t> gWidgetBgPixels;  // frame-sized background image, empty for gWidgetBgColor
+static int16_t gWidgetBrightness = -1;        // 8-bit panel brightness, -1 = currentBrightness
+static uint32_t gWidgetSeconds = 0;          // countdown length
+static int64_t gWidgetStartUs = 0;           // timer origin
+static int64_t gWidgetPausedUs = 0;          // when the timer was paused, 0 = running
+static char gWidgetShown[WIDGET_MAX_CELLS + 1] = {};  // text on the panel
+static uint32_t gWidgetCellsDrawn = 0, gWidgetFullDraws = 0;
+
+static const uint16_t* widgetBgImage() {
+  return gWidgetBgPixels.size() == frameBuffer.size() ? gWidgetBgPixels.data() : nullptr;
+}
+
+// The panel runs at the widget's brightness while it is shown and at currentBrightness otherwise;
+// called wherever the mode or brightness changes, it only touches the driver on a change
+static void applyPanelBrightness() {
+  static int shown = -1;
+  const uint8_t b = (currentMode == MODE_WIDGET && gWidgetBrightness >= 0) ? (uint8_t)gWidgetBrightness : currentBrightness;
+  if (!dma_display || b == shown) return;
+  dma_display->setBrightness8(b);
+  shown = b;
+}
+
+static void widgetText(char* out, int64_t nowUs) {
+  if (gWidgetKind == WIDGET_CLOCK) {
+    const time_t now = time(nullptr);
+    if (now < 1600000000) {
+      // No wall clock yet: dashes in the shape of the time
+      formatWidgetTime(out, WIDGET_CLOCK, gWidgetFormat, 0, gWidgetHour12);
+      for (char* p = out; *p; ++p) if (*p >= '0' && *p <= '9') *p = '-';
+      return;
+    }
+    const int64_t local = (int64_t)now + (int64_t)gLocalTzMin * 60;
+    formatWidgetTime(out, WIDGET_CLOCK, gWidgetFormat, (uint32_t)((local % 86400 + 86400) % 86400), gWidgetHour12);
+    return;
+  }
+  const int64_t elapsedUs = (gWidgetPausedUs ? gWidgetPausedUs : nowUs) - gWidgetStartUs;
+  uint32_t secs;
+  if (gWidgetKind == WIDGET_STOPWATCH) {
+    secs = (uint32_t)(elapsedUs / 1000000);
+  } else {
+    // Round the remainder up so the display reaches 00:00 exactly when the time is over
+    const int64_t leftUs = (int64_t)gWidgetSeconds * 1000000 - elapsedUs;
+    secs = leftUs > 0 ? (uint32_t)((leftUs + 999999) / 1000000) : 0;
+  }
+  formatWidgetTime(out, gWidgetKind, gWidgetFormat, secs, false);
+}
+
+// Restore the background under one cell and draw its glyph centered in it
+static void drawWidgetCell(int x, int y, int cellW, char c) {
+  const int h = widgetAtlas.height;
+  restoreBackgroundRect(x, y, x + cellW, y + h, widgetBgImage(), gWidgetBgColor);
+  const int g = widgetAtlas.find(c);
+  if (g < 0) return;
+  const int frameW = VIRT_W(), frameH = VIRT_H();
+  const int gw = widgetAtlas.w[g];
+  const int gx = x + (cellW - gw) / 2;
+  const bool tinted = widgetPixels.empty();
+  for (int row = 0; row < h; ++row) {
+    const int dy = y + row;
+    if (dy < 0 || dy >= frameH) continue;
+    const size_t src = (size_t)row * widgetAtlas.width + widgetAtlas.x[g];
+    uint16_t* dst = &frameBuffer[(size_t)dy * frameW];
+    for (int col = 0; col < gw; ++col) {
+      const int dx = gx + col;
+      if (dx < 0 || dx >= frameW) continue;
+      const uint8_t a = widgetAlpha.empty() ? 255 : widgetAlpha[src + col];
+      if (!a) continue;
+      const uint16_t px = tinted ? gWidgetTextColor : widgetPixels[src + col];
+      dst[dx] = (a == 255) ? px : blend565(px, dst[dx], a);
+    }
+  }
+}
+
+// Runs under FrameLock from the render task; true when something was pushed
+static bool renderWidgetFrame(int64_t nowUs) {
+  if (currentMode != MODE_WIDGET || !widgetAtlas.height) return false;
+  char text[WIDGET_MAX_CELLS + 1];
+  widgetText(text, nowUs);
+  const size_t n = strlen(text);
+  if (frameSynced && !strcmp(text, gWidgetShown)) return false;
+
+  int total = 0;
+  bool sameLayout = frameSynced && n == strlen(gWidgetShown);
+  for (size_t i = 0; i < n; ++i) {
+    total += widgetAtlas.cellWidth(text[i]);
+    if (sameLayout && widgetAtlas.cellWidth(text[i]) != widgetAtlas.cellWidth(gWidgetShown[i])) sameLayout = false;
+  }
+  const int h = widgetAtlas.height;
+  const int x0 = (VIRT_W() - total) / 2 + gWidgetOffX;
+  const int y0 = (VIRT_H() - h) / 2 + gWidgetOffY;
+
+  if (!sameLayout) {
+    // First draw or the cells moved: redraw the union of the old and new rows
+    int bx0 = x0, by0 = y0, bx1 = x0 + total, by1 = y0 + h;
+    clipToFrame(bx0, by0, bx1, by1);
+    unionWithDrawn(bx0, by0, bx1, by1);
+    restoreBackgroundRect(bx0, by0, bx1, by1, widgetBgImage(), gWidgetBgColor);
+    int x = x0;
+    for (size_t i = 0; i < n; ++i) {
+      drawWidgetCell(x, y0, widgetAtlas.cellWidth(text[i]), text[i]);
+      x += widgetAtlas.cellWidth(text[i]);
+    }
+    maskDisabledPanels(by0, by1);
+    {
+      PerfScope perf(gPerfPush);
+      pushFrameRect(bx0, by0, bx1, by1);
+    }
+    setDrawnRect(x0, y0, x0 + total, y0 + h);
+    gWidgetFullDraws++;
+    gWidgetCellsDrawn += n;
+  } else {
+    int x = x0;
+    for (size_t i = 0; i < n; ++i) {
+      const int cw = widgetAtlas.cellWidth(text[i]);
+      if (text[i] != gWidgetShown[i]) {
+        drawWidgetCell(x, y0, cw, text[i]);
+        maskDisabledPanels(y0, y0 + h);
+        PerfScope perf(gPerfPush);
+        pushFrameRect(x, y0, x + cw, y0 + h);
+        gWidgetCellsDrawn++;
+      }
+      x += cw;
+    }
+  }
+  memcpy(gWidgetShown, text, n + 1);
+  return true;
+}
+
+// File layout: 'W' 'G' version kind format hour12 tinted glyphCount, u16 atlasW, atlasH,
+// i16 offX, offY, u16 textColor, bgColor, glyph names (20 bytes), glyph widths (u8 x 20),
+// flags (1 = background image, 2 = own brightness), brightness, then the atlas pixels (RGB565,
+// absent when tinted), alpha (A8) and the frame-sized background image. Version 1 files have
+// zero flags. Runs on the persist task: the widget is copied under FrameLock, written without it.
+static bool saveWidget() {
+  static BulkVector<uint16_t> pixels, bg;   // reused between saves like the frame snapshot
+  static BulkVector<uint8_t> alpha;
+  uint8_t h[WIDGET_HEADER] = { 'W', 'G', 2 };
+  {
+    FrameLock lock;
+    if (gWidgetKind != WIDGET_CLOCK || !widgetAtlas.height) return true;  // only a clock resumes
+    const uint8_t glyphs = (uint8_t)strlen(widgetAtlas.glyphs);
+    h[3] = gWidgetKind; h[4] = gWidgetFormat; h[5] = gWidgetHour12; h[6] = widgetPixels.empty(); h[7] = glyphs;
+    const uint16_t v[7] = { widgetAtlas.width, widgetAtlas.height, (uint16_t)gWidgetOffX, (uint16_t)gWidgetOffY, gWidgetTextColor, gWidgetBgColor,
+                            (uint16_t)!widgetAlpha.empty() };
+    memcpy(h + 8, v, sizeof(v));
+    memcpy(h + 22, widgetAtlas.glyphs, glyphs);
+    for (int i = 0; i < glyphs; ++i) h[42 + i] = (uint8_t)widgetAtlas.w[i];
+    h[62] = (gWidgetBgPixels.empty() ? 0 : 1) | (gWidgetBrightness >= 0 ? 2 : 0);
+    h[63] = gWidgetBrightness >= 0 ? (uint8_t)gWidgetBrightness : 0;
+    pixels.assign(widgetPixels.begin(), widgetPixels.end());
+    alpha.assign(widgetAlpha.begin(), widgetAlpha.end());
+    bg.assign(gWidgetBgPixels.begin(), gWidgetBgPixels.end());
+  }
+  // Written next to the old file and renamed over it, like the snapshots
+  const String tmp = String(WIDGET_PATH) + ".tmp";
+  File f = LittleFS.open(tmp, "w");
+  bool ok = (bool)f;
+  if (ok) {
+    const size_t want = sizeof(h) + pixels.size() * 2 + alpha.size() + bg.size() * 2;
+    size_t written = f.write(h, sizeof(h));
+    written += f.write(reinterpret_cast<const uint8_t*>(pixels.data()), pixels.size() * 2);
+    written += f.write(alpha.data(), alpha.size());
+    written += f.write(reinterpret_cast<const uint8_t*>(bg.data()), bg.size() * 2);
+    f.close();
+    ok = written == want;
+  }
+  ok = ok && LittleFS.rename(tmp, WIDGET_PATH);
+  if (!ok) LittleFS.remove(tmp);
+  return ok;
+}
+
+// Boot: bring a saved clock back; timers do not survive a restart
+static bool loadWidget() {
+  File f = LittleFS.open(WIDGET_PATH, "r");
+  if (!f) return false;
+  uint8_t h[WIDGET_HEADER];
+  bool ok = f.read(h, sizeof(h)) == sizeof(h) && h[0] == 'W' && h[1] == 'G' && (h[2] == 1 || h[2] == 2) &&
+            h[3] == WIDGET_CLOCK && h[7] > 0 && h[7] <= WIDGET_MAX_GLYPHS;
+  uint16_t v[7] = {};
+  char names[WIDGET_MAX_GLYPHS + 1] = {};
+  char widths[WIDGET_MAX_GLYPHS * 4 + 1] = {};
+  if (ok) {
+    memcpy(v, h + 8, sizeof(v));
+    memcpy(names, h + 22, h[7]);
+    for (int i = 0, len = 0; i < h[7]; ++i) len += snprintf(widths + len, sizeof(widths) - len, i ? ",%u" : "%u", h[42 + i]);
+    const char* err = nullptr;
+    WidgetAtlas atlas;
+    ok = atlas.parse(names, widths, v[0], v[1], &err);
+    const size_t px = (size_t)v[0] * v[1];
+    const size_t atlasEnd = sizeof(h) + (h[6] ? 0 : px * 2) + (v[6] ? px : 0);
+    const bool hasBg = h[2] >= 2 && (h[62] & 1);
+    ok = ok && (hasBg ? f.size() > atlasEnd : f.size() == atlasEnd);
+    if (ok) {
+      widgetPixels.resize(h[6] ? 0 : px);
+      widgetAlpha.resize(v[6] ? px : 0);
+      ok = f.read(reinterpret_cast<uint8_t*>(widgetPixels.data()), widgetPixels.size() * 2) == widgetPixels.size() * 2 &&
+           f.read(widgetAlpha.data(), widgetAlpha.size()) == widgetAlpha.size();
+      widgetAtlas = atlas;
+    }
+    // A background saved for another panel layout falls back to the solid color
+    const size_t framePx = (size_t)VIRT_W() * VIRT_H();
+    gWidgetBgPixels.resize(ok && hasBg && f.size() - atlasEnd == framePx * 2 ? framePx : 0);
+    ok = ok && f.read(reinterpret_cast<uint8_t*>(gWidgetBgPixels.data()), gWidgetBgPixels.size() * 2) == gWidgetBgPixels.size() * 2;
+    gWidgetBrightness = h[2] >= 2 && (h[62] & 2) ? h[63] : -1;
+  }
+  f.close();
+  if (!ok) {
+    BulkVector<uint16_t>().swap(widgetPixels);
+    BulkVector<uint8_t>().swap(widgetAlpha);
+    BulkVector<uint16_t>().swap(gWidgetBgPixels);
+    widgetAtlas = WidgetAtlas();
+    return false;
+  }
+  gWidgetKind = WIDGET_CLOCK;
+  gWidgetFormat = (WidgetFormat)h[4];
+  gWidgetHour12 = h[5] != 0;
+  gWidgetOffX = (int16_t)v[2];
+  gWidgetOffY = (int16_t)v[3];
+  gWidgetTextColor = v[4];
+  gWidgetBgColor = v[5];
+  gWidgetShown[0] = 0;
+  Serial.printf("Clock widget restored: %ux%u atlas, %u glyphs\n", v[0], v[1], h[7]);
+  return true;
+}
+
+static ImageUploadDecoder widgetDecoder, widgetBgDecoder;
+static BulkVector<uint16_t> widgetPixelStage, widgetBgStage;
+static BulkVector<uint8_t> widgetAlphaStage, widgetUnusedAlpha;
+static bool widgetHaveAtlas = false, widgetHaveBg = false;
+static const char* widgetError = nullptr;
+
+static void releaseWidgetStage() {
+  BulkVector<uint16_t>().swap(widgetPixelStage);
+  BulkVector<uint16_t>().swap(widgetBgStage);
+  BulkVector<uint8_t>().swap(widgetAlphaStage);
+  widgetHaveAtlas = widgetHaveBg = false;
+  widgetError = nullptr;
+}
+
+// Form parts: "atlas" (required, first) and an optional full-panel "background" image
+void handleWidgetUploadData() {
+  HTTPUpload& up = server.upload();
+  const bool isBg = up.name == "background";
+  ImageUploadDecoder& d = isBg ? widgetBgDecoder : widgetDecoder;
+  if (up.status == UPLOAD_FILE_START) {
+    if (isBg) {
+      d.begin(widgetBgStage, widgetUnusedAlpha, (uint16_t)VIRT_W() * 2, (uint16_t)VIRT_H() * 2, true);
+    } else {
+      releaseWidgetStage();
+      d.begin(widgetPixelStage, widgetAlphaStage, 1024, (uint16_t)VIRT_H());
+    }
+  } else if (up.status == UPLOAD_FILE_WRITE) {
+    d.feed(up.buf, up.currentSize);
+  } else if (up.status == UPLOAD_FILE_END) {
+    if (!d.finish()) widgetError = d.error;
+    else if (isBg) widgetHaveBg = true;
+    else widgetHaveAtlas = true;
+  } else if (up.status == UPLOAD_FILE_ABORTED) {
+    releaseWidgetStage();  // the completion handler does not run for an aborted body
+  }
+}
+
+// POST /widget: kind=clock|countdown|stopwatch, format=hms|hm|ms, h12=1, seconds=<countdown>,
+// glyphs, widths, offx, offy, color, bg, brightness; epoch/tz set the clock like /time
+void handleWidgetUploadDone() {
+  const char* err = widgetError;
+  WidgetAtlas atlas;
+  if (!err && !widgetHaveAtlas) err = "Missing atlas part";
+  if (!err) atlas.parse(server.arg("glyphs").c_str(), server.arg("widths").c_str(), widgetDecoder.w, widgetDecoder.h, &err);
+  if (err) {
+    Serial.printf("/widget: %s\n", err);
+    server.send(400, "text/plain", err);
+    releaseWidgetStage();
+    return;
+  }
+  const String kind = server.arg("kind");
+  const String fmt = server.arg("format");
+  if (server.hasArg("epoch")) {
+    const long long epoch = atoll(server.arg("epoch").c_str());
+    if (epoch >= 1600000000LL) { struct timeval tv = { (time_t)epoch, 0 }; settimeofday(&tv, nullptr); }
+  }
+  if (server.hasArg("tz")) gLocalTzMin = constrain(server.arg("tz").toInt(), -720, 840);
+  {
+    FrameLock lock;
+    // Only the colors and brightness of the upload args apply; they stay with the widget
+    ContentSettings look;
+    look.textColor = gWidgetTextColor;
+    contentSettingsFromArgs(look);
+    gWidgetTextColor = look.textColor;
+    gWidgetBgColor = look.bgColor;
+    gWidgetBrightness = look.setBrightness ? look.brightness : -1;
+    if (widgetHaveBg) centerOnPanel(gWidgetBgPixels, widgetBgStage.data(), widgetBgDecoder.w, widgetBgDecoder.h, gWidgetBgColor);
+    else BulkVector<uint16_t>().swap(gWidgetBgPixels);
+    widgetAtlas = atlas;
+    widgetPixels.swap(widgetPixelStage);
+    widgetAlpha.swap(widgetAlphaStage);
+    if (widgetDecoder.alphaOnly()) BulkVector<uint16_t>().swap(widgetPixels);
+    gWidgetKind = kind == "countdown" ? WIDGET_COUNTDOWN : (kind == "stopwatch" ? WIDGET_STOPWATCH : WIDGET_CLOCK);
+    gWidgetFormat = fmt == "hm" ? WIDGET_HM : (fmt == "ms" ? WIDGET_MS : WIDGET_HMS);
+    gWidgetHour12 = server.arg("h12") == "1";
+    gWidgetOffX = (int16_t)server.arg("offx").toInt();
+    gWidgetOffY = (int16_t)server.arg("offy").toInt();
+    gWidgetSeconds = (uint32_t)constrain(server.arg("seconds").toInt(), 0, 359999);
+    gWidgetStartUs = esp_timer_get_time();
+    gWidgetPausedUs = 0;
+    gWidgetShown[0] = 0;
+    currentMode = MODE_WIDGET;
+    applyPanelBrightness();
+    gActiveSlot = -1;
+    frameSynced = false;  // background and layout may both have changed
+    renderWidgetFrame(gWidgetStartUs);
+  }
+  releaseWidgetStage();
+  Serial.printf("Clock widget: %s, atlas %ux%u, %u glyphs\n", kind.length() ? kind.c_str() : "clock",
+                widgetAtlas.width, widgetAtlas.height, (unsigned)strlen(widgetAtlas.glyphs));
+  server.send(200, "text/plain", "OK");
+  // Only a clock resumes after a restart; the atlas is written once per upload, never per tick
+  requestPersist(PERSIST_SETTINGS | PERSIST_FRAME | (gWidgetKind == WIDGET_CLOCK ? PERSIST_WIDGET : 0));
+}
+
+static String widgetStatusJson() {
+  String json = "{";
+  json += "\"active\":" + String(currentMode == MODE_WIDGET ? "true" : "false") + ",";
+  json += "\"kind\":\"" + String(gWidgetKind == WIDGET_COUNTDOWN ? "countdown" : (gWidgetKind == WIDGET_STOPWATCH ? "stopwatch" : "clock")) + "\",";
+  json += "\"text\":\""; json += gWidgetShown; json += "\",";
+  json += "\"paused\":" + String(gWidgetPausedUs ? "true" : "false") + ",";
+  json += "\"seconds\":" + String(gWidgetSeconds) + ",";
+  json += "\"cells_drawn\":" + String(gWidgetCellsDrawn) + ",";
+  json += "\"full_draws\":" + String(gWidgetFullDraws);
+  json += "}";
+  return json;
+}
+
+// ================= Frame Delta Stream =================
+// /frame_delta: clients that stream whole frames send only the changed tiles. The stream owns
+// the display (MODE_STREAM) and skips persistence; gStreamSeq names the frame on screen.
+static FrameDeltaDecoder frameDelta;
+static int gFrameDeltaStatus = 200;
+
+// Called once a header is accepted, before any pixel lands in frameBuffer
+static void beginFrameStream(const FrameDeltaDecoder& d) {
+  animate = false;
+  currentMode = MODE_STREAM;
+  applyPanelBrightness();
+  gStreamSeq = 0;
+  frameSynced = false;
+  if (d.keyframe && (d.w < VIRT_W() || d.h < VIRT_H())) {
+    std::fill(frameBuffer.begin(), frameBuffer.end(), bgColor);
+  }
+}
+
+// Push the touched tiles of grid d, merging neighbours on the same tile row into one rect
+static void pushFrameDeltaTiles(const FrameDeltaGrid& d, std::vector<uint16_t>& tiles, bool full) {
+  if (full) {
+    maskDisabledPanels();
+    pushFrameRect(0, 0, VIRT_W(), VIRT_H());
+    return;
+  }
+  if (tiles.empty()) return;
+  std::sort(tiles.begin(), tiles.end());
+  maskDisabledPanels(d.offY + (tiles.front() / d.cols) * d.tile, d.offY + (tiles.back() / d.cols + 1) * d.tile);
+  size_t i = 0;
+  while (i < tiles.size()) {
+    const int row = tiles[i] / d.cols;
+    const int first = tiles[i] % d.cols;
+    int last = first;
+    while (++i < tiles.size() && tiles[i] / d.cols == row && tiles[i] % d.cols <= last + 1) last = tiles[i] % d.cols;
+    const int x0 = d.offX + first * d.tile, y0 = d.offY + row * d.tile;
+    int x1 = d.offX + (last + 1) * d.tile, y1 = y0 + d.tile;
+    if (x1 > d.offX + d.w) x1 = d.offX + d.w;
+    if (y1 > d.offY + d.h) y1 = d.offY + d.h;
+    pushFrameRect(x0, y0, x1, y1);
+  }
+}
+
+// Feed one body chunk; the stream takes over the display as soon as a header is accepted.
+// Caller holds the frame lock. frameBuffer is re-resolved per chunk: /panel_layout may have
+// reallocated it since the previous one.
+static bool feedFrameDelta(FrameDeltaDecoder& d, const uint8_t* p, size_t n) {
+  if (!d.retarget(frameBuffer.data(), frameBuffer.size(), VIRT_W(), VIRT_H())) return false;
+  if (d.state == FrameDeltaDecoder::HEADER) {
+    const size_t h = std::min(n, (size_t)(FRAME_DELTA_HEADER - d.fill));
+    if (!d.feed(p, h)) return false;
+    p += h; n -= h;
+    if (d.state != FrameDeltaDecoder::HEADER) beginFrameStream(d);
+  }
+  return !n || d.feed(p, n);
+}
+
+void handleFrameDeltaData() {
+  HTTPUpload& up = server.upload();
+  if (up.status == UPLOAD_FILE_START) {
+    // Only a stream that still owns the display can be continued
+    FrameLock lock;
+    const uint32_t base = (currentMode == MODE_STREAM) ? gStreamSeq : 0;
+    frameDelta.begin(frameBuffer.data(), VIRT_W(), VIRT_H(), base, gStreamW, gStreamH);
+  } else if (up.status == UPLOAD_FILE_WRITE) {
+    FrameLock lock;
+    feedFrameDelta(frameDelta, up.buf, up.currentSize);
+  } else if (up.status == UPLOAD_FILE_END) {
+    FrameLock lock;
+    if (!frameDelta.finish()) {
+      gFrameDeltaStatus = frameDelta.resync ? 409 : 400;
+      // A partly applied delta leaves an unknown frame: the next one must be a keyframe
+      if (frameDelta.wrote) gStreamSeq = 0;
+      Serial.printf("/frame_delta: %s (base=%u have=%u)\n", frameDelta.error, (unsigned)frameDelta.baseSeq, (unsigned)gStreamSeq);
+      return;
+    }
+    gStreamSeq = frameDelta.seq;
+    gStreamW = frameDelta.w;
+    gStreamH = frameDelta.h;
+    pushFrameDeltaTiles(frameDelta.grid(), frameDelta.dirtyTiles, frameDelta.keyframe);
+    setDrawnRect(0, 0, 0, 0);
+    gFrameDeltaStatus = 200;
+  } else if (up.status == UPLOAD_FILE_ABORTED) {
+    if (frameDelta.wrote) gStreamSeq = 0;
+    gFrameDeltaStatus = 400;
+  }
+}
+
+void handleFrameDeltaDone() {
+  String json = "{";
+  json += "\"seq\":" + String(gStreamSeq) + ",";
+  json += "\"resync\":" + String(gFrameDeltaStatus == 409 ? "true" : "false");
+  if (gFrameDeltaStatus == 200) json += ",\"tiles\":" + String(frameDelta.keyframe ? 0 : (unsigned)frameDelta.dirtyTiles.size());
+  json += "}";
+  server.send(gFrameDeltaStatus, "application/json", json);
+}
+
+// ================= Frame Channel =================
+// Long-lived TCP connection for real-time frames, so a frame no longer pays for TCP setup,
+// HTTP header parsing and multipart boundary scanning. One client at a time; a new
+// connection replaces the old one.
+//   client -> device: u32 length (little endian), then a /frame_delta body (see frame_delta.h)
+//   device -> client: 8 bytes: type, 0, u16 credits, u32 seq of the frame now on the panel
+//     'H' hello   initial credits; seq 0 means the first frame must be a keyframe
+//     'C' credit  frames consumed since the last credit message
+//     'R' resync  the last delta did not apply; send a keyframe (its credit is returned too)
+// A client keeps at most `credits` frames in flight. Frames that finish arriving before the
+// panel is ready are coalesced: only the newest state is pushed and the older frames count as
+// dropped, so a sender that outruns the panel loses intermediate frames rather than adding latency.
+#define FRAME_CHANNEL_PORT 3333
+#define FRAME_CHANNEL_CREDITS 3
+#define FRAME_CHANNEL_READ_BUDGET 16384      // bytes per loop() pass, keeps HTTP responsive
+#define FRAME_CHANNEL_MIN_PRESENT_US 16000   // at most ~60 pushes per second
+
+static WiFiServer channelServer(FRAME_CHANNEL_PORT);
+static WiFiClient channelClient;
+static FrameDeltaDecoder channelDecoder;
+static uint8_t channelLen[4];
+static uint8_t channelLenFill = 0;
+static uint32_t channelBodyLeft = 0;         // 0: reading the next length prefix
+static std::vector<uint16_t> channelTiles;   // tiles touched since the last push
+static FrameDeltaGrid channelGrid;
+static bool channelFull = false;             // push the whole frame (keyframe or grid change)
+static uint16_t channelPending = 0;          // frames applied but not pushed yet
+static uint16_t channelConsumed = 0;         // frames not yet credited back
+static int64_t channelLastPushUs = 0;
+static uint32_t gChannelFrames = 0, gChannelDropped = 0, gChannelResyncs = 0;
+
+static void channelSend(char type, uint16_t credits, uint32_t seq) {
+  const uint8_t msg[8] = { (uint8_t)type, 0, (uint8_t)(credits & 255), (uint8_t)(credits >> 8),
+                           (uint8_t)(seq & 255), (uint8_t)((seq >> 8) & 255), (uint8_t)((seq >> 16) & 255), (uint8_t)(seq >> 24) };
+  channelClient.write(msg, sizeof(msg));
+}
+
+static void channelReset() {
+  channelLenFill = 0;
+  channelBodyLeft = 0;
+  channelTiles.clear();
+  channelFull = false;
+  channelPending = 0;
+  channelConsumed = 0;
+}
+
+// Largest body a well-behaved client can send: every tile of a full-panel delta
+static uint32_t channelMaxBody() {
+  const uint32_t tiles = (uint32_t)((VIRT_W() + 7) / 8) * (uint32_t)((VIRT_H() + 7) / 8);
+  return FRAME_DELTA_HEADER + 2 + tiles * 2 + (uint32_t)VIRT_W() * (uint32_t)VIRT_H() * 2;
+}
+
+static void channelFrameDone() {
+  FrameLock lock;
+  if (!channelDecoder.finish()) {
+    if (channelDecoder.wrote) gStreamSeq = 0;
+    if (channelDecoder.resync) gChannelResyncs++;
+    Serial.printf("frame channel: %s\n", channelDecoder.error);
+    channelSend('R', 1, gStreamSeq);
+    return;
+  }
+  gStreamSeq = channelDecoder.seq;
+  gStreamW = channelDecoder.w;
+  gStreamH = channelDecoder.h;
+  const FrameDeltaGrid grid = channelDecoder.grid();
+  if (channelDecoder.keyframe || (channelPending && grid != channelGrid)) {
+    channelFull = true;
+    channelTiles.clear();
+  } else if (!channelFull) {
+    channelTiles.insert(channelTiles.end(), channelDecoder.dirtyTiles.begin(), channelDecoder.dirtyTiles.end());
+  }
+  channelGrid = grid;
+  channelPending++;
+}
+
+static bool channelConsume(const uint8_t* p, size_t n) {
+  while (n) {
+    if (channelBodyLeft == 0) {
+      channelLen[channelLenFill++] = *p++; --n;
+      if (channelLenFill < 4) continue;
+      channelLenFill = 0;
+      channelBodyLeft = (uint32_t)channelLen[0] | ((uint32_t)channelLen[1] << 8) | ((uint32_t)channelLen[2] << 16) | ((uint32_t)channelLen[3] << 24);
+      if (channelBodyLeft == 0 || channelBodyLeft > channelMaxBody()) return false;
+      FrameLock lock;
+      const uint32_t base = (currentMode == MODE_STREAM) ? gStreamSeq : 0;
+      channelDecoder.begin(frameBuffer.data(), VIRT_W(), VIRT_H(), base, gStreamW, gStreamH);
+      continue;
+    }
+    const size_t take = std::min(n, (size_t)channelBodyLeft);
+    {
+      FrameLock lock;
+      feedFrameDelta(channelDecoder, p, take);
+    }
+    p += take; n -= take;
+    if ((channelBodyLeft -= take) == 0) channelFrameDone();
+  }
+  return true;
+}
+
+// Push everything applied since the last push and hand the credits back
+static void channelPresent() {
+  if (!channelPending) return;
+  const int64_t now = esp_timer_get_time();
+  if (now - channelLastPushUs < FRAME_CHANNEL_MIN_PRESENT_US) return;
+  {
+    FrameLock lock;
+    PerfScope perf(gPerfPush);
+    if (currentMode == MODE_STREAM) pushFrameDeltaTiles(channelGrid, channelTiles, channelFull);
+  }
+  channelLastPushUs = now;
+  gChannelFrames++;
+  gChannelDropped += channelPending - 1;
+  channelConsumed += channelPending;
+  channelPending = 0;
+  channelTiles.clear();
+  channelFull = false;
+  channelSend('C', channelConsumed, gStreamSeq);
+  channelConsumed = 0;
+}
+
+static void frameChannelPoll() {
+  if (channelServer.hasClient()) {
+    if (channelClient) channelClient.stop();
+    channelClient = channelServer.available();
+    channelClient.setNoDelay(true);
+    channelReset();
+    Serial.printf("frame channel: client %s\n", channelClient.remoteIP().toString().c_str());
+    channelSend('H', FRAME_CHANNEL_CREDITS, 0);
+  }
+  if (!channelClient) return;
+  if (!channelClient.connected()) { channelClient.stop(); return; }
+
+  uint8_t buf[1460];
+  size_t budget = FRAME_CHANNEL_READ_BUDGET;
+  while (budget) {
+    const int avail = channelClient.available();
+    if (avail <= 0) break;
+    const int n = channelClient.read(buf, std::min((size_t)avail, std::min(sizeof(buf), budget)));
+    if (n <= 0) break;
+    budget -= (size_t)n;
+    if (!channelConsume(buf, (size_t)n)) {
+      Serial.println("frame channel: bad length, closing");
+      channelClient.stop();
+      return;
+    }
+  }
+  channelPresent();
+}
+
+// ================= DDP Receiver =================
+// Pixel data from lighting controllers over UDP (see ddp_receiver.h). A dedicated task blocks
+// in recvfrom on a raw lwIP socket, so packets never touch the HTTP server or loop(); data is
+// assembled in a back buffer and only a push copies the touched rows into frameBuffer and out to
+// the panel, under the frame lock so the render task never sees half a frame.
+#define DDP_TASK_CORE 0
+#define DDP_TASK_PRIO 3
+#define DDP_MAX_PACKET 1500
+
+static DdpReceiver ddpRx;
+static TaskHandle_t gDdpTask = nullptr;
+static PerfHistogram gPerfDdpPresent;   // push packet received to frame on the panel
+
+static void ddpPresent() {
+  int y0, y1;
+  const bool changed = ddpRx.takeDirty(y0, y1);
+  FrameLock lock;
+  if (frameBuffer.size() != (size_t)ddpRx.w * ddpRx.h) return;
+  // Taking over from another mode: the whole back buffer is the frame
+  if (currentMode != MODE_STREAM || gStreamSeq != 0) {
+    animate = false;
+    currentMode = MODE_STREAM;
+    applyPanelBrightness();
+    gStreamSeq = 0;
+    frameSynced = false;
+    y0 = 0; y1 = ddpRx.h;
+  } else if (!changed) {
+    return;
+  }
+  ddpRx.copyRows(frameBuffer.data(), y0, y1);
+  maskDisabledPanels(y0, y1);
+  {
+    PerfScope perf(gPerfPush);
+    pushFrameRect(0, y0, VIRT_W(), y1);
+  }
+  setDrawnRect(0, 0, 0, 0);
+}
+
+static void ddpTask(void* arg) {
+  const int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(DDP_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (sock < 0 || bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+    Serial.println("DDP: socket setup failed");
+    if (sock >= 0) close(sock);
+    gDdpTask = nullptr;
+    vTaskDelete(NULL);
+    return;
+  }
+  Serial.printf("DDP: listening on UDP %u\n", (unsigned)DDP_PORT);
+  static uint8_t pkt[DDP_MAX_PACKET];
+  for (;;) {
+    sockaddr_in from = {};
+    socklen_t fromLen = sizeof(from);
+    const int n = recvfrom(sock, pkt, sizeof(pkt), 0, (sockaddr*)&from, &fromLen);
+    if (n <= 0) continue;
+    const int64_t t0 = esp_timer_get_time();
+    // The back buffer belongs to this task; it follows the panel geometry, which /panel_layout
+    // changes under the frame lock, so the resize (rare) reads it and reallocates under the lock
+    if (ddpRx.w != VIRT_W() || ddpRx.h != VIRT_H()) {
+      FrameLock lock;
+      ddpRx.resize(VIRT_W(), VIRT_H());
+    }
+    if (ddpRx.feed(pkt, (size_t)n) != DDP_PUSH) continue;
+    ddpPresent();
+    gPerfDdpPresent.record((uint32_t)(esp_timer_get_time() - t0));
+    if (ddpRx.ackRequested) {
+      uint8_t ack[DDP_HEADER];
+      ddpRx.buildAck(ack);
+      sendto(sock, ack, sizeof(ack), 0, (sockaddr*)&from, fromLen);
     }
   }
 }
 
-void handleUploadBgDone() {
-  sendCORSHeaders();
-  // No additional args needed; just acknowledge
-  server.send(200, "text/plain", "OK");
+static void startDdpReceiver() {
+  if (gDdpTask) return;
+  xTaskCreatePinnedToCore(ddpTask, "ddp", 4096, nullptr, DDP_TASK_PRIO, &gDdpTask, DDP_TASK_CORE);
 }
 
 // Handle theme file upload at /upload_theme
@@ -1246,6 +3098,7 @@ void handleUploadTheme() {
     Serial.println("/upload_theme: START");
     // Open file for writing
     themeFile = LittleFS.open("/theme.html", "w");
+    forgetStaticAssets("/theme.html");
     if (!themeFile) {
       Serial.println("/upload_theme: Failed to open file for writing");
     }
@@ -1258,212 +3111,213 @@ void handleUploadTheme() {
     if (themeFile) {
       themeFile.close();
       Serial.println("/upload_theme: Theme saved to /theme.html");
+      FrameLock lock;
 
       // Stop clock mode if it was running
       if (currentMode == MODE_CLOCK) {
         Serial.println("Stopping clock mode, switching to theme mode");
         animate = false;  // Stop clock animation
         textPixels.clear();  // Clear text pixels to stop clock display
+        textAlpha.clear();
+        textSpans.clear();
+        textTinted = false;
       }
       currentMode = MODE_THEME;
+      applyPanelBrightness();
 
-      sendCORSHeaders();
       server.send(200, "text/plain", "Theme uploaded successfully");
     } else {
       Serial.println("/upload_theme: Failed to save theme (file not open)");
-      sendCORSHeaders();
       server.send(500, "text/plain", "Failed to save theme");
     }
   }
 }
 
-void setup() {
-  Serial.begin(115200);
-  delay(100);
-  Serial.println("Starting HUB75 + WebServer for Khmer text...");
-
-  // Initialize NVS
-  esp_err_t err = nvs_flash_init();
-  if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-    // NVS partition was truncated and needs to be erased
-    Serial.println("Erasing NVS flash...");
-    ESP_ERROR_CHECK(nvs_flash_erase());
-    err = nvs_flash_init();
-  }
-  ESP_ERROR_CHECK(err);
-  Serial.println("NVS initialized");
-
-  randomSeed(micros());
-
-  // Module configuration
-  HUB75_I2S_CFG mxconfig(
-    PANEL_RES_X,
-    PANEL_RES_Y,
-    PANEL_CHAIN
-  );
-
-  // Pin mapping
-  mxconfig.gpio.r1 = R1_PIN;
-  mxconfig.gpio.g1 = G1_PIN;
-  mxconfig.gpio.b1 = B1_PIN;
-  mxconfig.gpio.r2 = R2_PIN;
-  mxconfig.gpio.g2 = G2_PIN;
-  mxconfig.gpio.b2 = B2_PIN;
-  mxconfig.gpio.a = A_PIN;
-  mxconfig.gpio.b = B_PIN;
-  mxconfig.gpio.c = C_PIN;
-  mxconfig.gpio.d = D_PIN;
-  mxconfig.gpio.e = E_PIN;
-  mxconfig.gpio.lat = LAT_PIN;
-  mxconfig.gpio.oe = OE_PIN;
-  mxconfig.gpio.clk = CLK_PIN;
-
-  // Panel driver/timing options
-  mxconfig.clkphase = false;
-  mxconfig.driver = HUB75_I2S_CFG::FM6124;
-
-  // Display Setup
-  dma_display = new MatrixPanel_I2S_DMA(mxconfig);
-  if (!dma_display->begin()) {
-    Serial.println("MatrixPanel_I2S_DMA begin() failed!");
-    while (true) { delay(1000); }
-  }
-  dma_display->setBrightness8(200);
-  dma_display->clearScreen();
-  // Virtual matrix wrapper for chaining/mapping (uses enum PANEL_CHAIN_TYPE)
-  vdisplay = new VirtualMatrixPanel(*dma_display, cur_rows, cur_cols, PANEL_RES_X, PANEL_RES_Y, VIRTUAL_MATRIX_CHAIN_TYPE);
-  // Clear screen
-  vdisplay->fillScreen(dma_display->color565(0, 0, 0));
-  frameBuffer.assign((size_t)VIRT_W() * (size_t)VIRT_H(), 0);
-
-  // Initialize panel-active mask to hardware (all ON by default)
-  g_panel_active.assign((size_t)cur_rows * (size_t)cur_cols, 1);
-
-  // Draw seam guides for current layout
-  if (cur_cols > 1) {
-    for (int y = 0; y < VIRT_H(); ++y) vdisplay->drawPixel(PANEL_RES_X, y, vdisplay->color565(0, 64, 255));
-  }
-  if (cur_rows > 1) {
-    for (int x = 0; x < VIRT_W(); ++x) vdisplay->drawPixel(x, PANEL_RES_Y, vdisplay->color565(0, 64, 255));
+// ================= Boot =================
+// setup() only does what the first picture needs: NVS, the settings blob, the DMA driver,
+// LittleFS and the frame snapshot. The rest of the content, the render and persistence tasks
+// follow; Wi-Fi, the routes, the servers and the sound buffers come up in a background task
+// while the panel is already showing. Each phase is timestamped (us since the app started) for
+// GET /boot; BOOT_FIRST_PIXEL_BUDGET_MS is what a power-cycled panel may take to show content.
+#define BOOT_TASK_CORE 0
+#define BOOT_TASK_PRIO 2
+#define BOOT_FIRST_PIXEL_BUDGET_MS 250
+#define BOOT_MAX_PHASES 16
+
+struct BootPhase { const char* name; uint32_t us; };
+static BootPhase gBootPhases[BOOT_MAX_PHASES];
+static volatile uint8_t gBootPhaseCount = 0;
+static uint32_t gBootFirstPixelUs = 0;          // 0 = nothing restored to show
+static volatile bool gNetworkReady = false;     // loop() serves HTTP only after the boot task is done
+
+static void bootMark(const char* name) {
+  if (gBootPhaseCount < BOOT_MAX_PHASES) {
+    gBootPhases[gBootPhaseCount] = { name, (uint32_t)esp_timer_get_time() };
+    gBootPhaseCount = gBootPhaseCount + 1;
   }
+}
 
-  // Mount LittleFS to serve index.html
-  if (!LittleFS.begin(true)) {
-    Serial.println("LittleFS mount failed");
-  } else {
-    Serial.println("LittleFS mounted");
+static String bootStatusJson() {
+  String json = "{";
+  json += "\"first_pixel_us\":" + String(gBootFirstPixelUs) + ",";
+  json += "\"budget_ms\":" + String(BOOT_FIRST_PIXEL_BUDGET_MS) + ",";
+  json += "\"within_budget\":" + String(gBootFirstPixelUs && gBootFirstPixelUs <= BOOT_FIRST_PIXEL_BUDGET_MS * 1000UL ? "true" : "false") + ",";
+  json += "\"network_ready\":" + String(gNetworkReady ? "true" : "false") + ",";
+  json += "\"phases\":[";
+  for (int i = 0; i < gBootPhaseCount; ++i) {
+    if (i) json += ",";
+    json += "{\"name\":\"" + String(gBootPhases[i].name) + "\",\"us\":" + String(gBootPhases[i].us) + "}";
   }
+  json += "]}";
+  return json;
+}
 
-  // Load saved settings and last frame
-  loadLastSettings();
-  loadLastFrame();
-
-  // Bring up Wi-Fi AP and web server
-  WiFi.mode(WIFI_AP);
-  if (!WiFi.softAP(AP_SSID, AP_PASS)) {
-    Serial.println("SoftAP failed");
-  } else {
-    Serial.print("AP SSID: "); Serial.println(AP_SSID);
-    Serial.print("AP IP: "); Serial.println(WiFi.softAPIP());
-  }
+static void registerRoutes() {
   server.on("/", HTTP_GET, handleRoot);
   server.onNotFound(handleStaticFile);
   server.on("/upload", HTTP_POST, handleUploadDone, handleUploadData);
   server.on("/upload_bg", HTTP_POST, handleUploadBgDone, handleUploadBgData);
+  server.on("/frame_delta", HTTP_POST, handleFrameDeltaDone, handleFrameDeltaData);
+  // Content slots: store once, switch by ID
+  server.on("/slot_upload", HTTP_POST, handleSlotUploadDone, handleSlotUploadData);
+  server.on("/slots", HTTP_GET, [](){
+    size_t resident = 0;
+    for (int id = 0; id < CONTENT_SLOT_COUNT; ++id) if (contentSlots[id].resident) resident += contentSlots[id].residentBytes();
+    String json = "{";
+    json += "\"active\":" + String(gActiveSlot) + ",";
+    json += "\"count\":" + String(CONTENT_SLOT_COUNT) + ",";
+    json += "\"budget\":" + String((uint32_t)gSlotBudget) + ",";
+    json += "\"resident_bytes\":" + String((uint32_t)resident) + ",";
+    json += "\"slots\":[";
+    bool first = true;
+    for (int id = 0; id < CONTENT_SLOT_COUNT; ++id) {
+      if (!contentSlots[id].used) continue;
+      if (!first) json += ",";
+      first = false;
+      appendSlotJson(json, id);
+    }
+    json += "]}";
+    server.send(200, "application/json", json);
+  });
+  server.on("/slot_activate", HTTP_POST, [](){
+    const int id = server.hasArg("id") ? server.arg("id").toInt() : -1;
+    const int64_t t0 = esp_timer_get_time();
+    String err;
+    if (!activateContentSlot(id, err)) {
+      server.send(404, "text/plain", err);
+      return;
+    }
+    const uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    server.send(200, "application/json", "{\"id\":" + String(id) + ",\"us\":" + String(us) + "}");
+    requestPersist(PERSIST_SETTINGS | PERSIST_FRAME);
+  });
+  server.on("/slot_delete", HTTP_POST, [](){
+    const int id = server.hasArg("id") ? server.arg("id").toInt() : -1;
+    if (id < 0 || id >= CONTENT_SLOT_COUNT || !contentSlots[id].used) {
+      server.send(404, "text/plain", "Unknown slot");
+      return;
+    }
+    if (slotPreload.id == id) cancelSlotPreload();
+    LittleFS.remove(slotPath(id));
+    contentSlots[id].drop();
+    contentSlots[id].used = false;
+    if (gActiveSlot == id) gActiveSlot = -1;  // the panel keeps showing it as ad-hoc content
+    server.send(200, "text/plain", "OK");
+  });
+  // Native clock / timer widget
+  server.on("/widget", HTTP_POST, handleWidgetUploadDone, handleWidgetUploadData);
+  server.on("/widget", HTTP_GET, [](){
+    server.send(200, "application/json", widgetStatusJson());
+  });
+  // Timer control without re-uploading the atlas: action=pause|resume|reset, seconds=<new countdown>
+  server.on("/widget_timer", HTTP_POST, [](){
+    const String action = server.arg("action");
+    {
+      FrameLock lock;
+      const int64_t now = esp_timer_get_time();
+      if (action == "pause" && !gWidgetPausedUs) {
+        gWidgetPausedUs = now;
+      } else if (action == "resume" && gWidgetPausedUs) {
+        gWidgetStartUs += now - gWidgetPausedUs;
+        gWidgetPausedUs = 0;
+      } else if (action == "reset") {
+        if (server.hasArg("seconds")) gWidgetSeconds = (uint32_t)constrain(server.arg("seconds").toInt(), 0, 359999);
+        gWidgetStartUs = now;
+        if (gWidgetPausedUs) gWidgetPausedUs = now;
+      }
+    }
+    server.send(200, "application/json", widgetStatusJson());
+  });
+  // On-device playlist over the content slots
+  server.on("/playlist", HTTP_GET, [](){
+    server.send(200, "application/json", playlistStatusJson());
+  });
+  server.on("/playlist", HTTP_POST, [](){
+    const char* err = nullptr;
+    Playlist next;
+    if (!next.parse(server.arg("entries").c_str(), CONTENT_SLOT_COUNT, &err)) {
+      server.send(400, "text/plain", err);
+      return;
+    }
+    next.weighted = server.arg("mode") == "weighted";
+    if (server.hasArg("tz")) gLocalTzMin = constrain(server.arg("tz").toInt(), -720, 840);
+    cancelSlotPreload();
+    playlist = next;
+    gPlaylistOn = false;
+    gPlaylistCur = gPlaylistNext = -1;
+    if (server.arg("enabled") != "0" && !playlist.entries.empty()) startPlaylist();
+    savePlaylist();
+    server.send(200, "application/json", playlistStatusJson());
+  });
+  server.on("/playlist_stop", HTTP_POST, [](){
+    stopPlaylist("stopped by request");
+    server.send(200, "text/plain", "OK");
+  });
+  // Wall clock for playlist time windows when there is no SNTP: /time?epoch=<unix s>&tz=<minutes>
+  server.on("/time", HTTP_POST, [](){
+    const long long epoch = server.hasArg("epoch") ? atoll(server.arg("epoch").c_str()) : 0;
+    if (epoch < 1600000000LL) {
+      server.send(400, "text/plain", "Invalid epoch");
+      return;
+    }
+    struct timeval tv = { (time_t)epoch, 0 };
+    settimeofday(&tv, nullptr);
+    if (server.hasArg("tz")) {
+      const int tz = constrain(server.arg("tz").toInt(), -720, 840);
+      if (tz != gLocalTzMin) { gLocalTzMin = tz; savePlaylist(); }
+    }
+    server.send(200, "application/json", "{\"minute\":" + String(playlistMinuteOfDay()) + "}");
+  });
   server.on("/upload_theme", HTTP_POST, [](){ server.send(200, "text/plain", "Theme upload complete"); }, handleUploadTheme);
   server.on("/stop_clock", HTTP_POST, [](){
-    sendCORSHeaders();
+    FrameLock lock;
     Serial.println("Stopping clock animation");
     animate = false;  // Stop animation
     textPixels.clear();  // Clear text pixels to stop display
+    textAlpha.clear();
+    textSpans.clear();
+    textTinted = false;
     currentMode = MODE_NONE;  // Set mode to none
+    applyPanelBrightness();
     server.send(200, "text/plain", "Clock stopped");
   });
   server.on("/stop_theme", HTTP_POST, [](){
-    sendCORSHeaders();
+    FrameLock lock;
     Serial.println("Stopping theme mode");
     currentMode = MODE_NONE;  // Set mode to none
     // Clear display
     if (vdisplay) {
       vdisplay->fillScreen(0);
     }
+    frameSynced = false;
     server.send(200, "text/plain", "Theme stopped");
   });
-
-  // CORS preflight handler
-  server.on("/upload", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/upload_bg", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/upload_theme", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/theme_status", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/panel_info", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/panel_layout", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/wifi_scan", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/wifi_connect", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/wifi_status", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/yt_stats", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/proxy_image", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/yt_icon_download", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/themes_ids", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/theme_download", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/yt_icon_current", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/upload_icon", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
   // Channel ID save/load
-  server.on("/yt_channel", HTTP_OPTIONS, [](){ sendCORSHeaders(); server.send(200, "text/plain", ""); });
   server.on("/yt_channel", HTTP_GET, [](){
-    sendCORSHeaders();
     String id = gYTChannelId.length() ? gYTChannelId : String(YT_CHANNEL_ID);
     server.send(200, "application/json", String("{\"id\":\"") + id + "\"}");
   });
   server.on("/yt_channel", HTTP_POST, [](){
-    sendCORSHeaders();
     if (!server.hasArg("id")) { server.send(400, "text/plain", "missing id"); return; }
     String id = server.arg("id"); id.trim();
     if (id.length() == 0) { server.send(400, "text/plain", "empty id"); return; }
@@ -1474,14 +3328,6 @@ void setup() {
     gYTChannelId = id;
     server.send(200, "application/json", String("{\"ok\":true,\"id\":\"") + id + "\"}");
   });
-  server.on("/stop_clock", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
-  server.on("/stop_theme", HTTP_OPTIONS, [](){
-    sendCORSHeaders();
-    server.send(200, "text/plain", "");
-  });
   // Panel layout configuration: configure panel arrangement
   // usage: POST /panel_layout layout=1x1
   server.on("/panel_layout", HTTP_POST, [](){
@@ -1491,14 +3337,16 @@ void setup() {
     if (l == "1x1") { new_rows = 1; new_cols = 1; }
     else { server.send(400, "text/plain", "Invalid layout"); return; }
 
-    sendCORSHeaders();
     if (new_rows == cur_rows && new_cols == cur_cols) { server.send(200, "text/plain", "OK"); return; }
+    FrameLock lock;
 
     // Recreate virtual panel with new layout
     cur_rows = new_rows; cur_cols = new_cols;
     if (vdisplay) { delete vdisplay; vdisplay = nullptr; }
     vdisplay = new VirtualMatrixPanel(*dma_display, cur_rows, cur_cols, PANEL_RES_X, PANEL_RES_Y, VIRTUAL_MATRIX_CHAIN_TYPE);
     vdisplay->fillScreen(0);
+    frameSynced = false;
+    gStreamSeq = 0;
 
     // Resize buffers and clear
     frameBuffer.assign((size_t)VIRT_W() * (size_t)VIRT_H(), 0);
@@ -1506,6 +3354,7 @@ void setup() {
       // Invalidate bg if size mismatch; user can re-upload
       if (bgPixels.size() != frameBuffer.size()) { hasBgImage = false; bgPixels.clear(); }
     }
+    if (animate && hasTextImage()) buildMarqueeStrip();
 
     // Redraw seam guides
     if (cur_cols > 1) { for (int y = 0; y < VIRT_H(); ++y) vdisplay->drawPixel(PANEL_RES_X, y, vdisplay->color565(0,64,255)); }
@@ -1513,7 +3362,6 @@ void setup() {
 
     // Adjust active mask to hardware count (1 panel)
     g_panel_active.assign((size_t)cur_rows * (size_t)cur_cols, 1);
-    sendCORSHeaders();
     server.send(200, "text/plain", "OK");
   });
   // Panel info endpoint (detected/configured count)
@@ -1539,12 +3387,10 @@ void setup() {
       json += String(v);
     }
     json += "]}";
-    sendCORSHeaders();
     server.send(200, "application/json", json);
   });
   // WiFi scan endpoint
   server.on("/wifi_scan", HTTP_GET, [](){
-    sendCORSHeaders();
     int n = WiFi.scanNetworks();
     String out = "[";
     for (int i = 0; i < n; ++i) {
@@ -1561,7 +3407,6 @@ void setup() {
   });
   // WiFi connect endpoint
   server.on("/wifi_connect", HTTP_POST, [](){
-    sendCORSHeaders();
     if (!server.hasArg("ssid")) { server.send(400, "application/json", "{\"error\":\"missing ssid\"}"); return; }
     String ssid = server.arg("ssid");
     String pass = server.hasArg("pass") ? server.arg("pass") : "";
@@ -1574,6 +3419,7 @@ void setup() {
       delay(250);
     }
     if (WiFi.status() == WL_CONNECTED) {
+      configTime(0, 0, "pool.ntp.org", "time.google.com");  // wall clock for playlist time windows
       IPAddress ip = WiFi.localIP();
       String json = "{\"status\":\"connected\",\"ssid\":\"" + ssid + "\",\"ip\":\"" + ip.toString() + "\"}";
       server.send(200, "application/json", json);
@@ -1583,7 +3429,6 @@ void setup() {
   });
   // WiFi status endpoint
   server.on("/wifi_status", HTTP_GET, [](){
-    sendCORSHeaders();
     bool connected = (WiFi.status() == WL_CONNECTED);
     String json = "{";
     json += "\"connected\":"; json += connected ? "true" : "false"; json += ",";
@@ -1596,14 +3441,12 @@ void setup() {
   });
   // Sound control: one-shot tick/tock (client alternates per second)
   server.on("/sound_tick", HTTP_POST, [](){
-    sendCORSHeaders();
     // Ignore one-shots if periodic timer is running to avoid duplicates
     if (!gSoundRun) triggerTickTockOnce();
     server.send(200, "application/json", "{\"status\":\"ok\"}");
   });
   // Sound mode selection: /sound_set?mode=off|crick|soft
   server.on("/sound_set", HTTP_POST, [](){
-    sendCORSHeaders();
     String mode = server.hasArg("mode") ? server.arg("mode") : "";
     mode.toLowerCase();
     if (mode == "off") gSoundMode = SOUND_OFF;
@@ -1613,7 +3456,6 @@ void setup() {
   });
   // Sound volume: /sound_volume?level=0..100
   server.on("/sound_volume", HTTP_POST, [](){
-    sendCORSHeaders();
     int level = server.hasArg("level") ? server.arg("level").toInt() : 80;
     if (level < 0) level = 0; if (level > 100) level = 100;
     gSoundVolume = level;
@@ -1625,20 +3467,17 @@ void setup() {
   });
   // Sound periodic timer start/stop
   server.on("/sound_timer_start", HTTP_POST, [](){
-    sendCORSHeaders();
     uint32_t period = server.hasArg("period") ? (uint32_t)server.arg("period").toInt() : 1000U;
     stopSoundTimer(); // ensure single instance
     startSoundTimer(period);
     server.send(200, "application/json", String("{\"period\":") + period + "}");
   });
   server.on("/sound_timer_stop", HTTP_POST, [](){
-    sendCORSHeaders();
     stopSoundTimer();
     server.send(200, "application/json", "{\"status\":\"stopped\"}");
   });
   // System info endpoint
   server.on("/sys_info", HTTP_GET, [](){
-    sendCORSHeaders();
     // Uptime
     uint32_t up = millis();
     // Heap/PSRAM
@@ -1663,16 +3502,85 @@ void setup() {
     json += "\"heap_total\":" + String(heap_total) + ",";
     json += "\"psram_free\":" + String(psram_free) + ",";
     json += "\"psram_total\":" + String(psram_total) + ",";
+    // Pixel buffer pools (bytes)
+    json += "\"pools\":{";
+    appendPoolJson(json, POOL_HOT); json += ",";
+    appendPoolJson(json, POOL_BULK);
+    json += "},";
     json += "\"fs_total\":" + String(fs_total) + ",";
     json += "\"fs_used\":" + String(fs_used) + ",";
     json += "\"cpu_freq_mhz\":" + String(cpu_mhz) + ",";
-    json += "\"wifi_rssi\":" + String(rssi);
+    json += "\"wifi_rssi\":" + String(rssi) + ",";
+    // Render task pacing
+    json += "\"render_period_ms\":" + String(gRenderPeriodMs) + ",";
+    json += "\"frames_rendered\":" + String(gFramesRendered) + ",";
+    json += "\"frames_dropped\":" + String(gFramesDropped) + ",";
+    json += "\"scroll_px\":" + String(scrollDistancePx) + ",";
+    json += "\"max_frame_gap_us\":" + String(gMaxFrameGapUs);
     json += "}";
     server.send(200, "application/json", json);
   });
+  // Frame timing: per-stage histograms (us) and counters; ?reset=1 clears after reporting
+  server.on("/perf", HTTP_GET, [](){
+    String json = "{";
+    json += "\"uptime_ms\":" + String(millis()) + ",";
+    json += "\"cpu_mhz\":" + String(gPerfCyclesPerUs) + ",";
+    json += "\"render_period_ms\":" + String(gRenderPeriodMs) + ",";
+    json += "\"frames_rendered\":" + String(gFramesRendered) + ",";
+    json += "\"frames_dropped\":" + String(gFramesDropped) + ",";
+    json += "\"deadlines_missed\":" + String(gDeadlinesMissed) + ",";
+    json += "\"channel\":{\"connected\":" + String(channelClient.connected() ? "true" : "false");
+    json += ",\"frames\":" + String(gChannelFrames) + ",\"dropped\":" + String(gChannelDropped);
+    json += ",\"resyncs\":" + String(gChannelResyncs) + "},";
+    json += "\"ddp\":{\"packets\":" + String(ddpRx.packets) + ",\"frames\":" + String(ddpRx.frames);
+    json += ",\"lost\":" + String(ddpRx.lost) + ",\"late\":" + String(ddpRx.late);
+    json += ",\"ignored\":" + String(ddpRx.ignored) + "},";
+    json += "\"snapshots\":{\"writes\":" + String(gSnapshotWrites) + ",\"skips\":" + String(gSnapshotSkips);
+    json += ",\"errors\":" + String(gSnapshotErrors) + "},";
+    json += "\"persist\":{\"requests\":" + String(gPersistRequests) + ",\"flushes\":" + String(gPersistFlushes) + "},";
+    json += "\"assets\":{\"served\":" + String(gAssetHits) + ",\"not_modified\":" + String(gAssetNotModified);
+    json += ",\"gzip\":" + String(gAssetGzip) + ",\"cache\":{\"files\":" + String((uint32_t)gAssetCache.entries.size());
+    json += ",\"bytes\":" + String((uint32_t)gAssetCache.used) + ",\"hits\":" + String(gAssetCache.hits);
+    json += ",\"misses\":" + String(gAssetCache.misses) + ",\"evictions\":" + String(gAssetCache.evictions);
+    json += ",\"invalidations\":" + String(gAssetCache.invalidations) + "}},";
+    const HttpServer& http = server.http();
+    json += "\"http_server\":{\"accepted\":" + String(http.accepted) + ",\"requests\":" + String(http.requests);
+    json += ",\"reused\":" + String(http.reused) + ",\"evicted\":" + String(http.evicted);
+    json += ",\"timeouts\":" + String(http.timeouts) + ",\"errors\":" + String(http.errors);
+    json += ",\"active\":" + String(http.active) + ",\"peak\":" + String(http.peak) + "},";
+    json += "\"stages\":{";
+    appendPerfJson(json, "bg_restore", gPerfBgRestore); json += ",";
+    appendPerfJson(json, "blit", gPerfBlit); json += ",";
+    appendPerfJson(json, "push", gPerfPush); json += ",";
+    appendPerfJson(json, "frame", gPerfFrame); json += ",";
+    appendPerfJson(json, "http", gPerfHttp); json += ",";
+    appendPerfJson(json, "save_settings", gPerfSaveSettings); json += ",";
+    appendPerfJson(json, "save_frame", gPerfSaveFrame); json += ",";
+    appendPerfJson(json, "first_frame", gPerfFirstFrame); json += ",";
+    appendPerfJson(json, "ddp_present", gPerfDdpPresent);
+    json += "}}";
+    if (server.hasArg("reset") && server.arg("reset") == "1") {
+      resetPerfStats();
+      gChannelFrames = gChannelDropped = gChannelResyncs = 0;
+      gSnapshotWrites = gSnapshotSkips = gSnapshotErrors = 0;
+      gPersistRequests = gPersistFlushes = 0;
+      gAssetHits = gAssetNotModified = gAssetGzip = 0;
+      gAssetCache.hits = gAssetCache.misses = gAssetCache.evictions = gAssetCache.invalidations = 0;
+      server.http().resetStats();
+      gPerfDdpPresent.requestReset();
+      ddpRx.resetStats();
+      gFramesRendered = 0;
+      gFramesDropped = 0;
+      gMaxFrameGapUs = 0;
+    }
+    server.send(200, "application/json", json);
+  });
+  // Boot phase timestamps and the first-pixel budget
+  server.on("/boot", HTTP_GET, [](){
+    server.send(200, "application/json", bootStatusJson());
+  });
   // YouTube stats endpoint (cached ~5s)
   server.on("/yt_stats", HTTP_GET, [](){
-    sendCORSHeaders();
     // Return cache if fetched within last 10 seconds
     unsigned long now = millis();
     String id = server.hasArg("id") ? server.arg("id") : (gYTChannelId.length() ? gYTChannelId : String(YT_CHANNEL_ID));
@@ -1729,43 +3637,63 @@ void setup() {
     server.send(200, "application/json", yt_cached_json);
   });
 
-  // Simple proxy to fetch remote images (GIF/PNG) to avoid CORS/taint
+  // Simple proxy to fetch remote images (GIF/PNG) to avoid CORS/taint. The request and the
+  // response headers are fetched here; the body is relayed as it arrives, pulled by the server
+  // between other clients, and the fetch is ended when the last byte is out or the client leaves.
+  // The server does not time out a connection whose source is waiting, so an upstream that
+  // stalls is cut here, after the server's idle limit.
+  static const uint32_t PROXY_STALL_MS = HTTP_IDLE_MS;
+  struct ProxyFetch {
+    WiFiClientSecure client;
+    HTTPClient https;
+    int left = -1;              // body bytes still expected, -1 unknown (ends when the remote closes)
+    uint32_t lastMs = 0;
+    ~ProxyFetch() { https.end(); }
+  };
   server.on("/proxy_image", HTTP_GET, [](){
-    sendCORSHeaders();
     if (!server.hasArg("url")) { server.send(400, "text/plain", "missing url"); return; }
     if (WiFi.status() != WL_CONNECTED) { server.send(503, "text/plain", "no internet"); return; }
     String url = server.arg("url");
 
-    WiFiClientSecure client;
-    client.setInsecure();
-    HTTPClient https;
-    if (!https.begin(client, url)) { server.send(500, "text/plain", "begin failed"); return; }
-    https.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    int code = https.GET();
-    if (code <= 0) { https.end(); server.send(502, "text/plain", "fetch failed"); return; }
+    std::shared_ptr<ProxyFetch> fetch = std::make_shared<ProxyFetch>();
+    fetch->client.setInsecure();
+    if (!fetch->https.begin(fetch->client, url)) { server.send(500, "text/plain", "begin failed"); return; }
+    fetch->https.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    fetch->https.setReuse(false);
+    int code = fetch->https.GET();
+    if (code <= 0) { server.send(502, "text/plain", "fetch failed"); return; }
 
-    String ctype = https.header("Content-Type");
+    String ctype = fetch->https.header("Content-Type");
     if (ctype.length() == 0) {
       if (url.endsWith(".gif")) ctype = "image/gif";
       else if (url.endsWith(".png")) ctype = "image/png";
       else ctype = "application/octet-stream";
     }
-    WiFiClient *stream = https.getStreamPtr();
-    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-    server.send(200, ctype, "");
-
-    uint8_t buf[1024];
-    int len;
-    while ((len = stream->readBytes(reinterpret_cast<char*>(buf), sizeof(buf))) > 0) {
-      server.sendContent_P(reinterpret_cast<const char*>(buf), len);
-      delay(0);
-    }
-    https.end();
+    fetch->left = fetch->https.getSize();
+    fetch->lastMs = millis();
+    server.sendSource(200, ctype.c_str(), fetch->left, [fetch](uint8_t* buf, size_t cap) -> long {
+      WiFiClient* stream = fetch->https.getStreamPtr();
+      if (fetch->left == 0 || !stream) return 0;
+      const int avail = stream->available();
+      if (avail <= 0) {
+        if (stream->connected() && millis() - fetch->lastMs <= PROXY_STALL_MS) return -1;
+        if (fetch->left > 0) {
+          Serial.printf("/proxy_image: upstream %s with %d bytes left\n", stream->connected() ? "stalled" : "closed", fetch->left);
+        }
+        return 0;
+      }
+      size_t n = (size_t)avail < cap ? (size_t)avail : cap;
+      if (fetch->left > 0 && n > (size_t)fetch->left) n = (size_t)fetch->left;
+      const int got = stream->read(buf, n);
+      if (got <= 0) return -1;
+      if (fetch->left > 0) fetch->left -= got;
+      fetch->lastMs = millis();
+      return got;
+    });
   });
 
   // Download external icon to LittleFS for same-origin use
   server.on("/yt_icon_download", HTTP_POST, [](){
-    sendCORSHeaders();
     if (!server.hasArg("url")) { server.send(400, "application/json", "{\"error\":\"missing url\"}"); return; }
     if (WiFi.status() != WL_CONNECTED) { server.send(503, "application/json", "{\"error\":\"no_internet\"}"); return; }
     String url = server.arg("url");
@@ -1801,6 +3729,7 @@ void setup() {
     LittleFS.remove("/yt_icon.png");
     LittleFS.remove("/yt_icon.jpg");
     LittleFS.remove("/yt_icon.bin");
+    forgetStaticAssets("/yt_icon");
 
     String path = String("/yt_icon") + ext;
     File f = LittleFS.open(path, "w");
@@ -1824,7 +3753,6 @@ void setup() {
 
   // Fetch theme IDs from remote API using ESP internet
   server.on("/themes_ids", HTTP_GET, [](){
-    sendCORSHeaders();
     if (WiFi.status() != WL_CONNECTED) {
       server.send(503, "application/json", "{\"error\":\"no_internet\"}");
       return;
@@ -1844,7 +3772,6 @@ void setup() {
 
   // Download theme file by ID and save as local icon
   server.on("/theme_download", HTTP_POST, [](){
-    sendCORSHeaders();
     if (!server.hasArg("id")) { server.send(400, "application/json", "{\"error\":\"missing id\"}"); return; }
     if (WiFi.status() != WL_CONNECTED) { server.send(503, "application/json", "{\"error\":\"no_internet\"}"); return; }
     String id = server.arg("id");
@@ -1869,6 +3796,7 @@ void setup() {
     LittleFS.remove("/yt_icon.png");
     LittleFS.remove("/yt_icon.jpg");
     LittleFS.remove("/yt_icon.bin");
+    forgetStaticAssets("/yt_icon");
 
     String path = String("/yt_icon") + ext;
     File f = LittleFS.open(path, "w");
@@ -1887,7 +3815,6 @@ void setup() {
 
   // Stream currently saved icon with CORS for cross-origin preview
   server.on("/yt_icon_current", HTTP_GET, [](){
-    sendCORSHeaders();
     const char* candidates[] = { "/yt_icon.gif", "/yt_icon.png", "/yt_icon.jpg", "/yt_icon.bin" };
     const char* types[]      = { "image/gif",  "image/png",   "image/jpeg",  "application/octet-stream" };
     File f; const char* ctype = nullptr;
@@ -1896,7 +3823,6 @@ void setup() {
     }
     if (!f) { server.send(404, "application/json", "{\"error\":\"not_found\"}"); return; }
     server.streamFile(f, String(ctype));
-    f.close();
   });
 
   // Upload a GIF/PNG icon directly from browser and save in LittleFS
@@ -1904,7 +3830,6 @@ void setup() {
   static bool _iconUploadOK = false;
   static String _iconSavedPath;
   server.on("/upload_icon", HTTP_POST, [](){
-    sendCORSHeaders();
     String res = String("{\"ok\":") + (_iconUploadOK?"true":"false") + ",\"path\":\"" + _iconSavedPath + "\"}";
     server.send(200, "application/json", res);
   }, [](){
@@ -1923,6 +3848,7 @@ void setup() {
       LittleFS.remove("/yt_icon.png");
       LittleFS.remove("/yt_icon.jpg");
       LittleFS.remove("/yt_icon.bin");
+      forgetStaticAssets("/yt_icon");
       _iconUploadFile = LittleFS.open(path, FILE_WRITE);
       if (_iconUploadFile) _iconSavedPath = path;
     } else if (up.status == UPLOAD_FILE_WRITE) {
@@ -1933,157 +3859,168 @@ void setup() {
   });
   // Theme status endpoint
   server.on("/theme_status", HTTP_GET, [](){
-    sendCORSHeaders();
     File f = LittleFS.open("/theme.html", "r");
     String status = f ? "{\"theme_uploaded\":true}" : "{\"theme_uploaded\":false}";
     if (f) f.close();
     server.send(200, "application/json", status);
   });
+}
+
+static void bringUpNetwork() {
+  WiFi.mode(WIFI_AP);
+  if (!WiFi.softAP(AP_SSID, AP_PASS)) {
+    Serial.println("SoftAP failed");
+  } else {
+    Serial.print("AP SSID: "); Serial.println(AP_SSID);
+    Serial.print("AP IP: "); Serial.println(WiFi.softAPIP());
+  }
+  bootMark("wifi_ap");
+  registerRoutes();
+  bootMark("routes");
+  warmAssetCache();
+  bootMark("asset_cache");
+  buildSoundBuffers();  // before any route can reach the sound code
+  bootMark("sound");
   server.begin();
+  channelServer.begin();
+  channelServer.setNoDelay(true);
+  startDdpReceiver();
+  bootMark("network_ready");
+  gNetworkReady = true;
 }
 
-void loop() {
-  // Optimize server handling to reduce animation lag
-  uint32_t serverStart = millis();
-  server.handleClient();
-  uint32_t serverTime = millis() - serverStart;
+static void bootTask(void* arg) {
+  bringUpNetwork();
+  vTaskDelete(NULL);
+}
 
-  // Brief yield to ensure smooth clock timing
-  if (serverTime > 1) {
-    delay(1); // Small delay to prevent blocking
+static void startBootTask() {
+  if (xTaskCreatePinnedToCore(bootTask, "boot", 8192, nullptr, BOOT_TASK_PRIO, nullptr, BOOT_TASK_CORE) != pdPASS) {
+    bringUpNetwork();  // no memory for the task: bring the network up inline
   }
+}
 
-  // Animate if enabled, we have a text bitmap, and we're in clock mode
-  if (animate && !textPixels.empty() && currentMode == MODE_CLOCK) {
-    uint32_t now = millis();
+void setup() {
+  Serial.begin(115200);
+  Serial.println("Starting HUB75 + WebServer for Khmer text...");
+  bootMark("start");
 
-    // Ultra-fast animation timing optimization
-    uint32_t adjustedTime = now;
+  // Initialize NVS
+  esp_err_t err = nvs_flash_init();
+  if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+    // NVS partition was truncated and needs to be erased
+    Serial.println("Erasing NVS flash...");
+    ESP_ERROR_CHECK(nvs_flash_erase());
+    err = nvs_flash_init();
+  }
+  ESP_ERROR_CHECK(err);
+  bootMark("nvs");
 
-    // More aggressive compensation for server handling time
-    if (serverTime > 2) {
-      // Compensate for any server time > 2ms to maintain smooth animation
-      adjustedTime = now + (serverTime - 2);
-    }
+  // One blob read; brightness and the display mode are known before the panel lights up
+  loadLastSettings();
+  bootMark("settings");
 
-    // Ultra-fast timing check with microsecond precision for smooth animation
-    uint32_t timeDiff = adjustedTime - lastAnim;
+  randomSeed(micros());
+  gPerfCyclesPerUs = (uint32_t)getCpuFrequencyMhz();
+  resetPerfStats();
 
-    // Use sub-millisecond timing for ultra-smooth animation at fastest speeds
-    if (timeDiff >= animSpeedMs) {
-      // Only log occasionally to avoid Serial Monitor flooding
-      static uint32_t debugCounter = 0;
-      if (++debugCounter % 200 == 0) { // Log every 200th frame (even less frequent)
-        Serial.printf("Smooth animation: speed=%dms, serverTime=%lums, timeDiff=%lums\n", animSpeedMs, serverTime, timeDiff);
-      }
-      lastAnim = adjustedTime;
+  // Module configuration
+  HUB75_I2S_CFG mxconfig(
+    PANEL_RES_X,
+    PANEL_RES_Y,
+    PANEL_CHAIN
+  );
 
-      // Optimized background composition - use cached background when possible
-      if (hasBgImage && bgPixels.size() == frameBuffer.size()) {
-        // Fast copy for background image
-        std::copy(bgPixels.begin(), bgPixels.end(), frameBuffer.begin());
-      } else {
-        // Optimized fill for solid color
-        std::fill(frameBuffer.begin(), frameBuffer.end(), bgColor);
-      }
+  // Pin mapping
+  mxconfig.gpio.r1 = R1_PIN;
+  mxconfig.gpio.g1 = G1_PIN;
+  mxconfig.gpio.b1 = B1_PIN;
+  mxconfig.gpio.r2 = R2_PIN;
+  mxconfig.gpio.g2 = G2_PIN;
+  mxconfig.gpio.b2 = B2_PIN;
+  mxconfig.gpio.a = A_PIN;
+  mxconfig.gpio.b = B_PIN;
+  mxconfig.gpio.c = C_PIN;
+  mxconfig.gpio.d = D_PIN;
+  mxconfig.gpio.e = E_PIN;
+  mxconfig.gpio.lat = LAT_PIN;
+  mxconfig.gpio.oe = OE_PIN;
+  mxconfig.gpio.clk = CLK_PIN;
 
-      // Optimized text blitting - reduce function call overhead
-      const bool hasAlpha = !textAlpha.empty();
-      const uint16_t frameW = VIRT_W();
-
-      // Pre-calculate frequently used values
-      const int imgH_local = imgH;
-      const int imgW_local = imgW;
-      const int baseY_local = baseY;
-      const int userOffX_local = userOffX;
-
-      // Optimized blit function
-      for (int i = 0; i < (int)heads.size(); i++) {
-        int16_t x0 = heads[i] + userOffX_local;
-
-        // Bounds checking optimization
-        if (x0 + imgW_local <= 0 || x0 >= frameW) continue;
-
-        // Optimized inner loops with minimal bounds checks
-        for (int y = 0; y < imgH_local; ++y) {
-          int dstY = baseY_local + y;
-          if (dstY < 0 || dstY >= (int)VIRT_H()) continue;
-
-          int srcRow = y * imgW_local;
-          size_t frameRow = (size_t)dstY * frameW;
-
-          // Optimized inner loop with pre-calculated bounds
-          int startX = (x0 < 0) ? -x0 : 0;
-          int endX = (x0 + imgW_local > frameW) ? (frameW - x0) : imgW_local;
-
-          for (int x2 = startX; x2 < endX; ++x2) {
-            int dstX = x0 + x2;
-            size_t si = (size_t)srcRow + (size_t)x2;
-            size_t frameIdx = frameRow + (size_t)dstX;
-
-            // Optimized alpha blending
-            if (!hasAlpha) {
-              frameBuffer[frameIdx] = textPixels[si];
-            } else {
-              uint8_t a = textAlpha[si];
-              if (a == 0) continue;
-              frameBuffer[frameIdx] = blend565(textPixels[si], frameBuffer[frameIdx], a);
-            }
-          }
-        }
-      }
+  // Panel driver/timing options
+  mxconfig.clkphase = false;
+  mxconfig.driver = HUB75_I2S_CFG::FM6124;
+
+  // Display Setup
+  dma_display = new MatrixPanel_I2S_DMA(mxconfig);
+  if (!dma_display->begin()) {
+    Serial.println("MatrixPanel_I2S_DMA begin() failed!");
+    while (true) { delay(1000); }
+  }
+  applyPanelBrightness();
+  dma_display->clearScreen();
+  // Virtual matrix wrapper for chaining/mapping (uses enum PANEL_CHAIN_TYPE)
+  vdisplay = new VirtualMatrixPanel(*dma_display, cur_rows, cur_cols, PANEL_RES_X, PANEL_RES_Y, VIRTUAL_MATRIX_CHAIN_TYPE);
+  // Clear screen
+  vdisplay->fillScreen(dma_display->color565(0, 0, 0));
+  frameBuffer.assign((size_t)VIRT_W() * (size_t)VIRT_H(), 0);
 
-      // Display the updated frame
-      vdisplay->drawRGBBitmap(0, 0, frameBuffer.data(), VIRT_W(), VIRT_H());
+  // Initialize panel-active mask to hardware (all ON by default)
+  g_panel_active.assign((size_t)cur_rows * (size_t)cur_cols, 1);
 
-      // advance all heads - optimized
-      const int gap = (int)loopOffsetPx;
-      int spacing = (int)imgW_local + gap;
-      if (spacing < 1) spacing = 1; // Ensure minimum spacing
+  // Draw seam guides for current layout
+  if (cur_cols > 1) {
+    for (int y = 0; y < VIRT_H(); ++y) vdisplay->drawPixel(PANEL_RES_X, y, vdisplay->color565(0, 64, 255));
+  }
+  if (cur_rows > 1) {
+    for (int x = 0; x < VIRT_W(); ++x) vdisplay->drawPixel(x, PANEL_RES_Y, vdisplay->color565(0, 64, 255));
+  }
 
-      if (animDir < 0) { // left scrolling
-        // Move all heads left
-        for (int i = 0; i < (int)heads.size(); i++) {
-          heads[i] -= 1;
-        }
+  bootMark("display");
 
-        // Recycle any head that goes completely off screen - FIXED VERSION
-        for (int i = 0; i < (int)heads.size(); i++) {
-          if (heads[i] + imgW <= 0) {
-            // Find the rightmost head to position after it
-            int rightmost = heads[0];
-            for (int j = 1; j < (int)heads.size(); j++) {
-              if (heads[j] > rightmost) rightmost = heads[j];
-            }
-            // Position immediately after the rightmost head with proper spacing
-            heads[i] = rightmost + spacing;
-            // Debug: ensure smooth transition
-            // Serial.printf("Recycled head %d: old pos=%d, new pos=%d, spacing=%d\n", i, heads[i] - spacing, heads[i], spacing);
-          }
-        }
-      } else { // right scrolling
-        // Move all heads right
-        for (int i = 0; i < (int)heads.size(); i++) {
-          heads[i] += 1;
-        }
+  // Mount LittleFS to serve index.html
+  if (!LittleFS.begin(true)) {
+    Serial.println("LittleFS mount failed");
+  }
+  bootMark("littlefs");
+
+  // First pixel: the last frame as it was on the panel
+  const bool frameShown = showLastFrame();
+  if (frameShown) {
+    gBootFirstPixelUs = (uint32_t)esp_timer_get_time();
+    bootMark("first_pixel");
+    if (gBootFirstPixelUs > BOOT_FIRST_PIXEL_BUDGET_MS * 1000UL) {
+      Serial.printf("Boot: first pixel after %u ms, budget %u ms\n", (unsigned)(gBootFirstPixelUs / 1000), (unsigned)BOOT_FIRST_PIXEL_BUDGET_MS);
+    }
+  }
 
-        // Recycle any head that goes completely off screen - FIXED VERSION
-        for (int i = 0; i < (int)heads.size(); i++) {
-          if (heads[i] >= VIRT_W()) {
-            // Find the leftmost head to position before it
-            int leftmost = heads[0];
-            for (int j = 1; j < (int)heads.size(); j++) {
-              if (heads[j] < leftmost) leftmost = heads[j];
-            }
-            // Position immediately before the leftmost head with proper spacing
-            heads[i] = leftmost - spacing;
-            // Debug: ensure smooth transition
-            // Serial.printf("Recycled head %d: old pos=%d, new pos=%d, spacing=%d\n", i, heads[i] + spacing, heads[i], spacing);
-          }
-        }
-      }
+  // The rest of the saved content
+  loadLastContent(frameShown);
+  loadContentSlotIndex();
+  if (gActiveSlot >= CONTENT_SLOT_COUNT || (gActiveSlot >= 0 && !contentSlots[gActiveSlot].used)) gActiveSlot = -1;
+  loadPlaylist();
+  if (currentMode == MODE_WIDGET && !loadWidget()) currentMode = MODE_NONE;
+  applyPanelBrightness();
+  bootMark("content");
+
+  // Start the paced render task before Wi-Fi so a restored marquee scrolls right away
+  startRenderTask();
+  startPersistTask();
+  bootMark("tasks");
+
+  // Wi-Fi AP, routes and servers come up in the background
+  startBootTask();
+}
+
+void loop() {
+  // HTTP and the frame channel once the boot task has them up; scrolling is driven by the render task
+  if (gNetworkReady) {
+    {
+      PerfScope perf(gPerfHttp);
+      server.handleClient();
     }
-  } else {
-    delay(2); // yield CPU when idle
+    frameChannelPoll();
   }
+  playlistPoll();
+  delay(1); // yield to lower-priority tasks between polls
 }
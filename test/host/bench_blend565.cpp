@@ -0,0 +1,102 @@
+// Host benchmark: ns (and TSC cycles on x86) per pixel for the blend565.h kernels against the
+// scalar reference they replaced (blend565_ref.h)
+//
+//     make blend_bench
+//
+// Each kernel blends the same rows with three coverages: glyph rows (runs of 0 and 255 with
+// antialiased edges, as text renders), text-like (the same mix, but every pixel drawn at
+// random, so the four-pixel groups rarely skip) and every pixel partially covered, the worst
+// case. Every trial starts from the same destination rows and the best of TRIALS is reported.
+// The Makefile builds this without auto-vectorization, since the device compiler does not
+// vectorize either; compare runs on the same host. The device cost is in /perf ("blit", "frame").
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "blend565.h"
+#include "blend565_ref.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t cycles() { return __rdtsc(); }
+static const bool kHaveCycles = true;
+#else
+static inline uint64_t cycles() { return 0; }
+static const bool kHaveCycles = false;
+#endif
+
+static const int ROW = 256;          // a 4-panel wide marquee strip row
+static const int ROWS = 64;
+
+struct Rows {
+  std::vector<uint16_t> src, dst;
+  std::vector<uint8_t> alpha;
+};
+
+static uint32_t gSink = 0;
+
+static const int TRIALS = 7;
+
+template <typename Fn> static void run(const char* name, const Rows& rows, int passes, Fn fn) {
+  using clk = std::chrono::steady_clock;
+  std::vector<uint16_t> dst(rows.dst.size());
+  double bestNs = 0, bestCycles = 0;
+  for (int t = 0; t < TRIALS; ++t) {
+    double ns = 0, cyc = 0;
+    for (int p = 0; p < passes; ++p) {
+      memcpy(dst.data(), rows.dst.data(), dst.size() * sizeof(uint16_t));
+      const auto t0 = clk::now();
+      const uint64_t c0 = cycles();
+      for (int r = 0; r < ROWS; ++r) fn(&dst[r * ROW], &rows.src[r * ROW], &rows.alpha[r * ROW], ROW);
+      cyc += (double)(cycles() - c0);
+      ns += std::chrono::duration<double, std::nano>(clk::now() - t0).count();
+    }
+    if (t == 0 || ns < bestNs) bestNs = ns;
+    if (t == 0 || cyc < bestCycles) bestCycles = cyc;
+    for (uint16_t v : dst) gSink += v;
+  }
+  const double px = (double)passes * ROWS * ROW;
+  if (kHaveCycles) printf("  %-22s %6.2f ns/px  %6.2f cycles/px\n", name, bestNs / px, bestCycles / px);
+  else printf("  %-22s %6.2f ns/px\n", name, bestNs / px);
+}
+
+int main(int argc, char** argv) {
+  int passes = 300;
+  for (int i = 1; i + 1 < argc; ++i) if (!strcmp(argv[i], "--passes")) passes = atoi(argv[i + 1]);
+
+  static const char* const kMix[] = { "glyph-row", "text-like", "partial" };
+  for (int mix = 0; mix < 3; ++mix) {
+    uint32_t seed = 0xC0FFEEu;
+    Rows rows;
+    rows.src.resize(ROW * ROWS);
+    rows.dst.resize(ROW * ROWS);
+    rows.alpha.resize(ROW * ROWS);
+    for (int i = 0; i < ROW * ROWS; ++i) {
+      rows.src[i] = (uint16_t)blendRand(seed);
+      rows.dst[i] = (uint16_t)blendRand(seed);
+      rows.alpha[i] = mix == 1 ? textLikeAlpha(seed) : (uint8_t)(1 + blendRand(seed) % 254);
+    }
+    if (mix == 0) {
+      for (int r = 0; r < ROWS; ++r) glyphRowAlpha(&rows.alpha[r * ROW], ROW, seed);
+    }
+    const uint16_t color = 0xFD20;
+    printf("%s coverage (%d px x %d passes, best of %d)\n", kMix[mix], ROW * ROWS, passes, TRIALS);
+    run("reference per pixel", rows, passes, [](uint16_t* d, const uint16_t* s, const uint8_t* a, int n) {
+      for (int i = 0; i < n; ++i) d[i] = blend565Ref(s[i], d[i], a[i]);
+    });
+    run("blend565 per pixel", rows, passes, [](uint16_t* d, const uint16_t* s, const uint8_t* a, int n) {
+      for (int i = 0; i < n; ++i) d[i] = blend565(s[i], d[i], a[i]);
+    });
+    run("blendRow565", rows, passes, [](uint16_t* d, const uint16_t* s, const uint8_t* a, int n) {
+      blendRow565(d, s, a, n);
+    });
+    run("reference solid", rows, passes, [color](uint16_t* d, const uint16_t*, const uint8_t* a, int n) {
+      for (int i = 0; i < n; ++i) d[i] = blend565Ref(color, d[i], a[i]);
+    });
+    run("blendRowSolid565", rows, passes, [color](uint16_t* d, const uint16_t*, const uint8_t* a, int n) {
+      blendRowSolid565(d, color, a, n);
+    });
+  }
+  printf("(checksum %u)\n", (unsigned)gSink);
+  return 0;
+}
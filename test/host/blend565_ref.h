@@ -0,0 +1,49 @@
+// The scalar blend565() the kernels in include/blend565.h replaced: unpack to 8-bit channels
+// and divide by 255 three times. Kept as the reference for the host test and benchmark.
+#pragma once
+
+#include <stdint.h>
+
+static inline uint16_t blend565Ref(uint16_t src565, uint16_t dst565, uint8_t a) {
+  if (a == 0) return dst565;
+  if (a == 255) return src565;
+  uint8_t sr = (src565 >> 8) & 0xF8; sr |= sr >> 5;
+  uint8_t sg = (src565 >> 3) & 0xFC; sg |= sg >> 6;
+  uint8_t sb = (src565 << 3) & 0xF8; sb |= sb >> 5;
+  uint8_t dr = (dst565 >> 8) & 0xF8; dr |= dr >> 5;
+  uint8_t dg = (dst565 >> 3) & 0xFC; dg |= dg >> 6;
+  uint8_t db = (dst565 << 3) & 0xF8; db |= db >> 5;
+  uint16_t ia = 255 - a;
+  uint8_t r = (uint8_t)((sr * a + dr * ia + 127) / 255);
+  uint8_t g = (uint8_t)((sg * a + dg * ia + 127) / 255);
+  uint8_t b = (uint8_t)((sb * a + db * ia + 127) / 255);
+  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// xorshift32: fast, deterministic across runs and hosts
+static inline uint32_t blendRand(uint32_t& s) {
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  return s;
+}
+
+// Coverage as text rasterizes it: mostly empty or solid, with antialiased edges
+static inline uint8_t textLikeAlpha(uint32_t& s) {
+  const uint32_t r = blendRand(s) % 100;
+  if (r < 55) return 0;
+  if (r < 85) return 255;
+  return (uint8_t)(1 + blendRand(s) % 254);
+}
+
+// A row of glyph coverage: gaps of 2..13 empty pixels and strokes of 1..6 solid ones, each
+// stroke with an antialiased pixel on both sides, as rendered text rows come out
+static inline void glyphRowAlpha(uint8_t* a, int n, uint32_t& s) {
+  int i = 0;
+  while (i < n) {
+    for (int gap = 2 + (int)(blendRand(s) % 12); gap > 0 && i < n; --gap) a[i++] = 0;
+    if (i < n) a[i++] = (uint8_t)(1 + blendRand(s) % 254);
+    for (int run = 1 + (int)(blendRand(s) % 6); run > 0 && i < n; --run) a[i++] = 255;
+    if (i < n) a[i++] = (uint8_t)(1 + blendRand(s) % 254);
+  }
+}
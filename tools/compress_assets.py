@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""
+Write gzip siblings for the web UI before it goes onto LittleFS.
+
+    python3 tools/compress_assets.py            # compresses data/ in place
+    python3 tools/compress_assets.py --clean    # removes the .gz files again
+
+For every text asset and font under data/ that shrinks by at least --min-gain,
+<file>.gz is written next to it (deterministic: no name or timestamp in the gzip
+header, so unchanged sources give byte-identical output and the same ETag on the
+device). A .gz whose source is gone or no longer compresses well is removed.
+The firmware serves the .gz with Content-Encoding: gzip to clients that accept it.
+
+`make upload_html` runs this before `pio run -t uploadfs`.
+"""
+
+import argparse
+import gzip
+import os
+import sys
+
+COMPRESSIBLE = {".html", ".css", ".js", ".json", ".svg", ".txt", ".md", ".ttf", ".otf"}
+
+
+def gzip_bytes(raw):
+    return gzip.compress(raw, compresslevel=9, mtime=0)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--data", default=os.path.join(os.path.dirname(__file__), "..", "data"))
+    ap.add_argument("--min-bytes", type=int, default=512, help="leave smaller files alone")
+    ap.add_argument("--min-gain", type=float, default=0.10, help="required size reduction")
+    ap.add_argument("--clean", action="store_true", help="only remove .gz siblings")
+    args = ap.parse_args()
+
+    raw_total = sent_total = written = removed = 0
+    for root, _, files in os.walk(args.data):
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            if name.endswith(".gz"):
+                source = path[:-3]
+                if args.clean or not os.path.exists(source):
+                    os.remove(path)
+                    removed += 1
+                continue
+            if args.clean or os.path.splitext(name)[1].lower() not in COMPRESSIBLE:
+                continue
+            with open(path, "rb") as f:
+                raw = f.read()
+            gz_path = path + ".gz"
+            packed = gzip_bytes(raw)
+            raw_total += len(raw)
+            if len(raw) < args.min_bytes or len(packed) > len(raw) * (1.0 - args.min_gain):
+                if os.path.exists(gz_path):
+                    os.remove(gz_path)
+                    removed += 1
+                sent_total += len(raw)
+                continue
+            sent_total += len(packed)
+            old = None
+            if os.path.exists(gz_path):
+                with open(gz_path, "rb") as f:
+                    old = f.read()
+            if old != packed:
+                with open(gz_path, "wb") as f:
+                    f.write(packed)
+                written += 1
+
+    if args.clean:
+        print("removed %d .gz files" % removed)
+    else:
+        print("%d written, %d removed; compressible assets %d -> %d bytes" % (written, removed, raw_total, sent_total))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""
+Packet rate and end-to-end latency of the DDP receiver (UDP port 4048).
+
+With the panel reachable, run:
+
+    python3 tools/ddp_bench.py --host 192.168.4.1 --seconds 10
+
+Every frame is a full RGB888 image split into 1440-byte packets (480 pixels, as most
+DDP senders do); the last packet carries the push flag plus the query flag, which makes
+the device reply once the frame is on the panel. The time from sending the push packet to
+the reply is the end-to-end latency. --loss and --reorder drop or swap packets to exercise
+the sequence handling; the device's own view (lost, late) is in /perf under "ddp".
+--no-ack sends open loop as fast as possible and only reports packets per second.
+
+Without hardware,
+
+    python3 tools/ddp_bench.py --loopback
+
+runs against a local receiver that assembles and acknowledges frames the same way.
+"""
+
+import argparse
+import json
+import random
+import socket
+import struct
+import threading
+import time
+import urllib.request
+
+DDP_PORT = 4048
+CHUNK = 1440
+PANEL_W, PANEL_H = 128, 64   # one module, PANEL_RES_X x PANEL_RES_Y
+
+FLAG_VER1, FLAG_PUSH, FLAG_QUERY, FLAG_REPLY = 0x40, 0x01, 0x02, 0x04
+TYPE_RGB24, ID_DISPLAY = 0x0B, 1
+
+
+def packet(seq, offset, data, push=False, query=False):
+    flags = FLAG_VER1 | (FLAG_PUSH if push else 0) | (FLAG_QUERY if query else 0)
+    return struct.pack(">BBBBIH", flags, seq, TYPE_RGB24, ID_DISPLAY, offset, len(data)) + data
+
+
+def frame_bytes(w, h, n):
+    """Diagonal color bands that move one pixel per frame."""
+    row = bytearray()
+    for x in range(w + h):
+        v = ((x + n) * 4) & 0xFF
+        row += bytes((v, 255 - v, (v * 2) & 0xFF))
+    return b"".join(bytes(row[y * 3:(y + w) * 3]) for y in range(h))
+
+
+class Sender:
+    def __init__(self, sock, addr, ack, loss, reorder):
+        self.sock, self.addr, self.ack = sock, addr, ack
+        self.loss, self.reorder = loss, reorder
+        self.seq = 0
+        self.packets = 0
+
+    def next_seq(self):
+        self.seq = self.seq % 15 + 1
+        return self.seq
+
+    def send_frame(self, data):
+        pkts = []
+        for off in range(0, len(data), CHUNK):
+            last = off + CHUNK >= len(data)
+            pkts.append(packet(self.next_seq(), off, data[off:off + CHUNK], push=last, query=last and self.ack))
+        body, push = pkts[:-1], pkts[-1]
+        body = [p for p in body if random.random() >= self.loss]
+        if self.reorder:
+            for i in range(0, len(body) - 1, 2):
+                if random.random() < self.reorder:
+                    body[i], body[i + 1] = body[i + 1], body[i]
+        for p in body + [push]:
+            self.sock.sendto(p, self.addr)
+        self.packets += len(body) + 1
+        return time.time()
+
+
+def run(host, port, w, h, seconds, ack, loss, reorder):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(0.5)
+    sender = Sender(sock, (host, port), ack, loss, reorder)
+    frames = [frame_bytes(w, h, n) for n in range(32)]
+    latencies, timeouts, n = [], 0, 0
+    t0 = time.time()
+    while time.time() - t0 < seconds:
+        sent = sender.send_frame(frames[n % len(frames)])
+        n += 1
+        if not ack:
+            continue
+        try:
+            while True:
+                reply, _ = sock.recvfrom(64)
+                if len(reply) >= 10 and reply[0] & FLAG_REPLY and reply[1] == sender.seq:
+                    latencies.append(time.time() - sent)
+                    break
+        except socket.timeout:
+            timeouts += 1
+    dt = time.time() - t0
+    sock.close()
+    return {"frames": n, "packets": sender.packets, "dt": dt, "latency": latencies, "timeouts": timeouts}
+
+
+def receiver(sock, stats):
+    """Local stand-in for the device: assemble into a back buffer, copy on push, reply."""
+    back = bytearray(stats["w"] * stats["h"] * 3)
+    front = bytearray(len(back))
+    while True:
+        try:
+            data, addr = sock.recvfrom(2048)
+        except OSError:
+            return
+        stats["packets"] += 1
+        flags, seq, _, _, offset, length = struct.unpack_from(">BBBBIH", data)
+        back[offset:offset + length] = data[10:10 + length]
+        if flags & FLAG_PUSH:
+            front[:] = back
+            stats["frames"] += 1
+            if flags & FLAG_QUERY:
+                sock.sendto(struct.pack(">BBBBIH", FLAG_VER1 | FLAG_REPLY | FLAG_PUSH, seq, TYPE_RGB24,
+                                        ID_DISPLAY, stats["frames"], 0), addr)
+
+
+def report(r):
+    print("%8.0f pkt/s  %6.1f frames/s  %6d frames  %4d ack timeouts"
+          % (r["packets"] / r["dt"], r["frames"] / r["dt"], r["frames"], r["timeouts"]))
+    lat = sorted(r["latency"])
+    if lat:
+        pct = lambda p: lat[min(len(lat) - 1, int(p * len(lat)))] * 1000.0
+        print("latency  p50 %6.2f ms  p99 %6.2f ms  max %6.2f ms" % (pct(0.5), pct(0.99), lat[-1] * 1000.0))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="192.168.4.1")
+    ap.add_argument("--port", type=int, default=DDP_PORT)
+    ap.add_argument("--width", type=int, default=0, help="frame width (default: panel width)")
+    ap.add_argument("--height", type=int, default=0, help="frame height (default: panel height)")
+    ap.add_argument("--seconds", type=float, default=10.0)
+    ap.add_argument("--no-ack", action="store_true", help="open loop, no latency measurement")
+    ap.add_argument("--loss", type=float, default=0.0, help="fraction of data packets to drop")
+    ap.add_argument("--reorder", type=float, default=0.0, help="probability of swapping packet pairs")
+    ap.add_argument("--loopback", action="store_true", help="run against a local receiver")
+    args = ap.parse_args()
+
+    host, w, h = args.host, args.width, args.height
+    if args.loopback:
+        host, w, h = "127.0.0.1", w or PANEL_W, h or PANEL_H
+        rx = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        rx.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+        rx.bind((host, 0))
+        stats = {"w": w, "h": h, "packets": 0, "frames": 0}
+        threading.Thread(target=receiver, args=(rx, stats), daemon=True).start()
+        port = rx.getsockname()[1]
+    else:
+        port = args.port
+        if not w or not h:
+            info = json.loads(urllib.request.urlopen("http://%s/panel_info" % host, timeout=5.0).read())
+            w, h = w or info["cols"] * PANEL_W, h or info["rows"] * PANEL_H
+
+    print("%s:%d, %dx%d, %d packets per frame" % (host, port, w, h, (w * h * 3 + CHUNK - 1) // CHUNK))
+    report(run(host, port, w, h, args.seconds, not args.no_ack, args.loss, args.reorder))
+    if args.loopback:
+        print("receiver: %d packets, %d frames" % (stats["packets"], stats["frames"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""
+Frame rate and latency of the TCP frame channel versus POST /frame_delta.
+
+With the panel reachable, run:
+
+    python3 tools/frame_channel_bench.py --host 192.168.4.1 --seconds 10
+
+The script streams a synthetic animation (a bar sweeping across the panel, so every
+frame changes a few tiles) first over the persistent channel on port 3333, then as one
+HTTP POST per frame, and prints frames per second and send-to-acknowledge latency for
+both. Frames the device coalesced away are counted under "channel" in /perf. Without hardware,
+
+    python3 tools/frame_channel_bench.py --loopback
+
+runs the channel against a local emulator of the device side of the protocol, which
+checks the framing and credit flow and shows the client's own overhead.
+"""
+
+import argparse
+import json
+import socket
+import struct
+import threading
+import time
+import urllib.request
+import uuid
+
+CHANNEL_PORT = 3333
+TILE = 8
+PANEL_W, PANEL_H = 128, 64   # one module, PANEL_RES_X x PANEL_RES_Y
+
+
+def header(w, h, base, seq, keyframe):
+    return struct.pack("<2sBBBBHHII", b"FD", 1, TILE, 1 if keyframe else 0, 0, w, h, base, seq)
+
+
+class Animation:
+    """Bar sweeping left to right; each frame sends only the tiles it touched."""
+
+    def __init__(self, w, h):
+        self.w, self.h = w, h
+        self.cols, self.rows = (w + TILE - 1) // TILE, (h + TILE - 1) // TILE
+        self.x = 0
+
+    def pixel(self, x, y):
+        return 0xF800 if abs(x - self.x) < 4 else 0x0000
+
+    def keyframe(self, seq):
+        px = [self.pixel(x, y) for y in range(self.h) for x in range(self.w)]
+        return header(self.w, self.h, 0, seq, True) + struct.pack("<%dH" % len(px), *px)
+
+    def delta(self, base, seq):
+        old = self.x
+        self.x = (self.x + 2) % self.w
+        cols = sorted({c for c in range(self.cols) if abs(c * TILE + TILE / 2 - old) < TILE + 4
+                       or abs(c * TILE + TILE / 2 - self.x) < TILE + 4})
+        body = [header(self.w, self.h, base, seq, False), struct.pack("<H", len(cols) * self.rows)]
+        for r in range(self.rows):
+            for c in cols:
+                body.append(struct.pack("<H", r * self.cols + c))
+                x0, y0 = c * TILE, r * TILE
+                px = [self.pixel(x, y) for y in range(y0, min(y0 + TILE, self.h))
+                      for x in range(x0, min(x0 + TILE, self.w))]
+                body.append(struct.pack("<%dH" % len(px), *px))
+        return b"".join(body)
+
+
+def recv_exact(sock, n):
+    buf = b""
+    while len(buf) < n:
+        chunk = sock.recv(n - len(buf))
+        if not chunk:
+            raise ConnectionError("channel closed")
+        buf += chunk
+    return buf
+
+
+def bench_channel(host, port, w, h, seconds):
+    sock = socket.create_connection((host, port), timeout=5.0)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    kind, _, credits, _ = struct.unpack("<BBHI", recv_exact(sock, 8))
+    if kind != ord("H"):
+        raise ConnectionError("expected hello, got %r" % chr(kind))
+
+    anim = Animation(w, h)
+    sent_at = []          # send time of every frame not yet credited
+    latencies = []
+    seq, shown = 0, 0
+    sent = resyncs = 0
+    t0 = time.time()
+    while time.time() - t0 < seconds:
+        while credits > 0:
+            seq += 1
+            body = anim.keyframe(seq) if shown == 0 else anim.delta(seq - 1, seq)
+            sock.sendall(struct.pack("<I", len(body)) + body)
+            sent_at.append(time.time())
+            credits -= 1
+            sent += 1
+            shown = seq
+        kind, _, n, dev_seq = struct.unpack("<BBHI", recv_exact(sock, 8))
+        now = time.time()
+        for t in sent_at[:n]:
+            latencies.append(now - t)
+        del sent_at[:n]
+        credits += n
+        if kind == ord("R"):
+            resyncs += 1
+            shown = 0     # next frame is a keyframe
+    dt = time.time() - t0
+    sock.close()
+    return {"sent": sent, "fps": sent / dt, "resyncs": resyncs, "latency": latencies}
+
+
+def post_frame(base, body):
+    boundary = uuid.uuid4().hex
+    data = (("--%s\r\nContent-Disposition: form-data; name=\"frame\"; filename=\"f.bin\"\r\n"
+             "Content-Type: application/octet-stream\r\n\r\n" % boundary).encode()
+            + body + ("\r\n--%s--\r\n" % boundary).encode())
+    req = urllib.request.Request(base + "/frame_delta", data=data, method="POST",
+                                 headers={"Content-Type": "multipart/form-data; boundary=" + boundary})
+    try:
+        with urllib.request.urlopen(req, timeout=5.0) as r:
+            return r.status, json.loads(r.read() or b"{}")
+    except urllib.error.HTTPError as e:
+        return e.code, {}
+
+
+def bench_http(host, w, h, seconds):
+    base = "http://" + host
+    anim = Animation(w, h)
+    latencies = []
+    seq, shown, sent, resyncs = 0, 0, 0, 0
+    t0 = time.time()
+    while time.time() - t0 < seconds:
+        seq += 1
+        body = anim.keyframe(seq) if shown == 0 else anim.delta(shown, seq)
+        ts = time.time()
+        status, _ = post_frame(base, body)
+        latencies.append(time.time() - ts)
+        sent += 1
+        if status == 409:
+            resyncs += 1
+            shown = 0
+        else:
+            shown = seq
+    dt = time.time() - t0
+    return {"sent": sent, "fps": sent / dt, "resyncs": resyncs, "latency": latencies}
+
+
+def emulator(listener, present_us):
+    """Device side of the channel: reads frames, coalesces, credits after each 'present'."""
+    conn, _ = listener.accept()
+    conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    conn.sendall(struct.pack("<BBHI", ord("H"), 0, 3, 0))
+    last_seq, last_push, pending = 0, 0.0, 0
+    conn.settimeout(0.001)
+    buf = b""
+    try:
+        while True:
+            try:
+                chunk = conn.recv(65536)
+                if not chunk:
+                    return
+                buf += chunk
+            except socket.timeout:
+                pass
+            while len(buf) >= 4:
+                n = struct.unpack_from("<I", buf)[0]
+                if len(buf) < 4 + n:
+                    break
+                _, _, _, flags, _, _, _, base, seq = struct.unpack_from("<2sBBBBHHII", buf, 4)
+                buf = buf[4 + n:]
+                if not flags & 1 and base != last_seq:
+                    conn.sendall(struct.pack("<BBHI", ord("R"), 0, 1, last_seq))
+                    last_seq = 0
+                    continue
+                last_seq = seq
+                pending += 1
+            now = time.time()
+            if pending and (now - last_push) * 1e6 >= present_us:
+                conn.sendall(struct.pack("<BBHI", ord("C"), 0, pending, last_seq))
+                pending, last_push = 0, now
+    except (ConnectionError, OSError):
+        return
+
+
+def report(name, r):
+    lat = sorted(r["latency"]) or [0.0]
+    pct = lambda p: lat[min(len(lat) - 1, int(p * len(lat)))] * 1000.0
+    print("%-8s %7.1f fps  %6d frames  %3d resyncs  latency p50 %6.1f ms  p99 %6.1f ms  max %6.1f ms"
+          % (name, r["fps"], r["sent"], r["resyncs"], pct(0.5), pct(0.99), lat[-1] * 1000.0))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="192.168.4.1")
+    ap.add_argument("--port", type=int, default=CHANNEL_PORT)
+    ap.add_argument("--width", type=int, default=0, help="frame width (default: panel width)")
+    ap.add_argument("--height", type=int, default=0, help="frame height (default: panel height)")
+    ap.add_argument("--seconds", type=float, default=10.0)
+    ap.add_argument("--loopback", action="store_true", help="run the channel against a local emulator")
+    ap.add_argument("--present-us", type=int, default=16000, help="emulated push interval")
+    args = ap.parse_args()
+
+    if args.loopback:
+        w, h = args.width or 128, args.height or 64
+        listener = socket.socket()
+        listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        listener.bind(("127.0.0.1", 0))
+        listener.listen(1)
+        threading.Thread(target=emulator, args=(listener, args.present_us), daemon=True).start()
+        print("loopback emulator, %dx%d, push every %d us" % (w, h, args.present_us))
+        report("channel", bench_channel("127.0.0.1", listener.getsockname()[1], w, h, args.seconds))
+        return
+
+    w, h = args.width, args.height
+    if not w or not h:
+        info = json.loads(urllib.request.urlopen("http://%s/panel_info" % args.host, timeout=5.0).read())
+        w, h = w or info["cols"] * PANEL_W, h or info["rows"] * PANEL_H
+    print("%s, %dx%d" % (args.host, w, h))
+    report("channel", bench_channel(args.host, args.port, w, h, args.seconds))
+    report("http", bench_http(args.host, w, h, args.seconds))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,125 @@
+// Host build of the firmware's HTTP server (include/http_server.h) for loopback load tests.
+//
+//     make http_host
+//     ./build/http_host --port 8080
+//     python3 tools/http_load_bench.py --loopback
+//
+// The routes stand in for the device's traffic: /ping is a small JSON reply like /panel_info,
+// /asset a 166 KB body like components/main.js, /stream a slow body produced over time like
+// /proxy_image, /upload a multipart sink like /upload, and /form echoes urlencoded args.
+// The main loop polls the server and sleeps 1 ms, as loop() does on the device.
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <memory>
+#include <string>
+#include "http_server.h"
+
+static const size_t ASSET_BYTES = 166 * 1024;
+static const size_t STREAM_BYTES = 64 * 1024;
+static const uint32_t STREAM_STEP_MS = 5;      // 1 KB every STREAM_STEP_MS
+
+static volatile bool gRun = true;
+static void onSignal(int) { gRun = false; }
+
+static void sleepMs(long ms) {
+  timespec ts = { 0, ms * 1000000L };
+  nanosleep(&ts, nullptr);
+}
+
+int main(int argc, char** argv) {
+  uint16_t port = 8080;
+  for (int i = 1; i + 1 < argc; ++i) if (!strcmp(argv[i], "--port")) port = (uint16_t)atoi(argv[i + 1]);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  std::shared_ptr<std::string> asset = std::make_shared<std::string>(ASSET_BYTES, 'a');
+  for (size_t i = 0; i < ASSET_BYTES; ++i) (*asset)[i] = (char)('a' + i % 26);
+  uint64_t uploadBytes = 0;
+  uint32_t uploadParts = 0;
+  uint32_t uploadHash = 2166136261u;           // FNV-1a 32 over all file bytes, to check framing
+  uint32_t uploadAborts = 0;                   // file parts that ended in ABORTED
+
+  HttpServer http;
+  http.on("/ping", HTTP_VERB_GET, [](HttpRequest&, HttpResponse& res) {
+    res.send(200, "application/json", "{\"pong\":true}");
+  });
+  http.on("/asset", HTTP_VERB_GET, [asset](HttpRequest&, HttpResponse& res) {
+    size_t pos = 0;
+    res.stream(200, "application/javascript", (long long)asset->size(), [asset, pos](uint8_t* buf, size_t cap) mutable -> long {
+      const size_t n = asset->size() - pos < cap ? asset->size() - pos : cap;
+      memcpy(buf, asset->data() + pos, n);
+      pos += n;
+      return (long)n;
+    });
+  });
+  http.on("/stream", HTTP_VERB_GET, [](HttpRequest&, HttpResponse& res) {
+    size_t sent = 0;
+    uint32_t next = httpNowMs();
+    res.stream(200, "application/octet-stream", -1, [sent, next](uint8_t* buf, size_t cap) mutable -> long {
+      if (sent >= STREAM_BYTES) return 0;
+      if ((int32_t)(httpNowMs() - next) < 0) return -1;   // the "remote" has nothing yet
+      next += STREAM_STEP_MS;
+      const size_t n = cap < 1024 ? cap : 1024;
+      memset(buf, 's', n);
+      sent += n;
+      return (long)n;
+    });
+  });
+  http.on("/upload", HTTP_VERB_POST,
+    [&](HttpRequest& req, HttpResponse& res) {
+      const std::string* tag = req.arg("tag");
+      res.send(200, "application/json", "{\"bytes\":" + std::to_string(uploadBytes) + ",\"parts\":" +
+               std::to_string(uploadParts) + ",\"fnv\":" + std::to_string(uploadHash) + ",\"tag\":\"" + (tag ? *tag : "") + "\"}");
+      uploadBytes = 0;
+      uploadParts = 0;
+      uploadHash = 2166136261u;
+    },
+    [&](HttpRequest&, HttpResponse&, const HttpUploadEvent& ev) {
+      if (ev.status == HTTP_UPLOAD_WRITE) {
+        uploadBytes += ev.len;
+        for (size_t i = 0; i < ev.len; ++i) uploadHash = (uploadHash ^ ev.data[i]) * 16777619u;
+      }
+      else if (ev.status == HTTP_UPLOAD_END) uploadParts++;
+      else if (ev.status == HTTP_UPLOAD_ABORTED) {
+        // Like the device, an aborted upload discards what it staged
+        uploadAborts++;
+        uploadBytes = 0;
+        uploadParts = 0;
+        uploadHash = 2166136261u;
+      }
+    });
+  http.on("/form", HTTP_VERB_POST | HTTP_VERB_GET, [](HttpRequest& req, HttpResponse& res) {
+    std::string json = "{";
+    for (size_t i = 0; i < req.args.size(); ++i) {
+      if (i) json += ",";
+      json += "\"" + req.args[i].first + "\":\"" + req.args[i].second + "\"";
+    }
+    json += "}";
+    res.send(200, "application/json", json);
+  });
+  http.on("/stats", HTTP_VERB_GET, [&http, &uploadAborts](HttpRequest&, HttpResponse& res) {
+    res.send(200, "application/json",
+             "{\"accepted\":" + std::to_string(http.accepted) + ",\"requests\":" + std::to_string(http.requests) +
+             ",\"reused\":" + std::to_string(http.reused) + ",\"evicted\":" + std::to_string(http.evicted) +
+             ",\"timeouts\":" + std::to_string(http.timeouts) + ",\"errors\":" + std::to_string(http.errors) +
+             ",\"active\":" + std::to_string(http.active) + ",\"peak\":" + std::to_string(http.peak) +
+             ",\"upload_aborts\":" + std::to_string(uploadAborts) + "}");
+  });
+  http.onNotFound([](HttpRequest& req, HttpResponse& res) { res.send(404, "text/plain", "Not found: " + req.path); });
+
+  if (!http.begin(port)) {
+    perror("http_host: listen");
+    return 1;
+  }
+  printf("http_host listening on 127.0.0.1:%u\n", http.port());
+  fflush(stdout);
+  while (gRun) {
+    if (!http.poll()) sleepMs(1);
+  }
+  http.stop();
+  return 0;
+}
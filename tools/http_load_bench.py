@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""
+Scroll pacing under HTTP load.
+
+Start a scrolling text on the panel from the web UI, then run:
+
+    python3 tools/http_load_bench.py --host 192.168.4.1 --seconds 20
+
+The script samples the render counters in /sys_info while the panel is idle,
+then again while worker threads hammer the HTTP endpoints, and prints the
+achieved frame rate, scroll speed and dropped frames for both phases.
+Scroll speed is time based, so px/s should match between the phases.
+
+The HTTP server itself can be load tested on a host, over loopback:
+
+    make http_host
+    python3 tools/http_load_bench.py --loopback --seconds 10
+
+This starts build/http_host (include/http_server.h with stand-in routes) and
+measures keep-alive /ping latency alone, then again while other clients pull
+large assets, slow streams and multipart uploads, and prints req/s and p50/p99.
+It also checks that multipart bodies missing their closing boundary are
+answered 400 and abort the upload handler instead of reaching the route.
+"""
+
+import argparse
+import http.client
+import json
+import os
+import subprocess
+import threading
+import time
+import urllib.request
+
+ENDPOINTS = ["/", "/panel_info", "/sys_info", "/wifi_status", "/theme_status", "/components/main.js"]
+
+
+def get(url, timeout=5.0):
+    with urllib.request.urlopen(url, timeout=timeout) as r:
+        return r.read()
+
+
+def sys_info(base):
+    return json.loads(get(base + "/sys_info"))
+
+
+def measure(base, seconds):
+    a = sys_info(base)
+    t0 = time.time()
+    time.sleep(seconds)
+    b = sys_info(base)
+    dt = time.time() - t0
+    frames = b["frames_rendered"] - a["frames_rendered"]
+    dropped = b["frames_dropped"] - a["frames_dropped"]
+    scrolled = b.get("scroll_px", 0) - a.get("scroll_px", 0)
+    return {
+        "fps": frames / dt,
+        "target_fps": 1000.0 / b["render_period_ms"] if b.get("render_period_ms") else 0.0,
+        "dropped": dropped,
+        "px_per_s": scrolled / dt,
+        "max_gap_ms": b["max_frame_gap_us"] / 1000.0,
+    }
+
+
+def hammer(base, stop, stats):
+    i = 0
+    while not stop.is_set():
+        path = ENDPOINTS[i % len(ENDPOINTS)]
+        i += 1
+        try:
+            get(base + path)
+            stats["ok"] += 1
+        except Exception:
+            stats["err"] += 1
+
+
+# ---- Loopback: the host build of the server ----
+
+UPLOAD_BYTES = 256 * 1024
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p))]
+
+
+def probe(port, stop, lat, errors):
+    """Keep-alive /ping requests on one connection, as a UI polling the panel does."""
+    conn = http.client.HTTPConnection("127.0.0.1", port, timeout=10)
+    while not stop.is_set():
+        t0 = time.perf_counter()
+        try:
+            conn.request("GET", "/ping")
+            r = conn.getresponse()
+            r.read()
+            if r.status != 200:
+                raise IOError(r.status)
+            lat.append((time.perf_counter() - t0) * 1000.0)
+        except Exception:
+            errors.append(1)
+            conn.close()
+            conn = http.client.HTTPConnection("127.0.0.1", port, timeout=10)
+    conn.close()
+
+
+def bulk(port, stop, kind, done, errors):
+    """Large or slow transfers that would hold a blocking server for their whole duration."""
+    conn = http.client.HTTPConnection("127.0.0.1", port, timeout=10)
+    boundary = "loopbackbench"
+    body = (("--%s\r\nContent-Disposition: form-data; name=\"file\"; filename=\"blob.bin\"\r\n"
+             "Content-Type: application/octet-stream\r\n\r\n" % boundary).encode()
+            + os.urandom(UPLOAD_BYTES) + ("\r\n--%s--\r\n" % boundary).encode())
+    while not stop.is_set():
+        try:
+            if kind == "upload":
+                conn.request("POST", "/upload", body, {"Content-Type": "multipart/form-data; boundary=" + boundary})
+            else:
+                conn.request("GET", "/" + kind)
+            r = conn.getresponse()
+            r.read()
+            if r.status != 200:
+                raise IOError(r.status)
+            done[kind] = done.get(kind, 0) + 1
+        except Exception:
+            errors.append(1)
+            conn.close()
+            conn = http.client.HTTPConnection("127.0.0.1", port, timeout=10)
+    conn.close()
+
+
+def post_upload(port, body, boundary="loopbackbench"):
+    conn = http.client.HTTPConnection("127.0.0.1", port, timeout=10)
+    try:
+        conn.request("POST", "/upload", body, {"Content-Type": "multipart/form-data; boundary=" + boundary})
+        r = conn.getresponse()
+        return r.status, r.read()
+    finally:
+        conn.close()
+
+
+def malformed_uploads(port):
+    """Truncated and boundary-less multipart bodies: 400, and an open file part is aborted."""
+    base = "http://127.0.0.1:%d" % port
+    part = ("--loopbackbench\r\nContent-Disposition: form-data; name=\"file\"; filename=\"blob.bin\"\r\n"
+            "Content-Type: application/octet-stream\r\n\r\n").encode() + os.urandom(4096)
+    aborts0 = json.loads(get(base + "/stats"))["upload_aborts"]
+    truncated, _ = post_upload(port, part)
+    no_boundary, _ = post_upload(port, os.urandom(4096))
+    aborts = json.loads(get(base + "/stats"))["upload_aborts"] - aborts0
+    # The next well-formed upload only reports its own bytes
+    status, reply = post_upload(port, part + b"\r\n--loopbackbench--\r\n")
+    after = json.loads(reply) if status == 200 else {}
+    ok = (truncated == 400 and no_boundary == 400 and aborts == 1 and
+          after.get("bytes") == 4096 and after.get("parts") == 1)
+    return {"truncated": truncated, "no_boundary": no_boundary, "aborts": aborts, "ok": ok}
+
+
+def run_phase(port, seconds, probes, load):
+    stop = threading.Event()
+    lat, errors, done = [], [], {}
+    threads = [threading.Thread(target=probe, args=(port, stop, lat, errors), daemon=True) for _ in range(probes)]
+    threads += [threading.Thread(target=bulk, args=(port, stop, kind, done, errors), daemon=True) for kind in load]
+    for t in threads:
+        t.start()
+    time.sleep(seconds)
+    stop.set()
+    for t in threads:
+        t.join(timeout=15)
+    return {
+        "rps": len(lat) / seconds,
+        "p50": percentile(lat, 0.50),
+        "p99": percentile(lat, 0.99),
+        "max": max(lat) if lat else 0.0,
+        "errors": len(errors),
+        "bulk": done,
+    }
+
+
+def loopback(args):
+    binary = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "build", "http_host")
+    if not os.path.exists(binary):
+        raise SystemExit("build/http_host not found; run `make http_host` first")
+    server = subprocess.Popen([binary, "--port", str(args.port)], stdout=subprocess.PIPE)
+    try:
+        server.stdout.readline()  # "listening" once the socket is bound
+        base = "http://127.0.0.1:%d" % args.port
+        idle = run_phase(args.port, args.seconds, args.probes, [])
+        loaded = run_phase(args.port, args.seconds, args.probes, ["asset", "stream", "upload"])
+        malformed = malformed_uploads(args.port)
+        stats = json.loads(get(base + "/stats"))
+    finally:
+        server.terminate()
+        server.wait(timeout=5)
+
+    print("phase   req/s    p50_ms  p99_ms  max_ms  errors")
+    for name, m in (("idle", idle), ("loaded", loaded)):
+        print("%-7s %-8.0f %-7.2f %-7.2f %-7.2f %d" % (name, m["rps"], m["p50"], m["p99"], m["max"], m["errors"]))
+    print("bulk while loaded: " + ", ".join("%s=%d" % kv for kv in sorted(loaded["bulk"].items())))
+    print("server: accepted=%d requests=%d reused=%d peak=%d timeouts=%d errors=%d" % (
+        stats["accepted"], stats["requests"], stats["reused"], stats["peak"], stats["timeouts"], stats["errors"]))
+    print("malformed uploads: truncated=%d no_boundary=%d aborts=%d %s" % (
+        malformed["truncated"], malformed["no_boundary"], malformed["aborts"], "ok" if malformed["ok"] else "FAILED"))
+    if not malformed["ok"]:
+        raise SystemExit(1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="192.168.4.1")
+    ap.add_argument("--seconds", type=float, default=15.0)
+    ap.add_argument("--workers", type=int, default=4)
+    ap.add_argument("--loopback", action="store_true", help="load test build/http_host instead of a panel")
+    ap.add_argument("--port", type=int, default=18090, help="loopback port")
+    ap.add_argument("--probes", type=int, default=2, help="loopback /ping connections")
+    args = ap.parse_args()
+    if args.loopback:
+        loopback(args)
+        return
+    base = "http://" + args.host
+
+    idle = measure(base, args.seconds)
+
+    stop = threading.Event()
+    stats = {"ok": 0, "err": 0}
+    threads = [threading.Thread(target=hammer, args=(base, stop, stats), daemon=True) for _ in range(args.workers)]
+    for t in threads:
+        t.start()
+    try:
+        loaded = measure(base, args.seconds)
+    finally:
+        stop.set()
+        for t in threads:
+            t.join(timeout=10)
+
+    print("phase   fps     target  px/s    dropped  max_gap_ms")
+    for name, m in (("idle", idle), ("loaded", loaded)):
+        print("%-7s %-7.1f %-7.1f %-7.1f %-8d %.2f" % (name, m["fps"], m["target_fps"], m["px_per_s"], m["dropped"], m["max_gap_ms"]))
+    print("requests: ok=%d err=%d (%.1f req/s)" % (stats["ok"], stats["err"], stats["ok"] / args.seconds))
+
+
+if __name__ == "__main__":
+    main()